@@ -7,12 +7,14 @@
 // -----------------------------------------------------------------------------
 
 #include <functional>
-#include <sstream>
+#include <memory>
 #include <string>
 // windows compatibility includes
 #include <algorithm>
 #include <cctype>
 
+#include "maddy/outputbuffer.h"
+
 // -----------------------------------------------------------------------------
 
 namespace maddy {
@@ -44,8 +46,7 @@ public:
     std::function<std::shared_ptr<BlockParser>(const std::string& line)>
       getBlockParserForLineCallback
   )
-    : result("", std::ios_base::ate | std::ios_base::in | std::ios_base::out)
-    , childParser(nullptr)
+    : childParser(nullptr)
     , parseLineCallback(parseLineCallback)
     , getBlockParserForLineCallback(getBlockParserForLineCallback)
   {}
@@ -81,7 +82,7 @@ public:
 
       if (this->childParser->IsFinished())
       {
-        this->result << this->childParser->GetResult().str();
+        this->result << this->childParser->GetResult();
         this->childParser = nullptr;
       }
 
@@ -106,30 +107,65 @@ public:
    */
   virtual bool IsFinished() const = 0;
 
+  /**
+   * SetOutput
+   *
+   * Let the parser append its HTML output directly to `output`.
+   *
+   * @method
+   * @param {OutputBuffer&} output
+   * @return {void}
+   */
+  void SetOutput(OutputBuffer& output) { this->result.Attach(output); }
+
   /**
    * GetResult
    *
-   * Get the parsed HTML output.
+   * Get the parsed HTML output. The output of a child parser, that did not
+   * finish, is not part of it.
+   *
+   * @method
+   * @return {const OutputBuffer&}
+   */
+  const OutputBuffer& GetResult()
+  {
+    if (this->childParser)
+    {
+      this->childParser->DiscardResult();
+    }
+
+    return this->result;
+  }
+
+  /**
+   * DiscardResult
+   *
+   * Drop the output of an unfinished parser and of its children.
    *
    * @method
-   * @return {std::stringstream}
+   * @return {void}
    */
-  std::stringstream& GetResult() { return this->result; }
+  void DiscardResult() { this->result.Discard(); }
 
   /**
    * Clear
    *
-   * Clear the result to reuse the parser object.
+   * Clear the result and the parsing state to reuse the parser object.
    *
-   * It is only used by one test for now.
+   * Children, that have own state, have to override it and call the base
+   * implementation.
    *
    * @method
    * @return {void}
    */
-  void Clear() { this->result.str(""); }
+  virtual void Clear()
+  {
+    this->result.Clear();
+    this->childParser = nullptr;
+  }
 
 protected:
-  std::stringstream result;
+  OutputBuffer result;
   std::shared_ptr<BlockParser> childParser;
 
   virtual bool isInlineBlockAllowed() const = 0;
@@ -144,6 +180,22 @@ protected:
     }
   }
 
+  /**
+   * isSingleLineFrom
+   *
+   * Hand-coded equivalent of a trailing `.*` in a fully matched regex: true, if
+   * there is no `\r` or `\n` from `pos` on.
+   *
+   * @method
+   * @param {const std::string&} line
+   * @param {size_t} pos
+   * @return {bool}
+   */
+  static bool isSingleLineFrom(const std::string& line, size_t pos)
+  {
+    return line.find_first_of("\r\n", pos) == std::string::npos;
+  }
+
   uint32_t getIndentationWidth(const std::string& line) const
   {
     bool hasMetNonSpace = false;
@@ -175,7 +227,14 @@ protected:
   {
     if (getBlockParserForLineCallback)
     {
-      return getBlockParserForLineCallback(line);
+      std::shared_ptr<BlockParser> parser = getBlockParserForLineCallback(line);
+
+      if (parser)
+      {
+        parser->SetOutput(this->result);
+      }
+
+      return parser;
     }
 
     return nullptr;
@@ -47,7 +47,7 @@ public:
   /**
    * IsStartingLine
    *
-   * An unordered list starts with `* `.
+   * A checklist starts with `- [ ] ` or `- [x] `.
    *
    * @method
    * @param {const std::string&} line
@@ -55,8 +55,25 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re(R"(^- \[[x| ]\] .*)");
-    return std::regex_match(line, re);
+    // ^- \[[x| ]\] .*
+    return line.size() >= 6 && line.compare(0, 3, "- [") == 0 &&
+           (line[3] == 'x' || line[3] == '|' || line[3] == ' ') &&
+           line.compare(4, 2, "] ") == 0 && isSingleLineFrom(line, 6);
+  }
+
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
   }
 
   /**
@@ -77,8 +77,10 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^(?:#){1,6} (.*)");
-    return std::regex_match(line, re);
+    // ^(?:#){1,6} (.*)
+    const size_t level = line.find_first_not_of('#');
+    return level >= 1 && level <= 6 && line[level] == ' ' &&
+           isSingleLineFrom(line, level + 1);
   }
 
   /**
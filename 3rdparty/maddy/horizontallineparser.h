@@ -58,8 +58,8 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^---$");
-    return std::regex_match(line, re);
+    // ^---$
+    return line == "---";
   }
 
   /**
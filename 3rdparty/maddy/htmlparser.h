@@ -56,6 +56,22 @@ public:
    */
   static bool IsStartingLine(const std::string& line) { return line[0] == '<'; }
 
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
+    this->isGreaterThanFound = false;
+  }
+
   /**
    * IsFinished
    *
@@ -0,0 +1,514 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "maddy/lineparser.h"
+#include "maddy/parserconfig.h"
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * InlineParser
+ *
+ * Hand-written replacement for the regex based line parsers (`ImageParser`,
+ * `LinkParser`, `StrongParser`, `EmphasizedParser`, `StrikeThroughParser`,
+ * `InlineCodeParser`, `ItalicParser` and `BreakLineParser`).
+ *
+ * It produces exactly the same HTML: the rules are applied in the same order
+ * and with the same matching semantics as the regular expressions, including
+ * the "no inline code later in the line" look-aheads. But every rule is a
+ * single linear scan without any backtracking, so the run time is O(n) per
+ * line, even for adversarial input.
+ *
+ * @class
+ */
+class InlineParser : public LineParser
+{
+public:
+  /**
+   * ctor
+   *
+   * @method
+   * @param {uint32_t} enabledParsers `maddy::types::PARSER_TYPE` flags, only
+   * the rules of the enabled line parsers are applied
+   */
+  InlineParser(uint32_t enabledParsers = maddy::types::DEFAULT)
+    : enabledParsers(enabledParsers)
+  {}
+
+  /**
+   * Parse
+   *
+   * From Markdown to HTML
+   *
+   * @method
+   * @param {std::string&} line The line to interpret
+   * @return {void}
+   */
+  void Parse(std::string& line) override
+  {
+    // Attention! images have to be parsed before links
+    if (this->isEnabled(maddy::types::IMAGE_PARSER))
+    {
+      this->parseImages(line);
+    }
+
+    if (this->isEnabled(maddy::types::LINK_PARSER))
+    {
+      this->parseLinks(line, true);
+      this->parseLinks(line, false);
+    }
+
+    // Attention! strong has to be parsed before emphasized
+    if (this->isEnabled(maddy::types::STRONG_PARSER))
+    {
+      this->parseEnclosed(line, "**", '*', "<strong>", "</strong>", true);
+      this->parseEnclosed(line, "__", '_', "<strong>", "</strong>", true);
+    }
+
+    if (this->isEnabled(maddy::types::EMPHASIZED_PARSER))
+    {
+      this->parseEnclosed(line, "_", '_', "<em>", "</em>", true);
+    }
+
+    if (this->isEnabled(maddy::types::STRIKETHROUGH_PARSER))
+    {
+      this->parseEnclosed(line, "~~", '~', "<s>", "</s>", true);
+    }
+
+    if (this->isEnabled(maddy::types::INLINE_CODE_PARSER))
+    {
+      this->parseEnclosed(line, "`", '`', "<code>", "</code>", false);
+    }
+
+    if (this->isEnabled(maddy::types::ITALIC_PARSER))
+    {
+      this->parseEnclosed(line, "*", '*', "<i>", "</i>", true);
+    }
+
+    if (this->isEnabled(maddy::types::BREAKLINE_PARSER))
+    {
+      this->parseBreakLines(line);
+    }
+  }
+
+private:
+  uint32_t enabledParsers;
+  std::string output;
+  // look-ahead tables, see `updateCodeLookAhead()`
+  std::vector<bool> codeStartFollows;
+  std::vector<bool> codeEndFollows;
+  // position tables for images and links, see `updatePositions()`
+  std::vector<size_t> nextClosingBracket;
+  std::vector<size_t> nextNonSpace;
+  std::vector<size_t> nextUrlEnd;
+  std::vector<size_t> nextQuote;
+  std::vector<size_t> lastClosingParenthesis;
+
+  bool isEnabled(uint32_t parserType) const
+  {
+    return (this->enabledParsers & parserType) != 0;
+  }
+
+  static bool isLineTerminator(char c) { return c == '\n' || c == '\r'; }
+
+  /**
+   * updateCodeLookAhead
+   *
+   * Emulates the `(?!.*`.*|.*<code>.*)` and `(?!.*`.*|.*<\/code>.*)`
+   * look-aheads: for every position it is precomputed, if a backtick or
+   * `<code>` (respectively `</code>`) follows before the end of the line. Like
+   * the regex `.`, the look-ahead doesn't extend past `\r` or `\n`.
+   *
+   * @method
+   * @param {const std::string&} line
+   * @return {void}
+   */
+  void updateCodeLookAhead(const std::string& line)
+  {
+    const size_t size = line.size();
+    this->codeStartFollows.assign(size + 1, false);
+    this->codeEndFollows.assign(size + 1, false);
+
+    for (size_t i = size; i-- > 0;)
+    {
+      if (isLineTerminator(line[i]))
+      {
+        continue;
+      }
+
+      const bool isBacktick = line[i] == '`';
+      this->codeStartFollows[i] = this->codeStartFollows[i + 1] ||
+                                  isBacktick ||
+                                  line.compare(i, 6, "<code>") == 0;
+      this->codeEndFollows[i] = this->codeEndFollows[i + 1] || isBacktick ||
+                                line.compare(i, 7, "</code>") == 0;
+    }
+  }
+
+  /**
+   * updatePositions
+   *
+   * Precomputes for every position the next occurrence (at or after it) of the
+   * characters, that end the parts of images and links, and the last `)`
+   * before it (`npos` if there is none). This way no part of a line is scanned
+   * more than once, regardless of how many candidates share it.
+   *
+   * @method
+   * @param {const std::string&} line
+   * @return {void}
+   */
+  void updatePositions(const std::string& line)
+  {
+    const size_t size = line.size();
+    this->nextClosingBracket.assign(size + 1, std::string::npos);
+    this->nextNonSpace.assign(size + 1, std::string::npos);
+    this->nextUrlEnd.assign(size + 1, std::string::npos);
+    this->nextQuote.assign(size + 1, std::string::npos);
+    this->lastClosingParenthesis.assign(size + 1, std::string::npos);
+
+    for (size_t i = size; i-- > 0;)
+    {
+      const char c = line[i];
+      this->nextClosingBracket[i] =
+        c == ']' ? i : this->nextClosingBracket[i + 1];
+      this->nextNonSpace[i] = c != ' ' ? i : this->nextNonSpace[i + 1];
+      this->nextUrlEnd[i] = (c == ')' || c == '^' || c == ' ' || c == '"')
+                              ? i
+                              : this->nextUrlEnd[i + 1];
+      this->nextQuote[i] = c == '"' ? i : this->nextQuote[i + 1];
+    }
+
+    for (size_t i = 0; i < size; ++i)
+    {
+      this->lastClosingParenthesis[i + 1] =
+        line[i] == ')' ? i : this->lastClosingParenthesis[i];
+    }
+  }
+
+  /**
+   * parseEnclosed
+   *
+   * Replaces `<delimiter>text<delimiter>` where `text` doesn't contain
+   * `excluded`, e.g. `**text**` with `<strong>text</strong>`.
+   *
+   * With `isCodeAware`, the delimiters and the text must not be followed by
+   * inline code (see `updateCodeLookAhead()`).
+   *
+   * @method
+   * @param {std::string&} line
+   * @param {const std::string&} delimiter
+   * @param {char} excluded
+   * @param {const char*} openingTag
+   * @param {const char*} closingTag
+   * @param {bool} isCodeAware
+   * @return {void}
+   */
+  void parseEnclosed(
+    std::string& line,
+    const std::string& delimiter,
+    char excluded,
+    const char* openingTag,
+    const char* closingTag,
+    bool isCodeAware
+  )
+  {
+    if (line.find(delimiter) == std::string::npos)
+    {
+      return;
+    }
+
+    if (isCodeAware)
+    {
+      this->updateCodeLookAhead(line);
+    }
+
+    const size_t size = line.size();
+    const size_t delimiterSize = delimiter.size();
+    this->output.clear();
+
+    size_t i = 0;
+    while (i < size)
+    {
+      if (line.compare(i, delimiterSize, delimiter) == 0 &&
+          (!isCodeAware || (!this->codeStartFollows[i] &&
+                            !this->codeEndFollows[i + delimiterSize])))
+      {
+        const size_t textStart = i + delimiterSize;
+        const size_t textEnd = line.find(excluded, textStart);
+
+        if (textEnd != std::string::npos &&
+            line.compare(textEnd, delimiterSize, delimiter) == 0 &&
+            (!isCodeAware || !this->codeEndFollows[textEnd + delimiterSize]))
+        {
+          this->output += openingTag;
+          this->output.append(line, textStart, textEnd - textStart);
+          this->output += closingTag;
+          i = textEnd + delimiterSize;
+          continue;
+        }
+
+        if (textEnd == std::string::npos)
+        {
+          // there is no closing delimiter anywhere further on
+          break;
+        }
+      }
+
+      this->output += line[i];
+      ++i;
+    }
+
+    this->output.append(line, i, std::string::npos);
+    line.swap(this->output);
+  }
+
+  /**
+   * parseImages
+   *
+   * From Markdown: `![text](http://example.com/a.png)`
+   *
+   * To HTML: `<img src="http://example.com/a.png" alt="text"/>`
+   *
+   * @method
+   * @param {std::string&} line
+   * @return {void}
+   */
+  void parseImages(std::string& line)
+  {
+    if (line.find("![") == std::string::npos)
+    {
+      return;
+    }
+
+    this->updatePositions(line);
+
+    const size_t size = line.size();
+    this->output.clear();
+
+    size_t i = 0;
+    while (i < size)
+    {
+      if (line[i] == '!' && i + 1 < size && line[i + 1] == '[')
+      {
+        // the text ends at the first `]`, the source at the last `)` before
+        // the next `]`
+        const size_t textEnd = this->nextClosingBracket[i + 2];
+        if (textEnd != std::string::npos && textEnd + 1 < size &&
+            line[textEnd + 1] == '(')
+        {
+          const size_t sourceStart = textEnd + 2;
+          const size_t sourceLimit = this->nextClosingBracket[sourceStart];
+          const size_t sourceEnd = this->lastClosingParenthesis
+            [sourceLimit == std::string::npos ? size : sourceLimit];
+
+          if (sourceEnd != std::string::npos && sourceEnd >= sourceStart)
+          {
+            this->output += "<img src=\"";
+            this->output.append(line, sourceStart, sourceEnd - sourceStart);
+            this->output += "\" alt=\"";
+            this->output.append(line, i + 2, textEnd - i - 2);
+            this->output += "\"/>";
+            i = sourceEnd + 1;
+            continue;
+          }
+        }
+      }
+
+      this->output += line[i];
+      ++i;
+    }
+
+    line.swap(this->output);
+  }
+
+  /**
+   * parseLinks
+   *
+   * From Markdown: `[text](http://example.com)`
+   * or `[text](http://example.com "title")` if `withTitle` is set
+   *
+   * To HTML: `<a href="http://example.com">text</a>`
+   * or `<a href="http://example.com" title="title">text</a>`
+   *
+   * @method
+   * @param {std::string&} line
+   * @param {bool} withTitle
+   * @return {void}
+   */
+  void parseLinks(std::string& line, bool withTitle)
+  {
+    if (line.find("](") == std::string::npos)
+    {
+      return;
+    }
+
+    this->updatePositions(line);
+
+    const size_t size = line.size();
+    this->output.clear();
+
+    // every `[` before the same `]` shares the same remainder of the match
+    size_t failedTextEnd = std::string::npos;
+
+    size_t i = 0;
+    while (i < size)
+    {
+      const size_t textEnd =
+        line[i] == '[' ? this->nextClosingBracket[i + 1] : std::string::npos;
+
+      if (textEnd != std::string::npos && textEnd != failedTextEnd)
+      {
+        size_t urlStart = 0;
+        size_t urlEnd = 0;
+        size_t titleStart = 0;
+        size_t titleEnd = 0;
+        const size_t linkEnd = this->matchLinkDestination(
+          line, textEnd + 1, withTitle, urlStart, urlEnd, titleStart, titleEnd
+        );
+
+        if (linkEnd != std::string::npos)
+        {
+          this->output += "<a href=\"";
+          this->output.append(line, urlStart, urlEnd - urlStart);
+          if (withTitle)
+          {
+            this->output += "\" title=\"";
+            this->output.append(line, titleStart, titleEnd - titleStart);
+          }
+          this->output += "\">";
+          this->output.append(line, i + 1, textEnd - i - 1);
+          this->output += "</a>";
+          i = linkEnd;
+          continue;
+        }
+
+        failedTextEnd = textEnd;
+      }
+
+      this->output += line[i];
+      ++i;
+    }
+
+    line.swap(this->output);
+  }
+
+  /**
+   * matchLinkDestination
+   *
+   * Matches `( *url *)` or `( *url *"title" *)` at `pos`, where the url
+   * doesn't contain `)`, `^`, ` ` or `"`.
+   *
+   * @method
+   * @return {size_t} the position after the match or `npos`
+   */
+  size_t matchLinkDestination(
+    const std::string& line,
+    size_t pos,
+    bool withTitle,
+    size_t& urlStart,
+    size_t& urlEnd,
+    size_t& titleStart,
+    size_t& titleEnd
+  ) const
+  {
+    if (pos >= line.size() || line[pos] != '(')
+    {
+      return std::string::npos;
+    }
+
+    urlStart = this->nextNonSpace[pos + 1];
+    if (urlStart == std::string::npos)
+    {
+      return std::string::npos;
+    }
+
+    urlEnd = this->nextUrlEnd[urlStart];
+    if (urlEnd == std::string::npos)
+    {
+      return std::string::npos;
+    }
+
+    pos = this->nextNonSpace[urlEnd];
+    if (pos == std::string::npos)
+    {
+      return std::string::npos;
+    }
+
+    if (withTitle)
+    {
+      if (line[pos] != '"')
+      {
+        return std::string::npos;
+      }
+
+      titleStart = pos + 1;
+      titleEnd = this->nextQuote[titleStart];
+      if (titleEnd == std::string::npos)
+      {
+        return std::string::npos;
+      }
+
+      pos = this->nextNonSpace[titleEnd + 1];
+      if (pos == std::string::npos)
+      {
+        return std::string::npos;
+      }
+    }
+
+    return line[pos] == ')' ? pos + 1 : std::string::npos;
+  }
+
+  /**
+   * parseBreakLines
+   *
+   * From Markdown: `text\r\n text`
+   *
+   * To HTML: `text<br> text`
+   *
+   * @method
+   * @param {std::string&} line
+   * @return {void}
+   */
+  void parseBreakLines(std::string& line)
+  {
+    if (line.find('\r') == std::string::npos)
+    {
+      return;
+    }
+
+    this->output.clear();
+    for (size_t i = 0; i < line.size(); ++i)
+    {
+      if (line[i] != '\r')
+      {
+        this->output += line[i];
+        continue;
+      }
+
+      this->output += "<br>";
+      if (i + 1 < line.size() && line[i + 1] == '\n')
+      {
+        ++i;
+      }
+    }
+
+    line.swap(this->output);
+  }
+}; // class InlineParser
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
@@ -79,8 +79,23 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re(R"(^(?:\$){2}(.*)$)");
-    return std::regex_match(line, re);
+    // ^(?:\$){2}(.*)$
+    return line.compare(0, 2, "$$") == 0 && isSingleLineFrom(line, 2);
+  }
+
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
   }
 
   /**
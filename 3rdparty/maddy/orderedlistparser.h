@@ -55,8 +55,23 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^1\\. .*");
-    return std::regex_match(line, re);
+    // ^1\. .*
+    return line.compare(0, 3, "1. ") == 0 && isSingleLineFrom(line, 3);
+  }
+
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
   }
 
   /**
@@ -0,0 +1,172 @@
+/*
+ * This project is licensed under the MIT license. For more information see the
+ * LICENSE file.
+ */
+#pragma once
+
+// -----------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string>
+#include <string_view>
+
+// -----------------------------------------------------------------------------
+
+namespace maddy {
+
+// -----------------------------------------------------------------------------
+
+/**
+ * OutputBuffer
+ *
+ * Growable HTML output of a `BlockParser`.
+ *
+ * A buffer either owns its storage or is attached to the storage of another
+ * buffer. An attached buffer appends directly behind everything that was
+ * written to the storage before it got attached, so nested block parsers all
+ * write into the same string and the output of a finished child does not have
+ * to be copied into its parent.
+ *
+ * @class
+ */
+class OutputBuffer
+{
+public:
+  /**
+   * ctor
+   *
+   * @method
+   */
+  OutputBuffer()
+    : storage(&this->ownStorage)
+    , start(0)
+  {}
+
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  /**
+   * Attach
+   *
+   * Write into the storage of `parent` from now on. Anything written before is
+   * dropped.
+   *
+   * @method
+   * @param {OutputBuffer&} parent
+   * @return {void}
+   */
+  void Attach(OutputBuffer& parent)
+  {
+    this->ownStorage.clear();
+    this->storage = parent.storage;
+    this->start = this->storage->size();
+  }
+
+  /**
+   * Discard
+   *
+   * Remove everything written to this buffer and detach it from the storage of
+   * its parent.
+   *
+   * @method
+   * @return {void}
+   */
+  void Discard()
+  {
+    if (this->storage != &this->ownStorage)
+    {
+      this->storage->resize(this->start);
+    }
+
+    this->Clear();
+  }
+
+  /**
+   * Clear
+   *
+   * Detach the buffer and clear its own storage, the capacity is kept. The
+   * storage of the parent is not touched, as it might not exist anymore.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear()
+  {
+    this->ownStorage.clear();
+    this->storage = &this->ownStorage;
+    this->start = 0;
+  }
+
+  /**
+   * View
+   *
+   * The view is invalidated by writing to the storage.
+   *
+   * @method
+   * @return {std::string_view}
+   */
+  std::string_view View() const
+  {
+    return std::string_view(*this->storage).substr(this->start);
+  }
+
+  /**
+   * str
+   *
+   * @method
+   * @return {std::string}
+   */
+  std::string str() const { return std::string(this->View()); }
+
+  /**
+   * Release
+   *
+   * Move the content out of the buffer, if it owns its storage.
+   *
+   * @method
+   * @return {std::string}
+   */
+  std::string Release()
+  {
+    std::string content = this->storage == &this->ownStorage
+                            ? std::move(this->ownStorage)
+                            : this->str();
+    this->Clear();
+    return content;
+  }
+
+  OutputBuffer& operator<<(std::string_view text)
+  {
+    this->storage->append(text);
+    return *this;
+  }
+
+  /**
+   * operator<<
+   *
+   * Hand the output of a finished child over. If the child was attached to
+   * this buffer, its output is already in place.
+   *
+   * @method
+   * @param {const OutputBuffer&} child
+   * @return {OutputBuffer&}
+   */
+  OutputBuffer& operator<<(const OutputBuffer& child)
+  {
+    if (child.storage != this->storage)
+    {
+      this->storage->append(child.View());
+    }
+
+    return *this;
+  }
+
+private:
+  std::string ownStorage;
+  std::string* storage;
+  size_t start;
+}; // class OutputBuffer
+
+// -----------------------------------------------------------------------------
+
+} // namespace maddy
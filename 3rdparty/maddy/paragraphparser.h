@@ -58,6 +58,21 @@ public:
    */
   static bool IsStartingLine(const std::string& line) { return !line.empty(); }
 
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
+  }
+
   /**
    * IsFinished
    *
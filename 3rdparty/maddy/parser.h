@@ -6,9 +6,11 @@
 
 // -----------------------------------------------------------------------------
 
+#include <array>
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "maddy/parserconfig.h"
 
@@ -30,6 +32,7 @@
 #include "maddy/emphasizedparser.h"
 #include "maddy/imageparser.h"
 #include "maddy/inlinecodeparser.h"
+#include "maddy/inlineparser.h"
 #include "maddy/italicparser.h"
 #include "maddy/linkparser.h"
 #include "maddy/strikethroughparser.h"
@@ -46,6 +49,9 @@ namespace maddy {
  *
  * Transforms Markdown to HTML
  *
+ * The parser can be reused for any number of documents, its block parsers are
+ * pooled. It must not be used by multiple threads at the same time.
+ *
  * @class
  */
 class Parser
@@ -66,12 +72,21 @@ public:
   /**
    * ctor
    *
-   * Initializes all `LineParser`
+   * Initializes the `InlineParser` or, if enabled in the config, all the
+   * regex based `LineParser`
    *
    * @method
    */
   Parser(std::shared_ptr<ParserConfig> config = nullptr) : config(config)
   {
+    if (!this->config || !this->config->isRegexInlineParsingEnabled)
+    {
+      this->inlineParser = std::make_shared<InlineParser>(
+        this->config ? this->config->enabledParsers : maddy::types::DEFAULT
+      );
+      return;
+    }
+
     if (!this->config ||
         (this->config->enabledParsers & maddy::types::BREAKLINE_PARSER) != 0)
     {
@@ -121,6 +136,9 @@ public:
     }
   }
 
+  Parser(const Parser&) = delete;
+  Parser& operator=(const Parser&) = delete;
+
   /**
    * Parse
    *
@@ -130,7 +148,7 @@ public:
    */
   std::string Parse(std::istream& markdown) const
   {
-    std::string result = "";
+    OutputBuffer result;
     std::shared_ptr<BlockParser> currentBlockParser = nullptr;
 
     for (std::string line; std::getline(markdown, line);)
@@ -138,6 +156,11 @@ public:
       if (!currentBlockParser)
       {
         currentBlockParser = getBlockParserForLine(line);
+
+        if (currentBlockParser)
+        {
+          currentBlockParser->SetOutput(result);
+        }
       }
 
       if (currentBlockParser)
@@ -146,7 +169,7 @@ public:
 
         if (currentBlockParser->IsFinished())
         {
-          result += currentBlockParser->GetResult().str();
+          result << currentBlockParser->GetResult();
           currentBlockParser = nullptr;
         }
       }
@@ -159,16 +182,21 @@ public:
       currentBlockParser->AddLine(emptyLine);
       if (currentBlockParser->IsFinished())
       {
-        result += currentBlockParser->GetResult().str();
+        result << currentBlockParser->GetResult();
         currentBlockParser = nullptr;
       }
+      else
+      {
+        currentBlockParser->DiscardResult();
+      }
     }
 
-    return result;
+    return result.Release();
   }
 
 private:
   std::shared_ptr<ParserConfig> config;
+  std::shared_ptr<InlineParser> inlineParser;
   std::shared_ptr<BreakLineParser> breakLineParser;
   std::shared_ptr<EmphasizedParser> emphasizedParser;
   std::shared_ptr<ImageParser> imageParser;
@@ -178,9 +206,61 @@ private:
   std::shared_ptr<StrikeThroughParser> strikeThroughParser;
   std::shared_ptr<StrongParser> strongParser;
 
+  // BlockParser pools, the parsers are reused across blocks and documents
+  mutable std::vector<std::shared_ptr<CodeBlockParser>> codeBlockParsers;
+  mutable std::vector<std::shared_ptr<LatexBlockParser>> latexBlockParsers;
+  mutable std::vector<std::shared_ptr<HeadlineParser>> headlineParsers;
+  mutable std::vector<std::shared_ptr<HorizontalLineParser>>
+    horizontalLineParsers;
+  mutable std::vector<std::shared_ptr<QuoteParser>> quoteParsers;
+  mutable std::vector<std::shared_ptr<TableParser>> tableParsers;
+  mutable std::vector<std::shared_ptr<ChecklistParser>> checklistParsers;
+  mutable std::vector<std::shared_ptr<OrderedListParser>> orderedListParsers;
+  mutable std::vector<std::shared_ptr<UnorderedListParser>>
+    unorderedListParsers;
+  mutable std::vector<std::shared_ptr<HtmlParser>> htmlParsers;
+  mutable std::vector<std::shared_ptr<ParagraphParser>> paragraphParsers;
+
+  /**
+   * acquireBlockParser
+   *
+   * Returns a pooled parser, that is not in use anymore, or creates a new one.
+   * A pooled parser keeps its callbacks, only its state is reset with
+   * `Clear()`.
+   *
+   * @method
+   * @param {std::vector<std::shared_ptr<T>>&} pool
+   * @param {Factory} createParser
+   * @return {std::shared_ptr<T>}
+   */
+  template <typename T, typename Factory>
+  std::shared_ptr<T> acquireBlockParser(
+    std::vector<std::shared_ptr<T>>& pool, Factory createParser
+  ) const
+  {
+    for (const std::shared_ptr<T>& parser : pool)
+    {
+      // only the pool holds a parser, that is not in use
+      if (parser.use_count() == 1)
+      {
+        parser->Clear();
+        return parser;
+      }
+    }
+
+    pool.push_back(createParser());
+    return pool.back();
+  }
+
   // block parser have to run before
   void runLineParser(std::string& line) const
   {
+    if (this->inlineParser)
+    {
+      this->inlineParser->Parse(line);
+      return;
+    }
+
     // Attention! ImageParser has to be before LinkParser
     if (this->imageParser)
     {
@@ -224,173 +304,289 @@ private:
     }
   }
 
+  /**
+   * getBlockStartCandidates
+   *
+   * Returns the `maddy::types` bits of the block parsers whose starting line
+   * can begin with the first character of `line`. Only those need their
+   * `IsStartingLine` checked; the paragraph parser is not part of the table as
+   * it accepts any non-empty line.
+   *
+   * @method
+   * @param {const std::string&} line
+   * @return {uint32_t}
+   */
+  static uint32_t getBlockStartCandidates(const std::string& line)
+  {
+    static const std::array<uint32_t, 256> candidates = []()
+    {
+      std::array<uint32_t, 256> table{};
+      table['`'] = maddy::types::CODE_BLOCK_PARSER;
+      table['$'] = maddy::types::LATEX_BLOCK_PARSER;
+      table['#'] = maddy::types::HEADLINE_PARSER;
+      table['-'] = maddy::types::HORIZONTAL_LINE_PARSER |
+                   maddy::types::CHECKLIST_PARSER |
+                   maddy::types::UNORDERED_LIST_PARSER;
+      table['>'] = maddy::types::QUOTE_PARSER;
+      table['|'] = maddy::types::TABLE_PARSER;
+      table['1'] = maddy::types::ORDERED_LIST_PARSER;
+      table['+'] = maddy::types::UNORDERED_LIST_PARSER;
+      table['*'] = maddy::types::UNORDERED_LIST_PARSER;
+      table['<'] = maddy::types::HTML_PARSER;
+      return table;
+    }();
+
+    if (line.empty())
+    {
+      return 0;
+    }
+
+    return candidates[static_cast<unsigned char>(line[0])];
+  }
+
+protected:
+  /**
+   * getBlockParserForLine
+   *
+   * Picks the block parser for a line that starts a new block, nullptr for an
+   * empty line. Protected so that the selection can be tested on its own.
+   *
+   * @method
+   * @param {const std::string&} line
+   * @return {std::shared_ptr<BlockParser>}
+   */
   std::shared_ptr<BlockParser> getBlockParserForLine(const std::string& line
   ) const
   {
     std::shared_ptr<BlockParser> parser;
+    const uint32_t candidates = getBlockStartCandidates(line);
 
     if ((!this->config || (this->config->enabledParsers &
                            maddy::types::CODE_BLOCK_PARSER) != 0) &&
+        (candidates & maddy::types::CODE_BLOCK_PARSER) != 0 &&
         maddy::CodeBlockParser::IsStartingLine(line))
     {
-      parser = std::make_shared<maddy::CodeBlockParser>(nullptr, nullptr);
+      parser = this->acquireBlockParser(
+        this->codeBlockParsers,
+        []() { return std::make_shared<maddy::CodeBlockParser>(nullptr, nullptr); }
+      );
     }
     else if (this->config &&
              (this->config->enabledParsers & maddy::types::LATEX_BLOCK_PARSER
              ) != 0 &&
+             (candidates & maddy::types::LATEX_BLOCK_PARSER) != 0 &&
              maddy::LatexBlockParser::IsStartingLine(line))
     {
-      parser = std::make_shared<LatexBlockParser>(nullptr, nullptr);
+      parser = this->acquireBlockParser(
+        this->latexBlockParsers,
+        []() { return std::make_shared<LatexBlockParser>(nullptr, nullptr); }
+      );
     }
     else if ((!this->config || (this->config->enabledParsers &
                                 maddy::types::HEADLINE_PARSER) != 0) &&
+             (candidates & maddy::types::HEADLINE_PARSER) != 0 &&
              maddy::HeadlineParser::IsStartingLine(line))
     {
-      if (!this->config || this->config->isHeadlineInlineParsingEnabled)
-      {
-        parser = std::make_shared<maddy::HeadlineParser>(
-          [this](std::string& line) { this->runLineParser(line); },
-          nullptr,
-          true
-        );
-      }
-      else
-      {
-        parser =
-          std::make_shared<maddy::HeadlineParser>(nullptr, nullptr, false);
-      }
+      parser = this->acquireBlockParser(
+        this->headlineParsers,
+        [this]()
+        {
+          if (!this->config || this->config->isHeadlineInlineParsingEnabled)
+          {
+            return std::make_shared<maddy::HeadlineParser>(
+              [this](std::string& line) { this->runLineParser(line); },
+              nullptr,
+              true
+            );
+          }
+
+          return std::make_shared<maddy::HeadlineParser>(nullptr, nullptr, false);
+        }
+      );
     }
     else if ((!this->config || (this->config->enabledParsers &
                                 maddy::types::HORIZONTAL_LINE_PARSER) != 0) &&
+             (candidates & maddy::types::HORIZONTAL_LINE_PARSER) != 0 &&
              maddy::HorizontalLineParser::IsStartingLine(line))
     {
-      parser = std::make_shared<maddy::HorizontalLineParser>(nullptr, nullptr);
+      parser = this->acquireBlockParser(
+        this->horizontalLineParsers,
+        []()
+        { return std::make_shared<maddy::HorizontalLineParser>(nullptr, nullptr); }
+      );
     }
     else if ((!this->config || (this->config->enabledParsers &
                                 maddy::types::QUOTE_PARSER) != 0) &&
+             (candidates & maddy::types::QUOTE_PARSER) != 0 &&
              maddy::QuoteParser::IsStartingLine(line))
     {
-      parser = std::make_shared<maddy::QuoteParser>(
-        [this](std::string& line) { this->runLineParser(line); },
-        [this](const std::string& line)
-        { return this->getBlockParserForLine(line); }
+      parser = this->acquireBlockParser(
+        this->quoteParsers,
+        [this]()
+        {
+          return std::make_shared<maddy::QuoteParser>(
+            [this](std::string& line) { this->runLineParser(line); },
+            [this](const std::string& line)
+            { return this->getBlockParserForLine(line); }
+          );
+        }
       );
     }
     else if ((!this->config || (this->config->enabledParsers &
                                 maddy::types::TABLE_PARSER) != 0) &&
+             (candidates & maddy::types::TABLE_PARSER) != 0 &&
              maddy::TableParser::IsStartingLine(line))
     {
-      parser = std::make_shared<maddy::TableParser>(
-        [this](std::string& line) { this->runLineParser(line); }, nullptr
+      parser = this->acquireBlockParser(
+        this->tableParsers,
+        [this]()
+        {
+          return std::make_shared<maddy::TableParser>(
+            [this](std::string& line) { this->runLineParser(line); }, nullptr
+          );
+        }
       );
     }
     else if ((!this->config || (this->config->enabledParsers &
                                 maddy::types::CHECKLIST_PARSER) != 0) &&
+             (candidates & maddy::types::CHECKLIST_PARSER) != 0 &&
              maddy::ChecklistParser::IsStartingLine(line))
     {
       parser = this->createChecklistParser();
     }
     else if ((!this->config || (this->config->enabledParsers &
                                 maddy::types::ORDERED_LIST_PARSER) != 0) &&
+             (candidates & maddy::types::ORDERED_LIST_PARSER) != 0 &&
              maddy::OrderedListParser::IsStartingLine(line))
     {
       parser = this->createOrderedListParser();
     }
     else if ((!this->config || (this->config->enabledParsers &
                                 maddy::types::UNORDERED_LIST_PARSER) != 0) &&
+             (candidates & maddy::types::UNORDERED_LIST_PARSER) != 0 &&
              maddy::UnorderedListParser::IsStartingLine(line))
     {
       parser = this->createUnorderedListParser();
     }
     else if (this->config &&
              (this->config->enabledParsers & maddy::types::HTML_PARSER) != 0 &&
+             (candidates & maddy::types::HTML_PARSER) != 0 &&
              maddy::HtmlParser::IsStartingLine(line))
     {
-      parser = std::make_shared<maddy::HtmlParser>(nullptr, nullptr);
+      parser = this->acquireBlockParser(
+        this->htmlParsers,
+        []() { return std::make_shared<maddy::HtmlParser>(nullptr, nullptr); }
+      );
     }
     else if (maddy::ParagraphParser::IsStartingLine(line))
     {
-      parser = std::make_shared<maddy::ParagraphParser>(
-        [this](std::string& line) { this->runLineParser(line); },
-        nullptr,
-        (!this->config ||
-         (this->config->enabledParsers & maddy::types::PARAGRAPH_PARSER) != 0)
+      parser = this->acquireBlockParser(
+        this->paragraphParsers,
+        [this]()
+        {
+          return std::make_shared<maddy::ParagraphParser>(
+            [this](std::string& line) { this->runLineParser(line); },
+            nullptr,
+            (!this->config ||
+             (this->config->enabledParsers & maddy::types::PARAGRAPH_PARSER) !=
+               0)
+          );
+        }
       );
     }
 
     return parser;
   }
 
+private:
   std::shared_ptr<BlockParser> createChecklistParser() const
   {
-    return std::make_shared<maddy::ChecklistParser>(
-      [this](std::string& line) { this->runLineParser(line); },
-      [this](const std::string& line)
+    return this->acquireBlockParser(
+      this->checklistParsers,
+      [this]()
       {
-        std::shared_ptr<BlockParser> parser;
-
-        if ((!this->config || (this->config->enabledParsers &
-                               maddy::types::CHECKLIST_PARSER) != 0) &&
-            maddy::ChecklistParser::IsStartingLine(line))
-        {
-          parser = this->createChecklistParser();
-        }
-
-        return parser;
+        return std::make_shared<maddy::ChecklistParser>(
+          [this](std::string& line) { this->runLineParser(line); },
+          [this](const std::string& line)
+          {
+            std::shared_ptr<BlockParser> parser;
+
+            if ((!this->config || (this->config->enabledParsers &
+                                   maddy::types::CHECKLIST_PARSER) != 0) &&
+                maddy::ChecklistParser::IsStartingLine(line))
+            {
+              parser = this->createChecklistParser();
+            }
+
+            return parser;
+          }
+        );
       }
     );
   }
 
   std::shared_ptr<BlockParser> createOrderedListParser() const
   {
-    return std::make_shared<maddy::OrderedListParser>(
-      [this](std::string& line) { this->runLineParser(line); },
-      [this](const std::string& line)
+    return this->acquireBlockParser(
+      this->orderedListParsers,
+      [this]()
       {
-        std::shared_ptr<BlockParser> parser;
-
-        if ((!this->config || (this->config->enabledParsers &
-                               maddy::types::ORDERED_LIST_PARSER) != 0) &&
-            maddy::OrderedListParser::IsStartingLine(line))
-        {
-          parser = this->createOrderedListParser();
-        }
-        else if ((!this->config || (this->config->enabledParsers &
-                                    maddy::types::UNORDERED_LIST_PARSER) != 0
-                 ) &&
-                 maddy::UnorderedListParser::IsStartingLine(line))
-        {
-          parser = this->createUnorderedListParser();
-        }
-
-        return parser;
+        return std::make_shared<maddy::OrderedListParser>(
+          [this](std::string& line) { this->runLineParser(line); },
+          [this](const std::string& line)
+          {
+            std::shared_ptr<BlockParser> parser;
+
+            if ((!this->config || (this->config->enabledParsers &
+                                   maddy::types::ORDERED_LIST_PARSER) != 0) &&
+                maddy::OrderedListParser::IsStartingLine(line))
+            {
+              parser = this->createOrderedListParser();
+            }
+            else if ((!this->config || (this->config->enabledParsers &
+                                        maddy::types::UNORDERED_LIST_PARSER) != 0
+                     ) &&
+                     maddy::UnorderedListParser::IsStartingLine(line))
+            {
+              parser = this->createUnorderedListParser();
+            }
+
+            return parser;
+          }
+        );
       }
     );
   }
 
   std::shared_ptr<BlockParser> createUnorderedListParser() const
   {
-    return std::make_shared<maddy::UnorderedListParser>(
-      [this](std::string& line) { this->runLineParser(line); },
-      [this](const std::string& line)
+    return this->acquireBlockParser(
+      this->unorderedListParsers,
+      [this]()
       {
-        std::shared_ptr<BlockParser> parser;
-
-        if ((!this->config || (this->config->enabledParsers &
-                               maddy::types::ORDERED_LIST_PARSER) != 0) &&
-            maddy::OrderedListParser::IsStartingLine(line))
-        {
-          parser = this->createOrderedListParser();
-        }
-        else if ((!this->config || (this->config->enabledParsers &
-                                    maddy::types::UNORDERED_LIST_PARSER) != 0
-                 ) &&
-                 maddy::UnorderedListParser::IsStartingLine(line))
-        {
-          parser = this->createUnorderedListParser();
-        }
-
-        return parser;
+        return std::make_shared<maddy::UnorderedListParser>(
+          [this](std::string& line) { this->runLineParser(line); },
+          [this](const std::string& line)
+          {
+            std::shared_ptr<BlockParser> parser;
+
+            if ((!this->config || (this->config->enabledParsers &
+                                   maddy::types::ORDERED_LIST_PARSER) != 0) &&
+                maddy::OrderedListParser::IsStartingLine(line))
+            {
+              parser = this->createOrderedListParser();
+            }
+            else if ((!this->config || (this->config->enabledParsers &
+                                        maddy::types::UNORDERED_LIST_PARSER) != 0
+                     ) &&
+                     maddy::UnorderedListParser::IsStartingLine(line))
+            {
+              parser = this->createUnorderedListParser();
+            }
+
+            return parser;
+          }
+        );
       }
     );
   }
@@ -70,9 +70,19 @@ struct ParserConfig
    */
   uint32_t enabledParsers;
 
+  /**
+   * use the regex based line parsers instead of the linear `InlineParser`
+   *
+   * Both produce the same HTML, this is mostly useful for comparison.
+   *
+   * default: disabled
+   */
+  bool isRegexInlineParsingEnabled;
+
   ParserConfig()
     : isHeadlineInlineParsingEnabled(true)
     , enabledParsers(maddy::types::DEFAULT)
+    , isRegexInlineParsingEnabled(false)
   {}
 }; // class ParserConfig
 
@@ -55,8 +55,8 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re(R"(^\>.*)");
-    return std::regex_match(line, re);
+    // ^\>.*
+    return !line.empty() && line[0] == '>' && isSingleLineFrom(line, 1);
   }
 
   /**
@@ -95,7 +95,7 @@ public:
 
       if (this->childParser->IsFinished())
       {
-        this->result << this->childParser->GetResult().str();
+        this->result << this->childParser->GetResult();
         this->childParser = nullptr;
       }
 
@@ -116,6 +116,21 @@ public:
     this->result << line;
   }
 
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
+  }
+
   /**
    * IsFinished
    *
@@ -8,6 +8,7 @@
 
 #include <functional>
 #include <regex>
+#include <sstream>
 #include <string>
 
 #include "maddy/blockparser.h"
@@ -116,6 +117,24 @@ public:
     }
   }
 
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
+    this->currentBlock = 0;
+    this->currentRow = 0;
+    this->table.clear();
+  }
+
   /**
    * IsFinished
    *
@@ -55,8 +55,25 @@ public:
    */
   static bool IsStartingLine(const std::string& line)
   {
-    static std::regex re("^[+*-] .*");
-    return std::regex_match(line, re);
+    // ^[+*-] .*
+    return line.size() >= 2 &&
+           (line[0] == '+' || line[0] == '*' || line[0] == '-') &&
+           line[1] == ' ' && isSingleLineFrom(line, 2);
+  }
+
+  /**
+   * Clear
+   *
+   * Clear the result and the parsing state to reuse the parser object.
+   *
+   * @method
+   * @return {void}
+   */
+  void Clear() override
+  {
+    BlockParser::Clear();
+    this->isStarted = false;
+    this->isFinished = false;
   }
 
   /**
@@ -0,0 +1,433 @@
+#include "cmockgithubserver.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUrlQuery>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <utility>
+
+// The assets never change
+static const QByteArray assetLastModified = "Tue, 01 Oct 2024 12:00:00 GMT";
+static constexpr int throttlingInterval = 10; // ms
+static constexpr int maxPageSize = 100; // GitHub's
+
+static QByteArray response(const QByteArray& status, const QByteArray& headers, const QByteArray& body, qint64 contentLength = -1)
+{
+	return "HTTP/1.1 " + status + "\r\n"
+		+ headers
+		+ "Content-Length: " + QByteArray::number(contentLength >= 0 ? contentLength : body.size()) + "\r\n"
+		"\r\n"
+		+ body;
+}
+
+static QByteArray jsonError(const QByteArray& status, const QByteArray& message, const QByteArray& headers = {})
+{
+	return response(status, "Content-Type: application/json; charset=utf-8\r\n" + headers,
+		R"({"message":")" + message + R"(","documentation_url":"https://docs.github.com/rest","status":")" + status.left(3) + R"("})");
+}
+
+static QByteArray strongEtag(const QByteArray& data)
+{
+	return '"' + QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() + '"';
+}
+
+CMockGithubServer::CMockGithubServer(QString repositoryName, QObject* parent) :
+	QTcpServer(parent),
+	_repositoryName(std::move(repositoryName)),
+	_throttlingTimer(this) // A child, so that it moves to another thread together with the server
+{
+	connect(this, &QTcpServer::newConnection, this, &CMockGithubServer::acceptConnections);
+
+	_throttlingTimer.setTimerType(Qt::PreciseTimer);
+	_throttlingTimer.setInterval(throttlingInterval);
+	connect(&_throttlingTimer, &QTimer::timeout, this, &CMockGithubServer::sendThrottledData);
+}
+
+bool CMockGithubServer::start()
+{
+	return listen(QHostAddress::LocalHost);
+}
+
+QString CMockGithubServer::baseUrl() const
+{
+	return "http://127.0.0.1:" + QString::number(serverPort());
+}
+
+QString CMockGithubServer::assetUrl(const QString& name) const
+{
+	return baseUrl() + "/download/" + name;
+}
+
+QByteArray CMockGithubServer::assetEtag(const QString& name) const
+{
+	return _assetEtags.value(name);
+}
+
+void CMockGithubServer::setReleasesJson(const QByteArray& json)
+{
+	_releasesJson = json;
+	_releasesPages.clear();
+	_releases.clear();
+
+	const QJsonArray releases = QJsonDocument::fromJson(json).array();
+	_releases.reserve(static_cast<size_t>(releases.size()));
+	for (const auto& release : releases)
+		_releases.push_back(QJsonDocument(release.toObject()).toJson(QJsonDocument::Compact));
+}
+
+void CMockGithubServer::setDefaultPageSize(int releasesPerPage)
+{
+	_defaultPageSize = std::max(releasesPerPage, 0);
+}
+
+void CMockGithubServer::addAsset(const QString& name, QByteArray data)
+{
+	_assetEtags[name] = strongEtag(data);
+	_assets[name] = std::move(data);
+}
+
+void CMockGithubServer::setRangeSupport(bool supported)
+{
+	_rangeSupported = supported;
+}
+
+void CMockGithubServer::setLatency(int milliseconds)
+{
+	_latency = std::max(milliseconds, 0);
+}
+
+void CMockGithubServer::setBandwidthLimit(qint64 bytesPerSecond)
+{
+	_bandwidthLimit = std::max(bytesPerSecond, qint64{0});
+}
+
+void CMockGithubServer::setRateLimit(int requestsPerHour)
+{
+	_rateLimit = std::max(requestsPerHour, 0);
+	_rateLimitUsed = 0;
+	_rateLimitReset = 0;
+}
+
+qint64 CMockGithubServer::requestsServed() const
+{
+	return _requestsServed;
+}
+
+qint64 CMockGithubServer::bytesSent() const
+{
+	return _bytesSent;
+}
+
+void CMockGithubServer::setConnectionDropAfter(qint64 bodyBytes)
+{
+	_connectionDropAfter = std::max(bodyBytes, qint64{0});
+}
+
+const std::vector<CMockGithubServer::LoggedRequest>& CMockGithubServer::requestLog() const
+{
+	return _requestLog;
+}
+
+void CMockGithubServer::clearRequestLog()
+{
+	_requestLog.clear();
+}
+
+void CMockGithubServer::acceptConnections()
+{
+	while (QTcpSocket* socket = nextPendingConnection())
+	{
+		_connections.insert(socket, {});
+		connect(socket, &QTcpSocket::readyRead, this, [this, socket] { readRequests(socket); });
+		connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+			_connections.remove(socket);
+			socket->deleteLater();
+		});
+	}
+}
+
+void CMockGithubServer::readRequests(QTcpSocket* socket)
+{
+	QByteArray& data = _connections[socket].receivedData;
+	data += socket->readAll();
+
+	// GET and HEAD requests have no body, each one ends with the empty line after the headers. Keep-alive: there can be more than one.
+	for (auto headerEnd = data.indexOf("\r\n\r\n"); headerEnd >= 0; headerEnd = data.indexOf("\r\n\r\n"))
+	{
+		const QByteArrayList lines = data.left(headerEnd).split('\n');
+		data.remove(0, headerEnd + 4);
+
+		// GET /repos/<owner>/<repo>/releases?per_page=... HTTP/1.1
+		const QByteArrayList requestLine = lines.front().trimmed().split(' ');
+		if (requestLine.size() != 3)
+		{
+			send(socket, jsonError("400 Bad Request", "Problems parsing the request"), false);
+			continue;
+		}
+
+		Request request{ requestLine[0], requestLine[1], {} };
+		for (auto line = std::next(lines.begin()); line != lines.end(); ++line)
+		{
+			const auto colon = line->indexOf(':');
+			if (colon > 0)
+				request.headers.insert(line->left(colon).trimmed().toLower(), line->mid(colon + 1).trimmed());
+		}
+
+		QByteArray responseData = respond(request);
+		const auto bodyOffset = responseData.indexOf("\r\n\r\n") + 4;
+		const QUrl url(QString::fromUtf8("http://127.0.0.1" + request.target));
+		LoggedRequest& loggedRequest = _requestLog.emplace_back(LoggedRequest{ request.method, url.path(), url.query(),
+			request.headers.value("range"), request.headers.value("if-range"), responseData.mid(9, 3).toInt(), responseData.size() - bodyOffset });
+		++_requestsServed;
+
+		// The rest of the body is lost with the connection, and so are any further requests on it
+		const bool dropConnection = _connectionDropAfter > 0 && request.method == "GET" && loggedRequest.path.startsWith("/download/")
+			&& loggedRequest.bodyBytes > _connectionDropAfter;
+		if (dropConnection)
+		{
+			responseData.truncate(bodyOffset + _connectionDropAfter);
+			loggedRequest.bodyBytes = _connectionDropAfter;
+			data.clear();
+			send(socket, responseData, true);
+			return;
+		}
+
+		send(socket, responseData, false);
+	}
+}
+
+QByteArray CMockGithubServer::respond(const Request& request)
+{
+	if (request.method != "GET" && request.method != "HEAD")
+		return jsonError("405 Method Not Allowed", "Method Not Allowed");
+
+	const QUrl url(QString::fromUtf8("http://127.0.0.1" + request.target));
+	const QString path = url.path();
+
+	if (path.startsWith("/download/") && _assets.contains(path.mid(10)))
+		return assetResponse(request, _assets[path.mid(10)], _assetEtags[path.mid(10)]);
+
+	if (path == "/repos/" + _repositoryName + "/releases")
+		return releasesResponse(request, QUrlQuery(url));
+
+	if (path.startsWith("/repos/"))
+		return jsonError("404 Not Found", "Not Found", rateLimitHeaders(true));
+
+	return jsonError("404 Not Found", "Not Found");
+}
+
+QByteArray CMockGithubServer::releasesResponse(const Request& request, const QUrlQuery& query)
+{
+	const int perPage = query.hasQueryItem("per_page") ? std::clamp(query.queryItemValue("per_page").toInt(), 1, maxPageSize) : _defaultPageSize;
+	const int page = std::max(query.queryItemValue("page").toInt(), 1);
+	const ReleasesPage& releasesPage = this->releasesPage(perPage, page);
+
+	QByteArray headers = "Content-Type: application/json; charset=utf-8\r\n"
+		"Cache-Control: private, max-age=60, s-maxage=60\r\n"
+		"Vary: Accept, Authorization, Cookie\r\n"
+		"ETag: " + releasesPage.etag + "\r\n";
+	if (!releasesPage.link.isEmpty())
+		headers += "Link: " + releasesPage.link + "\r\n";
+
+	// Conditional requests are free
+	if (request.headers.value("if-none-match") == releasesPage.etag)
+		return response("304 Not Modified", headers + rateLimitHeaders(false), {}, 0);
+
+	if (_rateLimit > 0 && _rateLimitUsed >= _rateLimit && QDateTime::currentSecsSinceEpoch() < _rateLimitReset)
+		return jsonError("403 Forbidden", "API rate limit exceeded for 127.0.0.1.", rateLimitHeaders(false));
+
+	headers += rateLimitHeaders(true);
+	return request.method == "HEAD" ? response("200 OK", headers, {}, releasesPage.body.size()) : response("200 OK", headers, releasesPage.body);
+}
+
+// Single byte ranges only, which is all that the updater requests. Multiple ranges get the whole asset, as the RFC allows.
+QByteArray CMockGithubServer::assetResponse(const Request& request, const QByteArray& data, const QByteArray& etag) const
+{
+	const bool headOnly = request.method == "HEAD";
+	const qint64 size = data.size();
+	QByteArray headers = "Content-Type: application/octet-stream\r\n"
+		"ETag: " + etag + "\r\n"
+		"Last-Modified: " + assetLastModified + "\r\n";
+	if (_rangeSupported)
+		headers += "Accept-Ranges: bytes\r\n";
+
+	const QByteArray range = request.headers.value("range"), ifRange = request.headers.value("if-range");
+	const bool rangeApplies = _rangeSupported && range.startsWith("bytes=") && !range.contains(',')
+		&& (ifRange.isEmpty() || ifRange == etag || ifRange == assetLastModified);
+	if (!rangeApplies)
+		return headOnly ? response("200 OK", headers, {}, size) : response("200 OK", headers, data);
+
+	// bytes=<first>-<last>, bytes=<first>- or bytes=-<suffix length>
+	const QByteArray spec = range.mid(6).trimmed();
+	const auto dash = spec.indexOf('-');
+	bool firstOk = false, lastOk = false;
+	qint64 first = dash > 0 ? spec.left(dash).toLongLong(&firstOk) : 0;
+	qint64 last = dash >= 0 && dash + 1 < spec.size() ? spec.mid(dash + 1).toLongLong(&lastOk) : size - 1;
+	if (dash == 0 && lastOk)
+	{
+		first = std::max(size - last, qint64{0});
+		last = size - 1;
+	}
+	else if (dash < 0 || !firstOk || (dash + 1 < spec.size() && !lastOk))
+		return headOnly ? response("200 OK", headers, {}, size) : response("200 OK", headers, data);
+
+	last = std::min(last, size - 1);
+	if (first > last)
+		return response("416 Range Not Satisfiable", headers + "Content-Range: bytes */" + QByteArray::number(size) + "\r\n", {});
+
+	headers += "Content-Range: bytes " + QByteArray::number(first) + '-' + QByteArray::number(last) + '/' + QByteArray::number(size) + "\r\n";
+	const qint64 length = last - first + 1;
+	return headOnly ? response("206 Partial Content", headers, {}, length) : response("206 Partial Content", headers, data.mid(first, length));
+}
+
+const CMockGithubServer::ReleasesPage& CMockGithubServer::releasesPage(int releasesPerPage, int page)
+{
+	const quint64 key = static_cast<quint64>(releasesPerPage) << 32 | static_cast<quint64>(page);
+	if (const auto cached = _releasesPages.constFind(key); cached != _releasesPages.cend())
+		return *cached;
+
+	ReleasesPage& releasesPage = _releasesPages[key];
+	if (releasesPerPage == 0)
+		releasesPage.body = _releasesJson;
+	else
+	{
+		const size_t count = _releases.size(), begin = std::min(static_cast<size_t>(page - 1) * static_cast<size_t>(releasesPerPage), count);
+		const size_t end = std::min(begin + static_cast<size_t>(releasesPerPage), count);
+
+		releasesPage.body = "[";
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (i > begin)
+				releasesPage.body += ',';
+			releasesPage.body += _releases[i];
+		}
+		releasesPage.body += ']';
+
+		// Like GitHub's: <...?per_page=30&page=2>; rel="next", <...?per_page=30&page=5>; rel="last"
+		const int lastPage = std::max(static_cast<int>((count + static_cast<size_t>(releasesPerPage) - 1) / static_cast<size_t>(releasesPerPage)), 1);
+		const QByteArray pageUrl = (baseUrl() + "/repos/" + _repositoryName + "/releases?per_page=" + QString::number(releasesPerPage) + "&page=").toUtf8();
+		const auto link = [&pageUrl](int linkedPage, const char* rel) { return '<' + pageUrl + QByteArray::number(linkedPage) + ">; rel=\"" + rel + '"'; };
+
+		QByteArrayList links;
+		if (page > 1)
+			links.push_back(link(page - 1, "prev"));
+		if (page < lastPage)
+			links.push_back(link(page + 1, "next"));
+		if (page != lastPage)
+			links.push_back(link(lastPage, "last"));
+		if (page > 1)
+			links.push_back(link(1, "first"));
+		releasesPage.link = links.join(", ");
+	}
+
+	// GitHub's ETags for API responses are weak
+	releasesPage.etag = "W/" + strongEtag(releasesPage.body);
+	return releasesPage;
+}
+
+QByteArray CMockGithubServer::rateLimitHeaders(bool countRequest)
+{
+	if (_rateLimit == 0)
+		return {};
+
+	const qint64 now = QDateTime::currentSecsSinceEpoch();
+	if (now >= _rateLimitReset)
+	{
+		_rateLimitUsed = 0;
+		_rateLimitReset = now + 3600;
+	}
+
+	if (countRequest)
+		_rateLimitUsed = std::min(_rateLimitUsed + 1, _rateLimit);
+
+	return "X-RateLimit-Limit: " + QByteArray::number(_rateLimit) + "\r\n"
+		"X-RateLimit-Remaining: " + QByteArray::number(_rateLimit - _rateLimitUsed) + "\r\n"
+		"X-RateLimit-Reset: " + QByteArray::number(_rateLimitReset) + "\r\n"
+		"X-RateLimit-Used: " + QByteArray::number(_rateLimitUsed) + "\r\n"
+		"X-RateLimit-Resource: core\r\n";
+}
+
+void CMockGithubServer::send(QTcpSocket* socket, const QByteArray& response, bool closeConnection)
+{
+	_bytesSent += response.size();
+
+	// The timers fire in the order they were started, so the responses on a connection stay in the order of the requests
+	if (_latency > 0)
+		QTimer::singleShot(_latency, Qt::PreciseTimer, socket, [this, socket, response, closeConnection] { write(socket, response, closeConnection); });
+	else
+		write(socket, response, closeConnection);
+}
+
+// Closing waits for the data that has been written to go out
+void CMockGithubServer::write(QTcpSocket* socket, const QByteArray& data, bool closeConnection)
+{
+	if (_bandwidthLimit == 0)
+	{
+		socket->write(data);
+		if (closeConnection)
+			socket->disconnectFromHost();
+		return;
+	}
+
+	Connection& connection = _connections[socket];
+	if (connection.pendingOutput.isEmpty())
+		connection.sendCredit = 0.0;
+
+	connection.pendingOutput += data;
+	connection.closeWhenSent = closeConnection;
+	if (!_throttlingTimer.isActive())
+	{
+		_throttlingClock.start();
+		_throttlingTimer.start();
+	}
+}
+
+// Every connection gets its share of the bandwidth for the time since the last call
+void CMockGithubServer::sendThrottledData()
+{
+	const double credit = static_cast<double>(_bandwidthLimit) * static_cast<double>(_throttlingClock.nsecsElapsed()) / 1e9;
+	_throttlingClock.restart();
+
+	bool dataPending = false;
+	std::vector<QTcpSocket*> socketsToClose; // Closing may remove them from _connections
+	for (auto it = _connections.begin(); it != _connections.end(); ++it)
+	{
+		Connection& connection = it.value();
+		const qint64 bytesPending = connection.pendingOutput.size() - connection.pendingOffset;
+		if (bytesPending == 0)
+			continue;
+
+		connection.sendCredit += credit;
+		const qint64 bytesToSend = std::min(static_cast<qint64>(connection.sendCredit), bytesPending);
+		if (bytesToSend > 0)
+		{
+			it.key()->write(connection.pendingOutput.constData() + connection.pendingOffset, bytesToSend);
+			connection.pendingOffset += bytesToSend;
+			connection.sendCredit -= static_cast<double>(bytesToSend);
+		}
+
+		if (connection.pendingOffset < connection.pendingOutput.size())
+			dataPending = true;
+		else
+		{
+			connection.pendingOutput.clear();
+			connection.pendingOffset = 0;
+			if (connection.closeWhenSent)
+				socketsToClose.push_back(it.key());
+		}
+	}
+
+	if (!dataPending)
+		_throttlingTimer.stop();
+
+	for (QTcpSocket* socket : socketsToClose)
+		socket->disconnectFromHost();
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QTcpServer>
+#include <QTimer>
+RESTORE_COMPILER_WARNINGS
+
+#include <vector>
+
+class QTcpSocket;
+class QUrlQuery;
+
+// A stand-in for the GitHub API and the release downloads on a loopback port, over plain HTTP/1.1 with keep-alive:
+// GET /repos/<repository>/releases - the releases it's been given, paginated with per_page / page and a Link header like GitHub's,
+//   with an ETag (a matching If-None-Match gets 304) and, optionally, rate limit headers and 403 once the limit is used up;
+// GET / HEAD /download/<name> - the assets it's been given, with Range / If-Range support that can be turned off.
+// Everything else gets 404. The network can be made slower: a delay before every response, a bandwidth cap per connection,
+// and less reliable: the asset downloads can be cut off. Every request is logged.
+// Lives on the thread it's been created on (or moved to), and must be configured from that thread.
+class CMockGithubServer final : public QTcpServer
+{
+public:
+	struct LoggedRequest {
+		QByteArray method;
+		QString path;
+		QString query;      // E. g. per_page=10&page=2, empty if none
+		QByteArray range;   // The Range header, empty if none
+		QByteArray ifRange; // The If-Range header, empty if none
+		int status = 0;
+		qint64 bodyBytes = 0; // Sent, after any cut-off
+	};
+
+	explicit CMockGithubServer(QString repositoryName, QObject* parent = nullptr);
+
+	// Listens on 127.0.0.1, on a free port
+	bool start();
+	// To be passed to CAutoUpdaterGithub::setApiBaseUrl()
+	[[nodiscard]] QString baseUrl() const;
+	[[nodiscard]] QString assetUrl(const QString& name) const;
+	// The strong ETag the asset is served with
+	[[nodiscard]] QByteArray assetEtag(const QString& name) const;
+
+	// A JSON array of releases, newest first
+	void setReleasesJson(const QByteArray& json);
+	// Without per_page, GitHub returns 30 releases. 0 (the default) returns all of them, so that large replies can be measured.
+	void setDefaultPageSize(int releasesPerPage);
+	void addAsset(const QString& name, QByteArray data);
+	// When off, Range and If-Range are ignored and every download gets the whole asset with 200, like from a server without range support
+	void setRangeSupport(bool supported);
+
+	// Before every response, in ms. 0 (the default): respond right away.
+	void setLatency(int milliseconds);
+	// Per connection, 0 (the default): unlimited
+	void setBandwidthLimit(qint64 bytesPerSecond);
+	// API requests per hour. 304s don't count, as on GitHub. 0 (the default): no limit and no X-RateLimit-* headers.
+	void setRateLimit(int requestsPerHour);
+	// Every asset download that has more to send is cut off after this many bytes of the body, and the connection is closed.
+	// 0 (the default): the downloads are complete.
+	void setConnectionDropAfter(qint64 bodyBytes);
+
+	[[nodiscard]] qint64 requestsServed() const;
+	[[nodiscard]] qint64 bytesSent() const;
+	[[nodiscard]] const std::vector<LoggedRequest>& requestLog() const;
+	void clearRequestLog();
+
+private:
+	struct Request {
+		QByteArray method;
+		QByteArray target;
+		QHash<QByteArray, QByteArray> headers; // The names in lower case
+	};
+
+	struct Connection {
+		QByteArray receivedData; // Not yet processed
+		QByteArray pendingOutput; // Held back by the bandwidth limit
+		qint64 pendingOffset = 0; // How much of pendingOutput has been sent
+		double sendCredit = 0.0;  // Bytes that may be sent now
+		bool closeWhenSent = false;
+	};
+
+	struct ReleasesPage {
+		QByteArray body;
+		QByteArray etag;
+		QByteArray link;
+	};
+
+	void acceptConnections();
+	void readRequests(QTcpSocket* socket);
+	[[nodiscard]] QByteArray respond(const Request& request);
+	[[nodiscard]] QByteArray releasesResponse(const Request& request, const QUrlQuery& query);
+	[[nodiscard]] QByteArray assetResponse(const Request& request, const QByteArray& data, const QByteArray& etag) const;
+	[[nodiscard]] const ReleasesPage& releasesPage(int releasesPerPage, int page);
+	[[nodiscard]] QByteArray rateLimitHeaders(bool countRequest);
+	void send(QTcpSocket* socket, const QByteArray& response, bool closeConnection);
+	void write(QTcpSocket* socket, const QByteArray& data, bool closeConnection);
+	void sendThrottledData();
+
+private:
+	const QString _repositoryName;
+
+	QByteArray _releasesJson;
+	std::vector<QByteArray> _releases; // Each one as compact JSON, for the pages
+	QHash<quint64, ReleasesPage> _releasesPages; // By (per_page << 32 | page)
+	int _defaultPageSize = 0;
+
+	QHash<QString, QByteArray> _assets;
+	QHash<QString, QByteArray> _assetEtags;
+	bool _rangeSupported = true;
+
+	int _latency = 0;
+	qint64 _bandwidthLimit = 0;
+	QTimer _throttlingTimer;
+	QElapsedTimer _throttlingClock;
+
+	int _rateLimit = 0;
+	int _rateLimitUsed = 0;
+	qint64 _rateLimitReset = 0; // Seconds since the epoch
+
+	qint64 _connectionDropAfter = 0;
+
+	QHash<QTcpSocket*, Connection> _connections;
+	qint64 _requestsServed = 0;
+	qint64 _bytesSent = 0;
+	std::vector<LoggedRequest> _requestLog;
+};
@@ -0,0 +1,805 @@
+#include "cautoupdatergithub.h"
+#include "cmockgithubserver.h"
+#include "cversionkey.h"
+#include "memorystats.hpp"
+#include "releasefixtures.hpp"
+
+#ifndef _WIN32
+#include "cdirectorycopier.h"
+#endif
+
+DISABLE_COMPILER_WARNINGS
+#include <QCollator>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+
+#include "maddy/parser.h"
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+// Every check gives up after this long
+static constexpr int checkTimeoutMs = 60 * 1000;
+
+struct Statistics {
+	qint64 min = 0;
+	qint64 median = 0;
+	qint64 p95 = 0;
+	qint64 mean = 0;
+};
+
+static Statistics statistics(std::vector<qint64> samples)
+{
+	if (samples.empty())
+		return {};
+
+	std::sort(samples.begin(), samples.end());
+	const auto sum = std::accumulate(samples.begin(), samples.end(), qint64{0});
+	return { samples.front(), samples[samples.size() / 2], samples[(samples.size() * 95 + 99) / 100 - 1], sum / static_cast<qint64>(samples.size()) };
+}
+
+static QJsonObject toJson(const Statistics& s)
+{
+	return { { "min", s.min }, { "median", s.median }, { "p95", s.p95 }, { "mean", s.mean } };
+}
+
+// Waits for the result of one update check
+class CheckListener final : public CAutoUpdaterGithub::UpdateStatusListener
+{
+public:
+	CheckListener(QEventLoop& loop, bool renderReleaseNotes) : _loop(loop), _renderReleaseNotes(renderReleaseNotes) {}
+
+	void onUpdateAvailable(const CAutoUpdaterGithub::ChangeLog& changelog) override
+	{
+		// What CUpdaterDialog does
+		if (_renderReleaseNotes)
+		{
+			for (const auto& entry : changelog)
+				(void)entry.versionChangesHtml();
+		}
+
+		newerReleases = changelog.size();
+		_loop.quit();
+	}
+
+	void onUpdateDownloadProgress(float) override {}
+	void onUpdateDownloadFinished() override {}
+
+	void onUpdateError(const QString& errorMessage) override
+	{
+		error = errorMessage;
+		_loop.quit();
+	}
+
+public:
+	size_t newerReleases = 0;
+	QString error;
+
+private:
+	QEventLoop& _loop;
+	const bool _renderReleaseNotes;
+};
+
+// The network as the mock server simulates it
+struct NetworkConditions {
+	int latency = 0; // ms
+	qint64 bandwidthLimit = 0; // Bytes per second per connection, 0: unlimited
+};
+
+static void configureServer(CMockGithubServer& server, const std::function<void (CMockGithubServer&)>& configure)
+{
+	QMetaObject::invokeMethod(&server, [&server, &configure] { configure(server); }, Qt::BlockingQueuedConnection);
+}
+
+static QJsonObject toJson(const NetworkConditions& network)
+{
+	return { { "latencyMs", network.latency }, { "bandwidthLimitBytesPerSecond", network.bandwidthLimit } };
+}
+
+struct CheckScenario {
+	int releaseCount = 0;
+	bool allNewer = false;       // Every release is newer than the current version, and the release notes are rendered
+	int orderedFeedStopThreshold = 0; // CAutoUpdaterGithub::setOrderedFeedStopThreshold()
+	int pageSize = 0;            // CAutoUpdaterGithub::setReleasesPageSize()
+	bool releaseCache = false;   // Conditional requests: every measured check gets 304
+	bool sharedConnection = false; // One QNetworkAccessManager for all the checks, which keeps the connection open between them
+	NetworkConditions network;
+};
+
+// The whole check as the application sees it: from checkForUpdates() to onUpdateAvailable() having returned, with a new updater
+// every time, like at the start of the application
+static QJsonObject benchmarkUpdateCheck(CMockGithubServer& server, const CheckScenario& scenario, int iterations)
+{
+	const QByteArray json = ReleaseFixtures::releasesJson(scenario.releaseCount);
+	configureServer(server, [&](CMockGithubServer& s) {
+		s.setReleasesJson(json);
+		s.setLatency(scenario.network.latency);
+		s.setBandwidthLimit(scenario.network.bandwidthLimit);
+	});
+
+	const QString currentVersion = scenario.allNewer ? QString::fromLatin1(ReleaseFixtures::oldestVersion) : QString::fromStdString(ReleaseFixtures::newestVersion(scenario.releaseCount));
+	QTemporaryDir cacheDirectory;
+	const QString cacheFilePath = scenario.releaseCache ? cacheDirectory.filePath("releases.cache") : QString{};
+	std::unique_ptr<QNetworkAccessManager> sharedNetworkManager;
+	if (scenario.sharedConnection)
+		sharedNetworkManager = std::make_unique<QNetworkAccessManager>();
+
+	std::vector<qint64> latencies, firstByte, lastByte, jsonParse, filter, markdown, listener;
+	MemoryStats::Allocations allocations;
+	CAutoUpdaterGithub::UpdateCheckMetrics lastMetrics;
+	size_t newerReleases = 0;
+	QString error;
+
+	// One more iteration than measured, to warm up (and to fill the cache)
+	const bool peakRssReset = MemoryStats::resetPeakRss();
+	for (int i = -1; i < iterations && error.isEmpty(); ++i)
+	{
+		QEventLoop loop;
+		CheckListener checkListener(loop, scenario.allNewer);
+		std::optional<CAutoUpdaterGithub::UpdateCheckMetrics> metrics;
+
+		const MemoryStats::Allocations allocationsBefore = MemoryStats::allocations();
+		QElapsedTimer timer;
+		timer.start();
+		{
+			CAutoUpdaterGithub updater(ReleaseFixtures::repositoryName, currentVersion);
+			updater.setApiBaseUrl(server.baseUrl());
+			updater.setNetworkAccessManager(sharedNetworkManager.get());
+			updater.setReleaseCacheFilePath(cacheFilePath);
+			updater.setOrderedFeedStopThreshold(scenario.orderedFeedStopThreshold);
+			updater.setReleasesPageSize(scenario.pageSize);
+			updater.setUpdateStatusListener(&checkListener);
+			updater.setUpdateCheckMetricsHandler([&metrics](const CAutoUpdaterGithub::UpdateCheckMetrics& m) { metrics = m; });
+
+			QTimer::singleShot(checkTimeoutMs, &loop, [&checkListener] { checkListener.onUpdateError("Timed out"); });
+			updater.checkForUpdates();
+			loop.exec();
+		}
+		const qint64 latency = timer.nsecsElapsed();
+		const MemoryStats::Allocations allocationsAfter = MemoryStats::allocations();
+
+		error = checkListener.error;
+		if (!error.isEmpty() || !metrics)
+			break;
+
+		if (i < 0)
+			continue;
+
+		latencies.push_back(latency);
+		firstByte.push_back(metrics->firstByte);
+		lastByte.push_back(metrics->lastByte);
+		jsonParse.push_back(metrics->jsonParseTime);
+		filter.push_back(metrics->filterTime);
+		markdown.push_back(metrics->markdownTime);
+		listener.push_back(metrics->listenerTime);
+		allocations.count += allocationsAfter.count - allocationsBefore.count;
+		allocations.bytes += allocationsAfter.bytes - allocationsBefore.bytes;
+		lastMetrics = *metrics;
+		newerReleases = checkListener.newerReleases;
+	}
+
+	QJsonObject result{
+		{ "releases", scenario.releaseCount },
+		{ "newerReleases", static_cast<qint64>(newerReleases) },
+		{ "releaseNotesRendered", scenario.allNewer },
+		{ "orderedFeedStopThreshold", scenario.orderedFeedStopThreshold },
+		{ "pageSize", scenario.pageSize },
+		{ "releaseCache", scenario.releaseCache },
+		{ "sharedConnection", scenario.sharedConnection },
+		{ "network", toJson(scenario.network) },
+		{ "replyBytes", json.size() },
+		{ "iterations", static_cast<qint64>(latencies.size()) },
+		{ "latencyNs", toJson(statistics(latencies)) },
+		{ "phasesMedianNs", QJsonObject{
+			{ "firstByte", statistics(firstByte).median },
+			{ "lastByte", statistics(lastByte).median },
+			{ "jsonParse", statistics(jsonParse).median },
+			{ "filter", statistics(filter).median },
+			{ "markdown", statistics(markdown).median },
+			{ "listener", statistics(listener).median }
+		} },
+		{ "lastMetrics", QJsonDocument::fromJson(lastMetrics.toJson()).object() },
+		{ "allocationsPerCheck", latencies.empty() ? 0 : static_cast<qint64>(allocations.count / latencies.size()) },
+		{ "allocatedBytesPerCheck", latencies.empty() ? 0 : static_cast<qint64>(allocations.bytes / latencies.size()) },
+		{ "peakRssBytes", static_cast<qint64>(MemoryStats::peakRss()) },
+		{ "peakRssIsPerScenario", peakRssReset }
+	};
+
+	if (!error.isEmpty())
+		result["error"] = error;
+
+	return result;
+}
+
+// Waits for the end of a download (or of the update check before it). Verification is required, and either nothing has been published
+// for the asset or the published SHA-256 is wrong, so the updater stops with an error as soon as the file is complete, before anything is installed.
+class DownloadListener final : public CAutoUpdaterGithub::UpdateStatusListener
+{
+public:
+	explicit DownloadListener(QEventLoop& loop) : _loop(loop) {}
+
+	void onUpdateAvailable(const CAutoUpdaterGithub::ChangeLog&) override
+	{
+		_loop.quit();
+	}
+
+	void onUpdateDownloadProgress(float) override {}
+	void onUpdateDownloadFinished() override {}
+
+	void onUpdateError(const QString& errorMessage) override
+	{
+		lastError = errorMessage;
+		_loop.quit();
+	}
+
+public:
+	QString lastError;
+
+private:
+	QEventLoop& _loop;
+};
+
+struct DownloadScenario {
+	int segmentCount = 1; // CAutoUpdaterGithub::setDownloadSegmentation()
+	CAutoUpdaterGithub::DownloadIoStrategy ioStrategy = CAutoUpdaterGithub::DownloadIoStrategy::Preallocated;
+	bool rangeSupport = true;
+	// The release publishes a SHA-256 for the asset, so the download is hashed as it's written (the published one is wrong, to stop the
+	// updater once the hashes have been compared). Otherwise the updater has nothing to check the hash against and doesn't compute it.
+	bool publishedHash = false;
+	NetworkConditions network;
+};
+
+static QString toString(CAutoUpdaterGithub::DownloadIoStrategy ioStrategy)
+{
+	switch (ioStrategy)
+	{
+	case CAutoUpdaterGithub::DownloadIoStrategy::Append:
+		return "append";
+	case CAutoUpdaterGithub::DownloadIoStrategy::Preallocated:
+		return "preallocated";
+	case CAutoUpdaterGithub::DownloadIoStrategy::MemoryMapped:
+		return "memoryMapped";
+	}
+
+	return {};
+}
+
+static QJsonObject benchmarkDownload(CMockGithubServer& server, const DownloadScenario& scenario, qint64 assetSize, int iterations)
+{
+	const QString assetName = "App-bench" + QString(UPDATE_FILE_EXTENSION);
+	configureServer(server, [&](CMockGithubServer& s) {
+		s.setRangeSupport(scenario.rangeSupport);
+		s.setLatency(scenario.network.latency);
+		s.setBandwidthLimit(scenario.network.bandwidthLimit);
+		if (scenario.publishedHash)
+			s.setReleasesJson(ReleaseFixtures::releaseJson("9.9.9", { { assetName.toStdString(), s.assetUrl(assetName).toStdString(), "sha256:" + std::string(64, '0') } }));
+	});
+
+	const QString updateFilePath = QDir::tempPath() + '/' + QCoreApplication::applicationName() + UPDATE_FILE_EXTENSION;
+	std::vector<qint64> durations;
+	MemoryStats::Allocations allocations;
+	QString error;
+	for (int i = 0; i < iterations && error.isEmpty(); ++i)
+	{
+		QFile::remove(updateFilePath);
+		QFile::remove(updateFilePath + ".journal");
+
+		QEventLoop loop;
+		DownloadListener downloadListener(loop);
+		CAutoUpdaterGithub updater(ReleaseFixtures::repositoryName, QString::fromLatin1(ReleaseFixtures::oldestVersion));
+		updater.setApiBaseUrl(server.baseUrl());
+		updater.setUpdateStatusListener(&downloadListener);
+		updater.setReleaseCacheFilePath({});
+		updater.setDeltaUpdateBaseFile({});
+		updater.setDownloadSegmentation(scenario.segmentCount, assetSize / 8);
+		updater.setDownloadIoStrategy(scenario.ioStrategy);
+		updater.setUpdateVerificationRequired(true);
+		QTimer::singleShot(checkTimeoutMs, &loop, [&downloadListener] { downloadListener.onUpdateError("Timed out"); });
+
+		// Only the releases with the hash are known to the updater after a check
+		if (scenario.publishedHash)
+		{
+			updater.checkForUpdates();
+			loop.exec();
+			if (!downloadListener.lastError.isEmpty())
+			{
+				error = downloadListener.lastError;
+				break;
+			}
+		}
+
+		const MemoryStats::Allocations allocationsBefore = MemoryStats::allocations();
+		QElapsedTimer timer;
+		timer.start();
+		updater.downloadAndInstallUpdate(server.assetUrl(assetName));
+		loop.exec();
+		durations.push_back(timer.nsecsElapsed());
+		const MemoryStats::Allocations allocationsAfter = MemoryStats::allocations();
+		allocations.count += allocationsAfter.count - allocationsBefore.count;
+		allocations.bytes += allocationsAfter.bytes - allocationsBefore.bytes;
+
+		// The download itself has succeeded if the whole file is there and the journal has been removed, or if it's been hashed and rejected
+		const bool downloaded = scenario.publishedHash
+			? downloadListener.lastError.startsWith("The downloaded update is corrupted")
+			: QFileInfo(updateFilePath).size() == assetSize && !QFileInfo::exists(updateFilePath + ".journal");
+		if (!downloaded)
+			error = downloadListener.lastError;
+	}
+
+	QFile::remove(updateFilePath);
+	QFile::remove(updateFilePath + ".journal");
+
+	const Statistics s = statistics(durations);
+	QJsonObject result{
+		{ "bytes", assetSize },
+		{ "segments", scenario.segmentCount },
+		{ "ioStrategy", toString(scenario.ioStrategy) },
+		{ "rangeSupport", scenario.rangeSupport },
+		{ "hashed", scenario.publishedHash },
+		{ "network", toJson(scenario.network) },
+		{ "iterations", static_cast<qint64>(durations.size()) },
+		{ "timeNs", toJson(s) },
+		{ "megabytesPerSecond", s.median > 0 ? static_cast<double>(assetSize) * 1000.0 / static_cast<double>(s.median) : 0.0 },
+		// The whole process, the mock server's thread included
+		{ "allocationsPerDownload", durations.empty() ? 0 : static_cast<qint64>(allocations.count / durations.size()) },
+		{ "allocatedBytesPerDownload", durations.empty() ? 0 : static_cast<qint64>(allocations.bytes / durations.size()) }
+	};
+
+	if (!error.isEmpty())
+		result["error"] = error;
+
+	return result;
+}
+
+// maddy on its own, over the release notes corpus: every note converted with a reused parser (as VersionEntry::versionChangesHtml() does) and with a new one
+static QJsonObject benchmarkMarkdown(int iterations)
+{
+	const auto& corpus = ReleaseFixtures::markdownCorpus();
+	const int repetitions = std::max(iterations * 50, 1);
+
+	QJsonArray notes;
+	qint64 corpusBytes = 0, corpusTime = 0;
+	maddy::Parser reusedParser;
+	for (const std::string& note : corpus)
+	{
+		std::vector<qint64> reusedSamples, newParserSamples;
+		const MemoryStats::Allocations allocationsBefore = MemoryStats::allocations();
+		size_t outputSize = 0;
+		for (int i = 0; i < repetitions; ++i)
+		{
+			QElapsedTimer timer;
+			timer.start();
+			std::istringstream input{ note };
+			outputSize = reusedParser.Parse(input).size();
+			reusedSamples.push_back(timer.nsecsElapsed());
+		}
+		const MemoryStats::Allocations allocationsAfter = MemoryStats::allocations();
+
+		for (int i = 0; i < repetitions; ++i)
+		{
+			QElapsedTimer timer;
+			timer.start();
+			maddy::Parser parser;
+			std::istringstream input{ note };
+			(void)parser.Parse(input);
+			newParserSamples.push_back(timer.nsecsElapsed());
+		}
+		const MemoryStats::Allocations newParserAllocationsAfter = MemoryStats::allocations();
+
+		const Statistics reused = statistics(reusedSamples);
+		corpusBytes += static_cast<qint64>(note.size());
+		corpusTime += reused.median;
+		notes.append(QJsonObject{
+			{ "inputBytes", static_cast<qint64>(note.size()) },
+			{ "outputBytes", static_cast<qint64>(outputSize) },
+			{ "reusedParserNs", toJson(reused) },
+			{ "newParserNs", toJson(statistics(newParserSamples)) },
+			{ "allocationsPerConversion", static_cast<qint64>((allocationsAfter.count - allocationsBefore.count) / static_cast<uint64_t>(repetitions)) },
+			{ "newParserAllocationsPerConversion", static_cast<qint64>((newParserAllocationsAfter.count - allocationsAfter.count) / static_cast<uint64_t>(repetitions)) }
+		});
+	}
+
+	// Deeply nested lists and quotes, where every level adds a child parser
+	QJsonArray nested;
+	for (const int depth : { 8, 32 })
+	{
+		const std::string note = ReleaseFixtures::nestedMarkdown(depth);
+		std::vector<qint64> samples;
+		const MemoryStats::Allocations allocationsBefore = MemoryStats::allocations();
+		for (int i = 0; i < repetitions; ++i)
+		{
+			QElapsedTimer timer;
+			timer.start();
+			std::istringstream input{ note };
+			(void)reusedParser.Parse(input);
+			samples.push_back(timer.nsecsElapsed());
+		}
+		const MemoryStats::Allocations allocationsAfter = MemoryStats::allocations();
+
+		nested.append(QJsonObject{
+			{ "depth", depth },
+			{ "inputBytes", static_cast<qint64>(note.size()) },
+			{ "reusedParserNs", toJson(statistics(samples)) },
+			{ "allocationsPerConversion", static_cast<qint64>((allocationsAfter.count - allocationsBefore.count) / static_cast<uint64_t>(repetitions)) }
+		});
+	}
+
+	return {
+		{ "repetitions", repetitions },
+		{ "notes", notes },
+		{ "corpusBytes", corpusBytes },
+		{ "corpusMedianNs", corpusTime },
+		{ "megabytesPerSecond", corpusTime > 0 ? static_cast<double>(corpusBytes) * 1000.0 / static_cast<double>(corpusTime) : 0.0 },
+		{ "nested", nested }
+	};
+}
+
+// The linear inline engine against the regex-based line parsers (ParserConfig::isRegexInlineParsingEnabled) on lines made of unterminated
+// inline constructs. The regex parsers take seconds per line already at 1 KB and grow quadratically, and at 100 KB std::regex
+// runs out of stack, so they are only measured on the short lines, once.
+static QJsonArray benchmarkAdversarialInline(int iterations)
+{
+	static constexpr size_t longLineSize = 100 * 1024, shortLineSize = 1024;
+
+	const auto regexConfig = std::make_shared<maddy::ParserConfig>();
+	regexConfig->isRegexInlineParsingEnabled = true;
+	maddy::Parser linearParser, regexParser(regexConfig);
+
+	const auto parse = [](maddy::Parser& parser, const std::string& line, std::string* output = nullptr) {
+		QElapsedTimer timer;
+		timer.start();
+		std::istringstream input{ line };
+		std::string html = parser.Parse(input);
+		const qint64 time = timer.nsecsElapsed();
+		if (output)
+			*output = std::move(html);
+
+		return time;
+	};
+
+	QJsonArray results;
+	const auto longLines = ReleaseFixtures::adversarialInlineLines(longLineSize), shortLines = ReleaseFixtures::adversarialInlineLines(shortLineSize);
+	for (size_t i = 0; i < longLines.size(); ++i)
+	{
+		std::vector<qint64> longLineSamples, shortLineSamples;
+		for (int run = 0; run < iterations; ++run)
+		{
+			longLineSamples.push_back(parse(linearParser, longLines[i].second));
+			shortLineSamples.push_back(parse(linearParser, shortLines[i].second));
+		}
+
+		std::string linearHtml, regexHtml;
+		(void)parse(linearParser, shortLines[i].second, &linearHtml);
+		const qint64 regexTime = parse(regexParser, shortLines[i].second, &regexHtml);
+
+		results.append(QJsonObject{
+			{ "construct", QString::fromStdString(longLines[i].first) },
+			{ "linearNs", QJsonObject{
+				{ "100KB", toJson(statistics(longLineSamples)) },
+				{ "1KB", toJson(statistics(shortLineSamples)) }
+			} },
+			{ "regexNs", QJsonObject{ { "1KB", regexTime } } },
+			{ "sameHtml", linearHtml == regexHtml }
+		});
+	}
+
+	return results;
+}
+
+// CVersionKey against the QCollator comparison the updater falls back to for version strings it can't parse,
+// over versions as projects tag them: plain, with a fourth segment, and pre-releases
+static QJsonObject benchmarkVersionComparison(int iterations)
+{
+	QStringList versions;
+	for (int i = 0; i < 1000; ++i)
+	{
+		QString version = QString::number(i / 100) + '.' + QString::number(i / 10 % 10) + '.' + QString::number(i % 10);
+		if (i % 7 == 0)
+			version += ".1";
+		else if (i % 5 == 0)
+			version += "-beta." + QString::number(i % 3 + 1);
+		else if (i % 11 == 0)
+			version += "rc2";
+		versions.push_back(version);
+	}
+
+	// Every version against 100 others
+	static constexpr int comparisonsPerVersion = 100;
+	const qint64 comparisons = static_cast<qint64>(versions.size()) * comparisonsPerVersion;
+	const int runs = std::max(iterations, 5);
+	const auto comparisonsPerSecond = [comparisons](qint64 ns) {
+		return ns > 0 ? static_cast<double>(comparisons) * 1e9 / static_cast<double>(ns) : 0.0;
+	};
+
+	std::vector<qint64> parseSamples, keySamples, collatorSamples;
+	std::vector<CVersionKey> keys;
+	int checksum = 0; // Keeps the comparisons from being optimized away
+	for (int run = 0; run < runs; ++run)
+	{
+		QElapsedTimer timer;
+		timer.start();
+		keys.clear();
+		for (const QString& version : versions)
+			keys.emplace_back(version);
+		parseSamples.push_back(timer.nsecsElapsed());
+
+		timer.start();
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			for (size_t j = 1; j <= comparisonsPerVersion; ++j)
+				checksum += keys[i] < keys[(i + j * 7) % keys.size()];
+		}
+		keySamples.push_back(timer.nsecsElapsed());
+
+		// What the fallback does for every comparison
+		timer.start();
+		for (qsizetype i = 0; i < versions.size(); ++i)
+		{
+			for (qsizetype j = 1; j <= comparisonsPerVersion; ++j)
+			{
+				thread_local QCollator collator;
+				collator.setNumericMode(true);
+				collator.setCaseSensitivity(Qt::CaseInsensitive);
+				checksum += collator.compare(versions[i], versions[(i + j * 7) % versions.size()]) < 0;
+			}
+		}
+		collatorSamples.push_back(timer.nsecsElapsed());
+	}
+
+	const Statistics keyStatistics = statistics(keySamples), collatorStatistics = statistics(collatorSamples);
+	return {
+		{ "versions", static_cast<qint64>(versions.size()) },
+		{ "comparisons", comparisons },
+		{ "runs", runs },
+		{ "keyConstructionNs", toJson(statistics(parseSamples)) },
+		{ "versionKeyNs", toJson(keyStatistics) },
+		{ "collatorNs", toJson(collatorStatistics) },
+		{ "versionKeyComparisonsPerSecond", comparisonsPerSecond(keyStatistics.median) },
+		{ "collatorComparisonsPerSecond", comparisonsPerSecond(collatorStatistics.median) },
+		{ "checksum", checksum }
+	};
+}
+
+#ifndef _WIN32
+// A synthetic application bundle: a large executable, a few frameworks and thousands of small resources
+static qint64 createSyntheticBundle(const QString& path)
+{
+	const auto writeFile = [](const QString& filePath, qint64 size) {
+		QFile file(filePath);
+		if (!file.open(QFile::WriteOnly))
+			return qint64{0};
+
+		QByteArray block(64 * 1024, '\0');
+		for (int i = 0; i < block.size(); ++i)
+			block[i] = static_cast<char>((i * 131 + size) & 0xFF);
+
+		for (qint64 written = 0; written < size;)
+			written += file.write(block.constData(), std::min(static_cast<qint64>(block.size()), size - written));
+
+		return size;
+	};
+
+	qint64 totalSize = 0;
+	QDir().mkpath(path + "/Contents/MacOS");
+	totalSize += writeFile(path + "/Contents/MacOS/App", 64 * 1024 * 1024);
+	for (int i = 0; i < 16; ++i)
+	{
+		const QString framework = path + "/Contents/Frameworks/Qt" + QString::number(i) + ".framework/Versions/A";
+		QDir().mkpath(framework);
+		totalSize += writeFile(framework + "/Qt" + QString::number(i), 4 * 1024 * 1024);
+	}
+
+	for (int i = 0; i < 4000; ++i)
+	{
+		const QString directory = path + "/Contents/Resources/" + QString::number(i % 40);
+		QDir().mkpath(directory);
+		totalSize += writeFile(directory + '/' + QString::number(i) + ".png", 4 * 1024 + (i % 16) * 1024);
+	}
+
+	return totalSize;
+}
+
+static QJsonArray benchmarkDirectoryCopier(int iterations)
+{
+	QJsonArray results;
+	QTemporaryDir workDirectory;
+	if (!workDirectory.isValid())
+		return results;
+
+	const QString source = workDirectory.filePath("App.app"), target = workDirectory.filePath("Copy.app");
+	const qint64 totalSize = createSyntheticBundle(source);
+	const int runs = std::max(iterations / 5, 3);
+
+	for (const int threadCount : { 1, 0 })
+	{
+		CDirectoryCopier copier(threadCount);
+		std::vector<qint64> samples;
+		QString error;
+		for (int i = 0; i < runs && error.isEmpty(); ++i)
+		{
+			QDir(target).removeRecursively();
+			QElapsedTimer timer;
+			timer.start();
+			if (!copier.copy(source, target))
+				error = copier.errorString();
+
+			samples.push_back(timer.nsecsElapsed());
+		}
+
+		const Statistics s = statistics(samples);
+		QJsonObject result{
+			{ "threads", threadCount > 0 ? threadCount : static_cast<int>(QThread::idealThreadCount()) },
+			{ "files", 1 + 16 + 4000 },
+			{ "bytes", totalSize },
+			{ "timeNs", toJson(s) },
+			{ "megabytesPerSecond", s.median > 0 ? static_cast<double>(totalSize) * 1000.0 / static_cast<double>(s.median) : 0.0 }
+		};
+
+		if (!error.isEmpty())
+			result["error"] = error;
+
+		results.append(result);
+	}
+
+	QDir(target).removeRecursively();
+	return results;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("autoupdater-bench");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Benchmarks of the updater core. The results are written as JSON.");
+	parser.addHelpOption();
+	const QCommandLineOption iterationsOption("iterations", "Measured iterations per scenario (default 20).", "count", "20");
+	const QCommandLineOption outputOption("output", "Write the results to this file instead of stdout.", "file");
+	const QCommandLineOption skipCopierOption("skip-copier", "Skip the directory copier benchmark, which writes about 200 MB to the temporary directory.");
+	parser.addOptions({ iterationsOption, outputOption, skipCopierOption });
+	parser.process(app);
+
+	const int iterations = std::max(parser.value(iterationsOption).toInt(), 1);
+
+	// The server has a thread of its own, so that serving doesn't show up in the client-side timings
+	QThread serverThread;
+	serverThread.start();
+	auto* server = new CMockGithubServer(ReleaseFixtures::repositoryName);
+	server->moveToThread(&serverThread);
+	bool listening = false;
+	QMetaObject::invokeMethod(server, [server, &listening] { listening = server->start(); }, Qt::BlockingQueuedConnection);
+	if (!listening)
+	{
+		qCritical() << "Failed to start the mock GitHub server";
+		return 1;
+	}
+
+	// A slow connection: a transatlantic round trip and 10 MB/s
+	static constexpr NetworkConditions slowNetwork{ 50, 10 * 1000 * 1000 };
+
+	QJsonArray updateCheck;
+	for (const int releaseCount : { 10, 100, 1000 })
+	{
+		for (const bool allNewer : { false, true })
+			updateCheck.append(benchmarkUpdateCheck(*server, { releaseCount, allNewer }, iterations));
+	}
+
+	// The ordered feed stopping after the newest releases against the full scan, on a fast and on a slow network
+	for (const auto& network : { NetworkConditions{}, slowNetwork })
+	{
+		for (const int threshold : { 0, 10 })
+			updateCheck.append(benchmarkUpdateCheck(*server, { .releaseCount = 1000, .orderedFeedStopThreshold = threshold, .network = network }, iterations));
+	}
+
+	// The network paths: pagination, conditional requests, connection reuse and a slow network
+	updateCheck.append(benchmarkUpdateCheck(*server, { .releaseCount = 1000, .allNewer = false, .pageSize = 100 }, iterations));
+	updateCheck.append(benchmarkUpdateCheck(*server, { .releaseCount = 1000, .allNewer = true, .pageSize = 100 }, iterations));
+	updateCheck.append(benchmarkUpdateCheck(*server, { .releaseCount = 1000, .releaseCache = true }, iterations));
+	updateCheck.append(benchmarkUpdateCheck(*server, { .releaseCount = 100, .sharedConnection = true }, iterations));
+	updateCheck.append(benchmarkUpdateCheck(*server, { .releaseCount = 100, .network = slowNetwork }, iterations));
+	updateCheck.append(benchmarkUpdateCheck(*server, { .releaseCount = 100, .pageSize = 30, .network = slowNetwork }, iterations));
+
+	// A 32 MB update, over one and over several connections, on a fast and on a slow network
+	static constexpr qint64 assetSize = 32 * 1024 * 1024;
+	QByteArray asset(assetSize, '\0');
+	for (qint64 i = 0; i < assetSize; ++i)
+		asset[i] = static_cast<char>((i * 2654435761u) >> 24);
+	configureServer(*server, [&asset](CMockGithubServer& s) { s.addAsset("App-bench" + QString(UPDATE_FILE_EXTENSION), std::move(asset)); });
+
+	const int downloadIterations = std::max(iterations / 5, 3);
+	QJsonArray download;
+	for (const auto& network : { NetworkConditions{}, slowNetwork })
+	{
+		download.append(benchmarkDownload(*server, { .segmentCount = 1, .network = network }, assetSize, downloadIterations));
+		download.append(benchmarkDownload(*server, { .segmentCount = 4, .network = network }, assetSize, downloadIterations));
+	}
+	// The other ways of writing the file. Segmented downloads always write at offsets, Append is the same as Preallocated there.
+	download.append(benchmarkDownload(*server, { .segmentCount = 1, .ioStrategy = CAutoUpdaterGithub::DownloadIoStrategy::Append }, assetSize, downloadIterations));
+	for (const int segmentCount : { 1, 4 })
+		download.append(benchmarkDownload(*server, { .segmentCount = segmentCount, .ioStrategy = CAutoUpdaterGithub::DownloadIoStrategy::MemoryMapped }, assetSize, downloadIterations));
+	// Segmentation falls back to a single connection without range support
+	download.append(benchmarkDownload(*server, { .segmentCount = 4, .rangeSupport = false }, assetSize, downloadIterations));
+
+	// The cost of hashing the download as it's written, on a 128 MB update: with and without a published hash to check against
+	static constexpr qint64 largeAssetSize = 128 * 1024 * 1024;
+	QByteArray largeAsset(largeAssetSize, '\0');
+	for (qint64 i = 0; i < largeAssetSize; ++i)
+		largeAsset[i] = static_cast<char>((i * 2654435761u) >> 24);
+	configureServer(*server, [&largeAsset](CMockGithubServer& s) { s.addAsset("App-bench" + QString(UPDATE_FILE_EXTENSION), std::move(largeAsset)); });
+
+	const QJsonObject unhashed = benchmarkDownload(*server, { .publishedHash = false }, largeAssetSize, downloadIterations);
+	const QJsonObject hashed = benchmarkDownload(*server, { .publishedHash = true }, largeAssetSize, downloadIterations);
+	const auto medianTime = [](const QJsonObject& result) { return result["timeNs"].toObject()["median"].toDouble(); };
+	static constexpr qint64 downloadChunkSize = 256 * 1024; // The default download buffer size
+	const double hashingCost = medianTime(hashed) - medianTime(unhashed);
+	const QJsonObject downloadHashing{
+		{ "unhashed", unhashed },
+		{ "hashed", hashed },
+		{ "chunkBytes", downloadChunkSize },
+		{ "hashingNsPerChunk", hashingCost / static_cast<double>(largeAssetSize / downloadChunkSize) },
+		{ "hashingShareOfTransfer", medianTime(hashed) > 0.0 ? hashingCost / medianTime(hashed) : 0.0 }
+	};
+
+	qint64 requestsServed = 0;
+	QMetaObject::invokeMethod(server, [server, &requestsServed] {
+		requestsServed = server->requestsServed();
+		delete server;
+	}, Qt::BlockingQueuedConnection);
+	serverThread.quit();
+	serverThread.wait();
+
+	QJsonObject results{
+		{ "format", 1 },
+		{ "qtVersion", qVersion() },
+		{ "platform", QSysInfo::prettyProductName() },
+		{ "cpuArchitecture", QSysInfo::currentCpuArchitecture() },
+		{ "logicalCores", QThread::idealThreadCount() },
+		{ "allocationsIncludeMalloc", MemoryStats::countsMalloc() },
+		{ "requestsServed", requestsServed },
+		{ "updateCheck", updateCheck },
+		{ "download", download },
+		{ "downloadHashing", downloadHashing },
+		{ "markdown", benchmarkMarkdown(iterations) },
+		{ "adversarialInline", benchmarkAdversarialInline(iterations) },
+		{ "versionComparison", benchmarkVersionComparison(iterations) }
+	};
+
+#ifndef _WIN32
+	if (!parser.isSet(skipCopierOption))
+		results["directoryCopier"] = benchmarkDirectoryCopier(iterations);
+#endif
+
+	const QByteArray json = QJsonDocument(results).toJson(QJsonDocument::Indented);
+	if (!parser.isSet(outputOption))
+	{
+		fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+		return 0;
+	}
+
+	QFile output(parser.value(outputOption));
+	if (!output.open(QFile::WriteOnly) || output.write(json) != json.size())
+	{
+		qCritical() << "Failed to write" << output.fileName();
+		return 1;
+	}
+
+	return 0;
+}
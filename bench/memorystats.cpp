@@ -0,0 +1,152 @@
+#include "memorystats.hpp"
+
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <stdlib.h>
+
+#if defined _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#elif defined __linux__
+#include <stdio.h>
+#include <string.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static std::atomic<uint64_t> allocationCount{ 0 };
+static std::atomic<uint64_t> allocatedBytes{ 0 };
+
+static void countAllocation(size_t size) noexcept
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+#if defined __GLIBC__
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+// Replace the ones from libc for the whole process, operator new and the Qt containers end up here as well. free() stays as it is.
+void* malloc(size_t size) noexcept
+{
+	countAllocation(size);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+	countAllocation(count * size);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept
+{
+	countAllocation(size);
+	return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#else
+void* operator new(size_t size)
+{
+	countAllocation(size);
+	if (void* p = ::malloc(size > 0 ? size : 1))
+		return p;
+
+	throw std::bad_alloc{};
+}
+
+void* operator new[](size_t size)
+{
+	return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	::free(p);
+}
+#endif
+
+MemoryStats::Allocations MemoryStats::allocations()
+{
+	return { allocationCount.load(std::memory_order_relaxed), allocatedBytes.load(std::memory_order_relaxed) };
+}
+
+bool MemoryStats::countsMalloc()
+{
+#if defined __GLIBC__
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t MemoryStats::peakRss()
+{
+#if defined _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	return ::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#elif defined __linux__
+	// VmHWM, unlike getrusage(), follows resetPeakRss()
+	FILE* status = ::fopen("/proc/self/status", "r");
+	if (!status)
+		return 0;
+
+	uint64_t peakKb = 0;
+	char line[256];
+	while (::fgets(line, sizeof(line), status))
+	{
+		if (::strncmp(line, "VmHWM:", 6) == 0)
+		{
+			peakKb = ::strtoull(line + 6, nullptr, 10);
+			break;
+		}
+	}
+
+	::fclose(status);
+	return peakKb * 1024;
+#else
+	struct rusage usage;
+	if (::getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined __APPLE__
+	return static_cast<uint64_t>(usage.ru_maxrss); // Bytes
+#else
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // Kilobytes
+#endif
+#endif
+}
+
+bool MemoryStats::resetPeakRss()
+{
+#if defined __linux__
+	FILE* clearRefs = ::fopen("/proc/self/clear_refs", "w");
+	if (!clearRefs)
+		return false;
+
+	const bool reset = ::fputs("5", clearRefs) >= 0;
+	return ::fclose(clearRefs) == 0 && reset;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace MemoryStats {
+
+// Counted by the replacement allocation functions built into the benchmark: malloc() and friends on glibc, which covers
+// both the C++ and the Qt containers, and the global operator new elsewhere
+struct Allocations {
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+[[nodiscard]] Allocations allocations();
+// Whether malloc() is counted, or only operator new
+[[nodiscard]] bool countsMalloc();
+
+// The peak resident set size of the process so far, in bytes. resetPeakRss() starts over from the current size where the OS allows (Linux), returns false otherwise.
+[[nodiscard]] uint64_t peakRss();
+bool resetPeakRss();
+
+} // namespace MemoryStats
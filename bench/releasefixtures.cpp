@@ -0,0 +1,306 @@
+#include "releasefixtures.hpp"
+
+#include <iterator>
+#include <stdint.h>
+
+static std::string versionString(int releaseNumber)
+{
+	return std::to_string(releaseNumber / 100) + '.' + std::to_string(releaseNumber / 10 % 10) + '.' + std::to_string(releaseNumber % 10);
+}
+
+static void appendJsonString(std::string& json, const std::string& value)
+{
+	static constexpr char hexDigits[] = "0123456789abcdef";
+
+	json += '"';
+	for (const char c : value)
+	{
+		switch (c)
+		{
+		case '"': json += "\\\""; break;
+		case '\\': json += "\\\\"; break;
+		case '\n': json += "\\n"; break;
+		case '\r': json += "\\r"; break;
+		case '\t': json += "\\t"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+			{
+				json += "\\u00";
+				json += hexDigits[c >> 4];
+				json += hexDigits[c & 0xF];
+			}
+			else
+				json += c;
+		}
+	}
+	json += '"';
+}
+
+// A user object as it appears in "author" and "uploader"
+static std::string userJson(const std::string& login, int id)
+{
+	const std::string url = "https://api.github.com/users/" + login;
+	return R"({"login":")" + login + R"(","id":)" + std::to_string(id) + R"(,"node_id":"MDQ6VXNlcjE)" + std::to_string(id)
+		+ R"(","avatar_url":"https://avatars.githubusercontent.com/u/)" + std::to_string(id) + R"(?v=4","gravatar_id":"","url":")" + url
+		+ R"(","html_url":"https://github.com/)" + login + R"(","followers_url":")" + url + R"(/followers","following_url":")" + url
+		+ R"(/following{/other_user}","gists_url":")" + url + R"(/gists{/gist_id}","starred_url":")" + url + R"(/starred{/owner}{/repo}","subscriptions_url":")"
+		+ url + R"(/subscriptions","organizations_url":")" + url + R"(/orgs","repos_url":")" + url + R"(/repos","events_url":")" + url
+		+ R"(/events{/privacy}","received_events_url":")" + url + R"(/received_events","type":"User","user_view_type":"public","site_admin":false})";
+}
+
+// A fake but well-formed SHA-256, different for every asset
+static std::string assetDigest(uint64_t seed)
+{
+	static constexpr char hexDigits[] = "0123456789abcdef";
+
+	std::string digest;
+	for (int i = 0; i < 64; ++i)
+	{
+		seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+		digest += hexDigits[seed >> 60];
+	}
+
+	return digest;
+}
+
+QByteArray ReleaseFixtures::releasesJson(int releaseCount)
+{
+	static const char* const assetSuffixes[] = { ".exe", ".dmg", ".AppImage", ".AppImage.zsync", ".tar.gz" };
+
+	const auto& corpus = markdownCorpus();
+	const std::string repoUrl = std::string("https://api.github.com/repos/") + repositoryName;
+	const std::string htmlRepoUrl = std::string("https://github.com/") + repositoryName;
+	const std::string author = userJson("bench-maintainer", 1000001), uploader = userJson("github-actions[bot]", 41898282);
+
+	std::string json = "[";
+	for (int i = 0; i < releaseCount; ++i)
+	{
+		const int releaseNumber = releaseCount - i; // Newest first
+		const std::string version = versionString(releaseNumber), tag = 'v' + version, id = std::to_string(100000000 + releaseNumber);
+		const std::string date = "20" + std::to_string(10 + releaseNumber % 15) + "-0" + std::to_string(1 + releaseNumber % 9) + "-1" + std::to_string(releaseNumber % 10) + "T12:34:56Z";
+
+		if (i > 0)
+			json += ',';
+
+		json += R"({"url":")" + repoUrl + "/releases/" + id + R"(","assets_url":")" + repoUrl + "/releases/" + id + R"(/assets","upload_url":"https://uploads.github.com/repos/)"
+			+ repositoryName + "/releases/" + id + R"(/assets{?name,label}","html_url":")" + htmlRepoUrl + "/releases/tag/" + tag + R"(","id":)" + id
+			+ R"(,"author":)" + author + R"(,"node_id":"RE_kwDOAbCdEf4)" + id + R"(","tag_name":")" + tag + R"(","target_commitish":"master","name":")"
+			+ "App " + version + R"(","draft":false,"immutable":false,"prerelease":)" + (releaseNumber % 7 == 0 ? "true" : "false")
+			+ R"(,"created_at":")" + date + R"(","updated_at":")" + date + R"(","published_at":")" + date + R"(","assets":[)";
+
+		std::string sha256Sums;
+		for (size_t a = 0; a < std::size(assetSuffixes); ++a)
+		{
+			const std::string name = "App-" + version + assetSuffixes[a], assetId = std::to_string(200000000 + releaseNumber * 10 + static_cast<int>(a));
+			const std::string digest = assetDigest(static_cast<uint64_t>(releaseNumber) * 16 + a);
+			sha256Sums += digest + "  " + name + '\n';
+
+			json += R"({"url":")" + repoUrl + "/releases/assets/" + assetId + R"(","id":)" + assetId + R"(,"node_id":"RA_kwDOAbCdEf4)" + assetId
+				+ R"(","name":")" + name + R"(","label":"","uploader":)" + uploader + R"(,"content_type":"application/octet-stream","state":"uploaded","size":)"
+				+ std::to_string(40000000 + releaseNumber * 1000 + static_cast<int>(a)) + R"(,"digest":"sha256:)" + digest + R"(","download_count":)"
+				+ std::to_string(releaseNumber * 37 % 5000) + R"(,"created_at":")" + date + R"(","updated_at":")" + date + R"(","browser_download_url":")"
+				+ htmlRepoUrl + "/releases/download/" + tag + '/' + name + R"("},)";
+		}
+
+		json += R"({"url":")" + repoUrl + "/releases/assets/" + id + R"(9","id":)" + id + R"(9,"name":"SHA256SUMS","label":"","uploader":)" + uploader
+			+ R"(,"content_type":"text/plain","state":"uploaded","size":)" + std::to_string(sha256Sums.size()) + R"(,"digest":null,"download_count":3,"created_at":")"
+			+ date + R"(","updated_at":")" + date + R"(","browser_download_url":")" + htmlRepoUrl + "/releases/download/" + tag + R"(/SHA256SUMS"}],"tarball_url":")"
+			+ repoUrl + "/tarball/" + tag + R"(","zipball_url":")" + repoUrl + "/zipball/" + tag + R"(","body":)";
+
+		appendJsonString(json, corpus[static_cast<size_t>(releaseNumber) % corpus.size()]);
+		json += R"(,"reactions":{"url":")" + repoUrl + "/releases/" + id + R"(/reactions","total_count":3,"+1":2,"-1":0,"laugh":0,"hooray":1,"confused":0,"heart":0,"rocket":0,"eyes":0}})";
+	}
+	json += ']';
+
+	return QByteArray::fromStdString(json);
+}
+
+QByteArray ReleaseFixtures::releaseJson(const std::string& version, const std::vector<Asset>& assets)
+{
+	const std::string htmlRepoUrl = std::string("https://github.com/") + repositoryName;
+
+	std::string json = R"([{"html_url":")" + htmlRepoUrl + "/releases/tag/v" + version + R"(","tag_name":"v)" + version + R"(","name":"App )" + version
+		+ R"(","draft":false,"prerelease":false,"created_at":"2024-10-01T12:00:00Z","assets":[)";
+	for (size_t i = 0; i < assets.size(); ++i)
+	{
+		if (i > 0)
+			json += ',';
+
+		json += R"({"name":)";
+		appendJsonString(json, assets[i].name);
+		json += R"(,"digest":)";
+		if (assets[i].digest.empty())
+			json += "null";
+		else
+			appendJsonString(json, assets[i].digest);
+		json += R"(,"browser_download_url":)";
+		appendJsonString(json, assets[i].url);
+		json += '}';
+	}
+	json += R"(],"body":"A release for the download benchmarks"}])";
+
+	return QByteArray::fromStdString(json);
+}
+
+std::string ReleaseFixtures::newestVersion(int releaseCount)
+{
+	return versionString(releaseCount);
+}
+
+const std::vector<std::string>& ReleaseFixtures::markdownCorpus()
+{
+	static const std::vector<std::string> corpus = {
+		// GitHub's generated release notes
+		"## What's Changed\n"
+		"* Fix crash when the configuration file is empty by @alice in https://github.com/bench/app/pull/1201\n"
+		"* Bump actions/checkout from 3 to 4 by @dependabot in https://github.com/bench/app/pull/1203\n"
+		"* Add `--portable` command line switch by @bob in https://github.com/bench/app/pull/1205\n"
+		"* Speed up directory listing on network drives by @carol in https://github.com/bench/app/pull/1207\n"
+		"* Update translations (de, fr, ja, pt-BR) by @translator-bot in https://github.com/bench/app/pull/1210\n"
+		"* Remember the window position on multi-monitor setups by @dave in https://github.com/bench/app/pull/1212\n"
+		"\n"
+		"## New Contributors\n"
+		"* @dave made their first contribution in https://github.com/bench/app/pull/1212\n"
+		"\n"
+		"**Full Changelog**: https://github.com/bench/app/compare/v1.4.2...v1.5.0\n",
+
+		// Hand-written notes with headings and nested lists
+		"# Highlights\n"
+		"\n"
+		"This release focuses on **performance** and _stability_. Startup is about 30% faster on large folders, and the memory use while "
+		"searching has been cut in half.\n"
+		"\n"
+		"### New features\n"
+		"- Tabs can now be pinned\n"
+		"  - Pinned tabs survive restarts\n"
+		"  - Middle-click no longer closes a pinned tab\n"
+		"- Quick filter supports wildcards (`*.cpp`, `report-??.pdf`)\n"
+		"- Dark theme follows the system setting on Windows 10+ and macOS\n"
+		"\n"
+		"### Fixes\n"
+		"1. Copying files with very long paths on Windows failed silently\n"
+		"2. The progress dialog could stay open after cancelling\n"
+		"3. Sorting by size treated folders as 0 bytes\n"
+		"\n"
+		"### Known issues\n"
+		"> Renaming files on some SMB shares is still slow. A workaround is described in [the wiki](https://github.com/bench/app/wiki/SMB).\n",
+
+		// Notes with a code block and a table
+		"## Breaking changes\n"
+		"\n"
+		"The configuration format has changed. Old settings are migrated automatically, but scripts that edit the file need updating:\n"
+		"\n"
+		"```ini\n"
+		"[General]\n"
+		"; before\n"
+		"ShowHidden=1\n"
+		"; after\n"
+		"View/ShowHiddenFiles=true\n"
+		"```\n"
+		"\n"
+		"| Platform | Package | Notes |\n"
+		"|----------|---------|-------|\n"
+		"| Windows  | `.exe`  | Installer, x64 only |\n"
+		"| macOS    | `.dmg`  | Universal (Intel + Apple Silicon) |\n"
+		"| Linux    | `.AppImage` | glibc 2.31+ |\n"
+		"\n"
+		"Checksums are in `SHA256SUMS`; verify with `sha256sum -c SHA256SUMS`.\n",
+
+		// A one-liner
+		"Bugfix release: fixes a crash on startup when the last opened folder no longer exists (#1188).\n",
+
+		// Screenshots and emphasis
+		"## Screenshots\n"
+		"\n"
+		"![Main window](https://user-images.githubusercontent.com/1000001/200000001-main-window.png)\n"
+		"![Settings](https://user-images.githubusercontent.com/1000001/200000002-settings.png)\n"
+		"\n"
+		"The new settings dialog groups the options into ***General***, ***Appearance*** and ***Advanced*** pages. "
+		"Options that require a restart are marked with an asterisk, and ~~the old \"Apply\" button~~ is gone: changes take effect immediately.\n"
+		"\n"
+		"---\n"
+		"\n"
+		"Thanks to everyone who reported issues and tested the betas!\n",
+
+		// A long changelog, as projects that list every commit have
+		"## Changelog\n"
+		"\n"
+		"- 3f2a1c9 Refactor the file operation queue\n"
+		"- 8b7e6d5 Use a thread pool for thumbnail generation\n"
+		"- 1a2b3c4 Fix off-by-one in the text viewer's line numbering\n"
+		"- 5d6e7f8 Handle EINTR in the file copy loop\n"
+		"- 9a8b7c6 Avoid quadratic behavior when selecting many files\n"
+		"- 2c3d4e5 Show free space for all mounted volumes\n"
+		"- 6f7a8b9 Add keyboard shortcut for \"Copy path\"\n"
+		"- 0e1f2a3 Fix memory leak in the image viewer\n"
+		"- 4b5c6d7 Respect the system locale for date formatting\n"
+		"- 8e9f0a1 Update Qt to 6.8.1\n"
+		"- 7c8d9e0 Disable the update check in portable mode\n"
+		"- 3a4b5c6 Reduce flicker when resizing the panels\n"
+		"- 1d2e3f4 Fix tab order in the search dialog\n"
+		"- 5a6b7c8 Make the archive viewer read-only by default\n"
+		"- 9d0e1f2 Document the command line options\n"
+		"- 2b3c4d5 CI: build the AppImage on Ubuntu 20.04\n"
+		"- 6e7f8a9 CI: sign the macOS build\n"
+		"- 0c1d2e3 Fix a typo in the German translation\n"
+		"\n"
+		"See the [milestone](https://github.com/bench/app/milestone/42?closed=1) for the full list of closed issues.\n",
+	};
+
+	return corpus;
+}
+
+std::string ReleaseFixtures::nestedMarkdown(int depth)
+{
+	std::string markdown = "## Nested\n\n";
+	for (int level = 0; level < depth; ++level)
+	{
+		const std::string indentation(static_cast<size_t>(level) * 2, ' ');
+		for (int item = 1; item <= 3; ++item)
+		{
+			markdown += indentation;
+			markdown += level % 2 == 0 ? "- " : std::to_string(item) + ". ";
+			markdown += "Item " + std::to_string(item) + " on level " + std::to_string(level + 1) + ", with *emphasis* and `code`\n";
+		}
+	}
+
+	markdown += '\n';
+	for (int level = 1; level <= depth; ++level)
+	{
+		for (int i = 0; i < level; ++i)
+			markdown += "> ";
+		markdown += "A reply quoted " + std::to_string(level) + " times, with a [link](https://github.com/bench/app/issues/" + std::to_string(level) + ")\n";
+	}
+
+	// maddy only emits a quote once a blank line has ended it
+	markdown += '\n';
+	return markdown;
+}
+
+std::vector<std::pair<std::string, std::string>> ReleaseFixtures::adversarialInlineLines(size_t lineSize)
+{
+	static constexpr std::pair<const char*, const char*> patterns[] {
+		{ "emphasis", "*a " },
+		{ "strong", "**a " },
+		{ "underscores", "_a__ " },
+		{ "strikethrough", "~~a ~" },
+		{ "codeSpans", "`a ``" },
+		{ "links", "[a](" },
+		{ "images", "![a" },
+	};
+
+	std::vector<std::pair<std::string, std::string>> lines;
+	for (const auto& [name, pattern] : patterns)
+	{
+		std::string line;
+		line.reserve(lineSize + 1);
+		while (line.size() < lineSize)
+			line += pattern;
+
+		line.resize(lineSize);
+		line += '\n';
+		lines.emplace_back(name, std::move(line));
+	}
+
+	return lines;
+}
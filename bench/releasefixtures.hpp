@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+RESTORE_COMPILER_WARNINGS
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Deterministic stand-ins for the GitHub data the updater processes, so that the results can be compared between runs and machines
+namespace ReleaseFixtures {
+
+// The repository the fixtures are served for
+inline constexpr const char* repositoryName = "bench/app";
+
+// The version string of the oldest release, every other one is newer
+inline constexpr const char* oldestVersion = "0.0.1";
+
+// A /repos/<owner>/<repo>/releases reply with releaseCount releases, newest first, shaped like GitHub's: the same fields,
+// the author / uploader objects, the assets of a cross-platform application (with digests, a .zsync index and a SHA256SUMS file)
+// and the release notes from markdownCorpus(). About 12 KB per release.
+[[nodiscard]] QByteArray releasesJson(int releaseCount);
+// The version string of the newest release in releasesJson(releaseCount)
+[[nodiscard]] std::string newestVersion(int releaseCount);
+
+// A /repos/<owner>/<repo>/releases reply with a single release of version, with the given assets: name, download URL and
+// digest ("sha256:<hex>", or empty for none)
+struct Asset {
+	std::string name;
+	std::string url;
+	std::string digest;
+};
+[[nodiscard]] QByteArray releaseJson(const std::string& version, const std::vector<Asset>& assets);
+
+// Release notes in the styles common on GitHub: generated changelogs with PR links, hand-written notes with headings and
+// nested lists, notes with code blocks, tables and images, and one-liners
+[[nodiscard]] const std::vector<std::string>& markdownCorpus();
+// The worst case for the block parsers: lists nested depth levels deep, alternating between unordered and ordered, with a few items
+// on every level, followed by quotes nested as deep
+[[nodiscard]] std::string nestedMarkdown(int depth);
+// Single lines of lineSize bytes, each a repeated unterminated inline construct (emphasis, links, code spans...): the worst case for
+// inline parsers that look for the closing delimiter from every opening one. Named by the construct.
+[[nodiscard]] std::vector<std::pair<std::string, std::string>> adversarialInlineLines(size_t lineSize);
+
+} // namespace ReleaseFixtures
@@ -0,0 +1,59 @@
+TARGET = autoupdater-deltagen
+TEMPLATE = app
+
+QT = core
+
+CONFIG += console strict_c++
+CONFIG -= app_bundle
+exists(../../global.pri){
+	include(../../global.pri)
+} else {
+	CONFIG += c++2b
+}
+
+mac* | linux* | freebsd{
+	CONFIG(release, debug|release):CONFIG *= Release optimize_full
+	CONFIG(debug, debug|release):CONFIG *= Debug
+}
+
+contains(QT_ARCH, x86_64) {
+	ARCHITECTURE = x64
+} else {
+	ARCHITECTURE = x86
+}
+
+Release:OUTPUT_DIR=release/$${ARCHITECTURE}
+Debug:OUTPUT_DIR=debug/$${ARCHITECTURE}
+
+DESTDIR     = ../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+
+DEFINES += QT_MESSAGELOGCONTEXT
+
+INCLUDEPATH += \
+	$${PWD}/../src
+
+win*{
+	QMAKE_CXXFLAGS += /MP /Zi /wd4251
+	QMAKE_CXXFLAGS += /std:c++latest /permissive- /Zc:__cplusplus
+	QMAKE_CXXFLAGS_WARN_ON = /W4
+	DEFINES += WIN32_LEAN_AND_MEAN NOMINMAX
+}
+
+mac* | linux* | freebsd{
+	QMAKE_CXXFLAGS += -pedantic-errors
+	QMAKE_CXXFLAGS_WARN_ON = -Wall
+
+	Release:DEFINES += NDEBUG=1
+	Debug:DEFINES += _DEBUG
+}
+
+HEADERS += \
+	../src/deltagenerator.hpp
+
+SOURCES += \
+	../src/deltagenerator.cpp \
+	main.cpp
@@ -0,0 +1,34 @@
+#include "deltagenerator.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+RESTORE_COMPILER_WARNINGS
+
+// autoupdater-deltagen <previous version> <new version> <delta>
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("autoupdater-deltagen");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Makes a delta update from the previous version of an update asset to the new one.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("old", "The update asset of the previous version, as it's installed.");
+	parser.addPositionalArgument("new", "The update asset of the new version.");
+	parser.addPositionalArgument("delta", "The delta to write, to be published with the new release as <new asset name>.from-<previous version>.delta.");
+	parser.process(app);
+
+	const QStringList arguments = parser.positionalArguments();
+	if (arguments.size() != 3)
+		parser.showHelp(1);
+
+	if (!DeltaGenerator::generate(arguments[0], arguments[1], arguments[2]))
+	{
+		qCritical() << "Failed to make the delta from" << arguments[0] << "to" << arguments[1];
+		return 1;
+	}
+
+	return 0;
+}
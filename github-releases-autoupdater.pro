@@ -61,15 +61,37 @@ mac* | linux* | freebsd{
 
 HEADERS += \
 	src/cautoupdatergithub.h \
+	src/cdeltapatcher.h \
+	src/cdownloadfilewriter.h \
+	src/cdownloadprogressthrottle.h \
+	src/cdownloadjournal.h \
+	src/creleasecache.h \
+	src/creleasesstreamparser.h \
+	src/csegmenteddownload.h \
+	src/czsyncindex.h \
+	src/cversionkey.h \
 	src/updateinstaller.hpp
 
 SOURCES += \
-	src/cautoupdatergithub.cpp
+	src/cautoupdatergithub.cpp \
+	src/cdeltapatcher.cpp \
+	src/cdownloadfilewriter.cpp \
+	src/cdownloadprogressthrottle.cpp \
+	src/cdownloadjournal.cpp \
+	src/creleasecache.cpp \
+	src/creleasesstreamparser.cpp \
+	src/csegmenteddownload.cpp \
+	src/czsyncindex.cpp \
+	src/cversionkey.cpp
 
 win*:SOURCES += src/updateinstaller_win.cpp
 mac*:SOURCES += src/updateinstaller_mac.cpp
-linux*:SOURCES += src/updateinstaller_linux.cpp
-freebsd:SOURCES += src/updateinstaller_freebsd.cpp
+linux* | freebsd:SOURCES += src/updateinstaller_linux.cpp
+
+unix {
+	HEADERS += src/cdirectorycopier.h
+	SOURCES += src/cdirectorycopier.cpp
+}
 
 !updater_without_widgets{
 	SOURCES += \
@@ -1,91 +1,1063 @@
 #include "cautoupdatergithub.h"
+#include "cdeltapatcher.h"
+#include "cdownloadfilewriter.h"
+#include "cdownloadjournal.h"
+#include "creleasecache.h"
+#include "creleasesstreamparser.h"
+#include "csegmenteddownload.h"
+#include "czsyncindex.h"
 #include "updateinstaller.hpp"
 
 DISABLE_COMPILER_WARNINGS
 #include <QCollator>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
-#include <QJsonArray>
+#include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QStandardPaths>
+#include <QThread>
 
 #include "maddy/parser.h"
 RESTORE_COMPILER_WARNINGS
 
+#include <algorithm>
 #include <assert.h>
 #include <utility>
 
+// How often the journal of a partial download is updated while the data is arriving. It's also stored when the download fails.
+static constexpr qint64 downloadJournalUpdateInterval = 4 * 1024 * 1024;
+// zsync mode: missing blocks closer to each other than this are downloaded as one range, re-downloading a few local blocks is cheaper than another request
+static constexpr qint64 zsyncRangeMergeGap = 64 * 1024;
+static constexpr int zsyncMaxConnections = 4;
+
 static const auto naturalSortQstringComparator = [](const QString& l, const QString& r) {
-	static QCollator collator;
+	// The versions are compared on the releases processing thread, possibly by several updaters at once
+	thread_local QCollator collator;
 	collator.setNumericMode(true);
 	collator.setCaseSensitivity(Qt::CaseInsensitive);
 
-	// Fix for the new breaking changes in QCollator in Qt 5.14 - null strings are no longer a valid input
-	return collator.compare(qToStringViewIgnoringNull(l), qToStringViewIgnoringNull(r)) < 0;
-};
+	// Fix for the new breaking changes in QCollator in Qt 5.14 - null strings are no longer a valid input
+	return collator.compare(qToStringViewIgnoringNull(l), qToStringViewIgnoringNull(r)) < 0;
+};
+
+// The release notes are kept in their original Markdown form
+static CAutoUpdaterGithub::VersionEntry versionEntryFromRelease(CReleasesStreamParser::Release&& release)
+{
+	QString updateVersion = QString::fromStdString(release.tagName);
+
+	if (updateVersion.startsWith(QStringLiteral(".v")))
+		updateVersion.remove(0, 2);
+	else if (updateVersion.startsWith('v'))
+		updateVersion.remove(0, 1);
+
+#ifdef _WIN32
+	static constexpr auto targetExtension = ".exe";
+#elif defined __APPLE__
+	static constexpr auto targetExtension = ".dmg";
+#elif defined __linux__ || defined __FreeBSD__
+	static constexpr auto targetExtension = ".AppImage";
+#else
+	static constexpr auto targetExtension = ".unknown";
+#endif
+
+	// Find the appropriate release URL for our platform
+	const CReleasesStreamParser::Asset* updateAsset = nullptr;
+	for (const auto& asset : release.assets)
+	{
+		if (asset.browserDownloadUrl.ends_with(targetExtension))
+		{
+			updateAsset = &asset;
+			break;
+		}
+	}
+
+	// Fallback in case there is no download link available
+	const QString url = QString::fromStdString(updateAsset ? updateAsset->browserDownloadUrl : release.htmlUrl);
+
+	const QString dateString = QDateTime::fromString(QString::fromStdString(release.createdAt), Qt::DateFormat::ISODate).toString("dd MMM yyyy");
+
+	CAutoUpdaterGithub::VersionEntry entry{ updateVersion, QString::fromStdString(release.body).remove('\r'), dateString, url, release.prerelease, QString::fromStdString(release.name) };
+	if (!updateAsset)
+		return entry;
+
+	// The expected SHA-256 of the update: the digest GitHub publishes for the asset, or a checksums file uploaded along with it
+	if (updateAsset->digest.starts_with("sha256:"))
+		entry.updateSha256 = QByteArray::fromStdString(updateAsset->digest.substr(7)).toLower();
+	else
+	{
+		const std::string checksumFileName = updateAsset->name + ".sha256";
+		for (const auto& asset : release.assets)
+		{
+			const QString name = QString::fromStdString(asset.name).toLower();
+			if (asset.name == checksumFileName || name == QLatin1String("sha256sums") || name == QLatin1String("sha256sums.txt"))
+			{
+				entry.updateChecksumsUrl = QString::fromStdString(asset.browserDownloadUrl);
+				if (asset.name == checksumFileName)
+					break; // The most specific one
+			}
+		}
+	}
+
+	// The patches from older versions to this one (the one for the current version is only picked when downloading), and the zsync index
+	const std::string deltaAssetPrefix = updateAsset->name + ".from-", zsyncAssetName = updateAsset->name + ".zsync";
+	for (const auto& asset : release.assets)
+	{
+		if (asset.name.starts_with(deltaAssetPrefix) && asset.name.ends_with(".delta"))
+			entry.deltaUpdateUrls.push_back(QString::fromStdString(asset.browserDownloadUrl));
+		else if (asset.name == zsyncAssetName)
+			entry.zsyncUrl = QString::fromStdString(asset.browserDownloadUrl);
+	}
+
+	return entry;
+}
+
+// Finds the hash of fileName in the contents of a SHA256SUMS file ("<hex digest> <file name>" lines, the name may be preceded by '*'),
+// or of a <file>.sha256 file that may only contain the digest
+static QByteArray sha256FromChecksumsFile(const QByteArray& checksums, const QString& fileName)
+{
+	const QByteArray name = fileName.toUtf8();
+	for (const QByteArray& line : checksums.split('\n'))
+	{
+		const QByteArray trimmedLine = line.trimmed();
+		const auto separator = trimmedLine.indexOf(' ');
+		const QByteArray digest = trimmedLine.left(separator < 0 ? trimmedLine.size() : separator);
+		if (digest.size() != 64)
+			continue;
+
+		QByteArray lineFileName = separator < 0 ? QByteArray{} : trimmedLine.mid(separator + 1).trimmed();
+		if (lineFileName.startsWith('*'))
+			lineFileName.remove(0, 1);
+
+		if (lineFileName.isEmpty() || lineFileName == name)
+			return digest.toLower();
+	}
+
+	return {};
+}
+
+// Hex, empty if the file can't be read or if cancelled is set. Reports the progress of the Verify stage.
+static QByteArray fileSha256(const QString& filePath, const UpdateInstaller::ProgressHandler& onProgress, const std::atomic<bool>& cancelled)
+{
+	QFile file(filePath);
+	if (!file.open(QFile::ReadOnly))
+		return {};
+
+	onProgress(UpdateInstaller::Stage::Verify, 0.0f);
+
+	QCryptographicHash hash(QCryptographicHash::Sha256);
+	std::vector<char> buffer(1024 * 1024);
+	const qint64 fileSize = file.size();
+	qint64 totalBytesRead = 0;
+	int reportedPercentage = 0;
+	for (qint64 bytesRead = 0; !cancelled && (bytesRead = file.read(buffer.data(), static_cast<qint64>(buffer.size()))) > 0;)
+	{
+		hash.addData(buffer.data(), bytesRead);
+		totalBytesRead += bytesRead;
+
+		const int percentage = static_cast<int>(totalBytesRead * 100 / std::max(fileSize, qint64{1}));
+		if (percentage > reportedPercentage)
+		{
+			reportedPercentage = percentage;
+			onProgress(UpdateInstaller::Stage::Verify, static_cast<float>(percentage));
+		}
+	}
+
+	return !cancelled && totalBytesRead == fileSize ? hash.result().toHex() : QByteArray{};
+}
+
+// Where the update is downloaded to
+static QString updateFilePath()
+{
+	return QDir::tempPath() + '/' + QCoreApplication::applicationName() + UPDATE_FILE_EXTENSION;
+}
+
+// The size of the whole file: Content-Length of a 200 reply, the total from Content-Range (bytes <first>-<last>/<total>) of a 206 one. -1 if unknown.
+static qint64 downloadedFileSize(const QNetworkReply& reply)
+{
+	bool ok = false;
+	qint64 size = -1;
+	if (reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 206)
+	{
+		const QByteArray contentRange = reply.rawHeader("Content-Range");
+		size = contentRange.mid(contentRange.lastIndexOf('/') + 1).toLongLong(&ok);
+	}
+	else
+		size = reply.header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+
+	return ok ? size : -1;
+}
+
+// The request for the update file, the same for all the download modes
+static QNetworkRequest updateDownloadRequest(const QUrl& url)
+{
+	QNetworkRequest request(url);
+	request.setSslConfiguration(QSslConfiguration::defaultConfiguration()); // HTTPS
+	request.setMaximumRedirectsAllowed(5);
+	request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+	return request;
+}
+
+// Extracts the rel="next" URL from a Link header, e. g. <https://api.github.com/...&page=2>; rel="next", <https://api.github.com/...&page=5>; rel="last"
+static QUrl nextPageUrl(const QByteArray& linkHeader)
+{
+	for (const QByteArray& link : linkHeader.split(','))
+	{
+		const auto urlStart = link.indexOf('<'), urlEnd = link.indexOf('>');
+		if (urlStart < 0 || urlEnd < urlStart)
+			continue;
+
+		const QByteArray parameters = link.mid(urlEnd + 1);
+		if (parameters.contains("rel=\"next\"") || parameters.contains("rel=next"))
+			return QUrl(QString::fromLatin1(link.mid(urlStart + 1, urlEnd - urlStart - 1)));
+	}
+
+	return {};
+}
+
+const QString& CAutoUpdaterGithub::VersionEntry::versionChangesHtml() const
+{
+	if (!versionChangesHtmlCache)
+	{
+		// The parser and its block parsers are reused for all the release notes
+		thread_local maddy::Parser markdownParser;
+		std::istringstream istream{ versionChanges.toStdString() };
+		versionChangesHtmlCache = QString::fromStdString(markdownParser.Parse(istream));
+	}
+
+	return *versionChangesHtmlCache;
+}
+
+QByteArray CAutoUpdaterGithub::UpdateCheckMetrics::toJson() const
+{
+	const QJsonObject json{
+		{ "format", 1 },
+		{ "firstByteNs", firstByte },
+		{ "lastByteNs", lastByte },
+		{ "finishedNs", finished },
+		{ "jsonParseNs", jsonParseTime },
+		{ "filterNs", filterTime },
+		{ "markdownNs", markdownTime },
+		{ "listenerNs", listenerTime },
+		{ "bytesReceived", bytesReceived },
+		{ "pages", pages },
+		{ "releases", releases },
+		{ "newerReleases", newerReleases },
+		{ "notModified", notModified }
+	};
+
+	return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+// The state of an update check that lives on the releases processing thread. Only touched by the tasks on _releasesProcessingPool,
+// which run one at a time, and by the continuations they hand over to the updater's thread.
+struct CAutoUpdaterGithub::ReleasesProcessing {
+	// The settings, as of the start of the check
+	QString cacheFilePath;
+	QString cacheTruncationKey; // What a list this check cuts short depends on: the current version and the settings that stop the check early
+	int orderedFeedStopThreshold = 0;
+	bool collectMetrics = false;
+
+	std::atomic<bool> cancelled{ false }; // Another check has started, or the updater is being destroyed
+	std::unique_ptr<CReleasesStreamParser> parser; // Of the current page
+	bool abortRequested = false; // The parser has stopped, the rest of the page is not needed
+	CReleaseCache cache;
+	ChangeLog fetchedReleases;
+	std::vector<CVersionKey> fetchedVersionKeys; // Of fetchedReleases, each one built as the release arrives
+	int consecutiveOlderReleases = 0;
+	bool pageHasOlderReleases = false;
+	qint64 jsonParseTime = 0;
+
+	// The outcome of the last page: an error, the next page to request, or the result of the check
+	QString error;
+	QUrl nextPage;
+	ChangeLog newerReleases;
+	int releaseCount = 0;
+	bool notModified = false;
+	qint64 filterTime = 0;
+	qint64 markdownTime = 0;
+
+	void feed(const QByteArray& data)
+	{
+		QElapsedTimer timer;
+		if (collectMetrics)
+			timer.start();
+
+		parser->feed(data.constData(), static_cast<size_t>(data.size()));
+
+		if (collectMetrics)
+			jsonParseTime += timer.nsecsElapsed();
+	}
+};
+
+// Copying the blocks that are already in the local file into the zsync update, on the worker. The task owns the index while it runs.
+struct CAutoUpdaterGithub::ZsyncAssembly {
+	std::unique_ptr<CZsyncIndex> index;
+	QString baseFilePath;
+	QString filePath;
+	DownloadIoStrategy ioStrategy = DownloadIoStrategy::Preallocated;
+
+	// The result
+	bool copied = false;
+	std::vector<std::pair<qint64, qint64>> missingRanges; // To be downloaded, [first, end)
+	qint64 localBytes = 0;
+};
+
+// What the worker needs to know about a finished releases reply
+struct CAutoUpdaterGithub::ReleasesPage {
+	bool firstPage = false;
+	bool networkError = false;
+	bool notModified = false; // 304
+	QString errorString;
+	QByteArray remainingData;
+	QByteArray etag;
+	QByteArray lastModified;
+	QUrl nextPage; // Only in the paginated mode
+};
+
+CAutoUpdaterGithub::CAutoUpdaterGithub(QString githubRepositoryName, QString currentVersionString, const std::function<bool (const QString&, const QString&)>& versionStringComparatorLessThan) :
+	_downloadJournal(std::make_unique<CDownloadJournal>()),
+	_downloadFileWriter(std::make_unique<CDownloadFileWriter>(_downloadedBinaryFile)),
+	_repoName(std::move(githubRepositoryName)),
+	_currentVersionString(std::move(currentVersionString)),
+	_currentVersionKey(_currentVersionString),
+	_lessThanVersionStringComparator(versionStringComparatorLessThan),
+	_releaseCacheFilePath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/github-releases/" + QString(_repoName).replace('/', '_') + ".cache")
+{
+	_releasesProcessingPool.setMaxThreadCount(1);
+	_downloadProcessingPool.setMaxThreadCount(1);
+
+	assert(_repoName.count(QChar('/')) == 1);
+	assert(!_currentVersionString.isEmpty());
+
+#if defined __linux__ || defined __FreeBSD__
+	// Set by the AppImage runtime to the path of the running image
+	_deltaUpdateBaseFilePath = qEnvironmentVariable("APPIMAGE");
+#endif
+}
+
+CAutoUpdaterGithub::~CAutoUpdaterGithub()
+{
+	// The tasks use the updater, and whatever they would still hand over is dropped with it
+	if (_releasesProcessing)
+		_releasesProcessing->cancelled = true;
+	_releasesProcessingPool.waitForDone();
+	// The continuations are dropped with the updater
+	_downloadProcessingPool.waitForDone();
+
+	// Quitting in the middle of the installation would leave whatever was being installed half-done
+	if (_installationThread)
+		_installationThread->wait();
+}
+
+void CAutoUpdaterGithub::setUpdateStatusListener(UpdateStatusListener* listener)
+{
+	_listener = listener;
+}
+
+void CAutoUpdaterGithub::setApiBaseUrl(const QString& baseUrl)
+{
+	_apiBaseUrl = baseUrl;
+	while (_apiBaseUrl.endsWith('/'))
+		_apiBaseUrl.chop(1);
+}
+
+void CAutoUpdaterGithub::setNetworkAccessManager(QNetworkAccessManager* networkManager)
+{
+	_networkManager = networkManager ? networkManager : &_ownNetworkManager;
+}
+
+void CAutoUpdaterGithub::setReleaseCacheFilePath(const QString& cacheFilePath)
+{
+	_releaseCacheFilePath = cacheFilePath;
+}
+
+void CAutoUpdaterGithub::setOrderedFeedStopThreshold(int consecutiveOlderReleases)
+{
+	_orderedFeedStopThreshold = consecutiveOlderReleases;
+}
+
+void CAutoUpdaterGithub::setReleasesPageSize(int releasesPerPage)
+{
+	_releasesPageSize = releasesPerPage;
+}
+
+void CAutoUpdaterGithub::setDownloadBufferSize(qint64 bufferSize)
+{
+	assert(bufferSize > 0);
+	_downloadBufferSize = bufferSize;
+}
+
+void CAutoUpdaterGithub::setDownloadSegmentation(int segmentCount, qint64 minSegmentSize)
+{
+	assert(segmentCount > 0 && minSegmentSize > 0);
+	_downloadSegmentCount = segmentCount;
+	_minDownloadSegmentSize = minSegmentSize;
+}
+
+void CAutoUpdaterGithub::setDownloadProgressThrottling(qint64 minimumInterval, float minimumDelta)
+{
+	assert(minimumInterval >= 0 && minimumDelta >= 0.0f);
+	_downloadProgressThrottle.setMinimumInterval(minimumInterval);
+	_downloadProgressThrottle.setMinimumDelta(minimumDelta);
+}
+
+void CAutoUpdaterGithub::setDownloadIoStrategy(DownloadIoStrategy strategy)
+{
+	_downloadIoStrategy = strategy;
+}
+
+void CAutoUpdaterGithub::setUpdateVerificationRequired(bool required)
+{
+	_updateVerificationRequired = required;
+}
+
+void CAutoUpdaterGithub::setDeltaUpdateBaseFile(const QString& filePath)
+{
+	_deltaUpdateBaseFilePath = filePath;
+}
+
+void CAutoUpdaterGithub::setRelaunchAfterInstall(bool relaunch)
+{
+	_relaunchAfterInstall = relaunch;
+}
+
+void CAutoUpdaterGithub::setUpdateCheckMetricsHandler(std::function<void (const UpdateCheckMetrics&)> metricsHandler)
+{
+	_updateCheckMetricsHandler = std::move(metricsHandler);
+}
+
+void CAutoUpdaterGithub::checkForUpdates()
+{
+	if (_updateCheckReply)
+	{
+		// Only one check at a time, the newer one wins
+		disconnect(_updateCheckReply, nullptr, this, nullptr);
+		_updateCheckReply->abort();
+		_updateCheckReply->deleteLater();
+		_updateCheckReply = nullptr;
+	}
+
+	QUrl url(_apiBaseUrl + "/repos/" + _repoName + "/releases");
+	if (_releasesPageSize > 0)
+		url.setQuery("per_page=" + QString::number(_releasesPageSize));
+
+	_releasesPagesFetched = 0;
+
+	_updateCheckMetrics.reset();
+	if (_updateCheckMetricsHandler)
+	{
+		_updateCheckMetrics.emplace();
+		_updateCheckTimer.start();
+	}
+
+	// Whatever the previous check still had queued is abandoned
+	if (_releasesProcessing)
+		_releasesProcessing->cancelled = true;
+
+	const auto processing = std::make_shared<ReleasesProcessing>();
+	processing->cacheFilePath = _releaseCacheFilePath;
+	processing->cacheTruncationKey = _currentVersionString + '/' + QString::number(_orderedFeedStopThreshold) + '/' + QString::number(_releasesPageSize);
+	processing->orderedFeedStopThreshold = _orderedFeedStopThreshold;
+	processing->collectMetrics = _updateCheckMetrics.has_value();
+	_releasesProcessing = processing;
+
+	if (_releaseCacheFilePath.isEmpty())
+	{
+		requestReleasesPage(url);
+		return;
+	}
+
+	// The cache holds the whole releases list, it's loaded on the worker too. The request goes out once its validators are known.
+	processReleases(processing, [processing] {
+		if (!processing->cache.load(processing->cacheFilePath) || !processing->cache.isValidFor(processing->cacheTruncationKey))
+			processing->cache = {};
+	}, [this, url] {
+		requestReleasesPage(url);
+	});
+}
+
+void CAutoUpdaterGithub::processReleases(const std::shared_ptr<ReleasesProcessing>& processing, std::function<void ()> work, std::function<void ()> continuation)
+{
+	_releasesProcessingPool.start([this, processing, work = std::move(work), continuation = std::move(continuation)] {
+		if (processing->cancelled)
+			return;
+
+		work();
+		if (!continuation || processing->cancelled)
+			return;
+
+		QMetaObject::invokeMethod(this, [this, processing, continuation] {
+			if (processing == _releasesProcessing)
+				continuation();
+		}, Qt::QueuedConnection);
+	});
+}
+
+void CAutoUpdaterGithub::requestReleasesPage(const QUrl& url)
+{
+	QNetworkRequest request(url);
+	request.setRawHeader("Accept", "application/vnd.github+json");
+
+	// Conditional request: GitHub replies 304 with no body if the releases haven't changed, and 304s don't count against the rate limit.
+	// Only the first page is checked, the following pages can't change without the first one changing as well.
+	// The cache of the first page has been loaded on the worker, by a task that has finished by now
+	const auto& processing = _releasesProcessing;
+	if (_releasesPagesFetched == 0)
+	{
+		if (!processing->cache.etag.isEmpty())
+			request.setRawHeader("If-None-Match", processing->cache.etag);
+		if (!processing->cache.lastModified.isEmpty())
+			request.setRawHeader("If-Modified-Since", processing->cache.lastModified);
+	}
+
+	QNetworkReply * reply = _networkManager->get(request);
+	if (!reply)
+	{
+		if (_listener)
+			_listener->onUpdateError("Network request rejected.");
+		return;
+	}
+
+	_updateCheckReply = reply;
+	processReleases(processing, [this, p = processing.get()] {
+		p->pageHasOlderReleases = false;
+		p->abortRequested = false;
+		p->parser = std::make_unique<CReleasesStreamParser>([this, p](CReleasesStreamParser::Release&& release) {
+			if (release.draft)
+				return;
+
+			const auto& entry = p->fetchedReleases.emplace_back(versionEntryFromRelease(std::move(release)));
+			const auto& versionKey = p->fetchedVersionKeys.emplace_back(entry.versionString);
+			if (isNewerVersion(entry.versionString, versionKey))
+			{
+				p->consecutiveOlderReleases = 0;
+				return;
+			}
+
+			p->pageHasOlderReleases = true;
+			if (p->orderedFeedStopThreshold > 0 && ++p->consecutiveOlderReleases >= p->orderedFeedStopThreshold)
+				p->parser->stop(); // Everything further down the list is older still
+		});
+	});
+
+	connect(reply, &QNetworkReply::readyRead, this, &CAutoUpdaterGithub::releasesDataReceived);
+	connect(reply, &QNetworkReply::finished, this, &CAutoUpdaterGithub::updateCheckRequestFinished, Qt::UniqueConnection);
+}
+
+void CAutoUpdaterGithub::downloadAndInstallUpdate(const QString& updateUrl)
+{
+	if (_installationThread)
+	{
+		if (_listener)
+			_listener->onUpdateError("An update is already being installed.");
+
+		return;
+	}
+
+	// An earlier attempt that is still working on the update file on the worker is abandoned, once it's done with the file
+	++_downloadId;
+	_downloadProcessingPool.waitForDone();
+
+	_expectedSha256.clear();
+	_checksumsUrl.clear();
+	QString deltaUrl, zsyncUrl;
+	for (const auto& update : _availableUpdates)
+	{
+		if (update.versionUpdateUrl != updateUrl)
+			continue;
+
+		_expectedSha256 = update.updateSha256;
+		_checksumsUrl = update.updateChecksumsUrl;
+		zsyncUrl = update.zsyncUrl;
+
+		const QString deltaFileName = QUrl(updateUrl).fileName() + ".from-" + _currentVersionString + ".delta";
+		for (const QString& url : update.deltaUpdateUrls)
+		{
+			if (QUrl(url).fileName() == deltaFileName)
+				deltaUrl = url;
+		}
+
+		break;
+	}
+
+	// Hashing the download is a waste of time if there's nothing to check the hash against
+	_downloadHashRequired = !_expectedSha256.isEmpty() || !_checksumsUrl.isEmpty();
+
+	const bool baseFileAvailable = !_deltaUpdateBaseFilePath.isEmpty() && QFileInfo::exists(_deltaUpdateBaseFilePath);
+	if (baseFileAvailable && !deltaUrl.isEmpty())
+		startDeltaDownload(deltaUrl, updateUrl);
+	else if (baseFileAvailable && !zsyncUrl.isEmpty())
+		startZsyncDownload(zsyncUrl, updateUrl);
+	else
+		startDownload(updateUrl, true);
+}
+
+// The patch is applied as it arrives, the new version is written straight to the update file
+void CAutoUpdaterGithub::startDeltaDownload(const QString& deltaUrl, const QString& updateUrl)
+{
+	assert(!_downloadedBinaryFile.isOpen());
+
+	_downloadProgressThrottle.reset();
+
+	_fullUpdateUrl = updateUrl;
+
+	// The patch only applies to the exact file it was made from, which is checked by its hash. The whole installed version is read for it,
+	// on the worker, before the patch is requested.
+	auto baseFileSha256 = std::make_shared<QByteArray>();
+	processDownload([baseFileSha256, baseFilePath = _deltaUpdateBaseFilePath] {
+		QFile baseFile(baseFilePath);
+		QCryptographicHash hash(QCryptographicHash::Sha256);
+		if (baseFile.open(QFile::ReadOnly) && hash.addData(&baseFile))
+			*baseFileSha256 = hash.result().toHex();
+	}, [this, baseFileSha256, deltaUrl] {
+		requestDeltaUpdate(deltaUrl, *baseFileSha256);
+	});
+}
+
+void CAutoUpdaterGithub::requestDeltaUpdate(const QString& deltaUrl, const QByteArray& baseFileSha256)
+{
+	if (baseFileSha256.isEmpty())
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	_downloadedBinaryFile.setFileName(updateFilePath());
+	// The patched file takes the place of any partial download of the full update
+	QFile::remove(_downloadedBinaryFile.fileName() + ".journal");
+	if (!_downloadedBinaryFile.open(QFile::ReadWrite | QFile::Truncate | QFile::Unbuffered))
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	_deltaOutputSize = 0;
+	_downloadResumeOffset = 0;
+	_downloadHash->reset();
+	_downloadBuffer.resize(static_cast<size_t>(_downloadBufferSize));
+	_deltaPatcher = std::make_unique<CDeltaPatcher>(_deltaUpdateBaseFilePath, baseFileSha256, [this](const char* data, qint64 size) {
+		if (_deltaOutputSize == 0 && !_downloadFileWriter->start(_downloadIoStrategy, _deltaPatcher->newFileSize()))
+			return false;
+
+		if (!_downloadFileWriter->write(_deltaOutputSize, data, size))
+			return false;
+
+		_downloadHash->addData(data, size);
+		_deltaOutputSize += size;
+		return true;
+	});
+
+	QNetworkReply * reply = _networkManager->get(updateDownloadRequest(QUrl(deltaUrl)));
+	if (!reply)
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	reply->setReadBufferSize(_downloadBufferSize);
+
+	connect(reply, &QNetworkReply::readyRead, this, &CAutoUpdaterGithub::onNewDeltaDataDownloaded);
+	connect(reply, &QNetworkReply::downloadProgress, this, &CAutoUpdaterGithub::onDownloadProgress);
+	connect(reply, &QNetworkReply::finished, this, &CAutoUpdaterGithub::deltaDownloaded, Qt::UniqueConnection);
+}
+
+// Returns false if the patch is broken or doesn't apply
+bool CAutoUpdaterGithub::feedDeltaPatcher(QNetworkReply* reply)
+{
+	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (statusCode != 200 && statusCode != 0 /* not HTTP */)
+	{
+		reply->skip(reply->bytesAvailable()); // An error page, the error is handled when the reply is finished
+		return true;
+	}
+
+	for (qint64 bytesRead = 0; (bytesRead = reply->read(_downloadBuffer.data(), _downloadBufferSize)) > 0;)
+	{
+		if (!_deltaPatcher->feed(_downloadBuffer.data(), bytesRead))
+			return false;
+	}
+
+	return true;
+}
+
+void CAutoUpdaterGithub::onNewDeltaDataDownloaded()
+{
+	auto* reply = qobject_cast<QNetworkReply*>(sender());
+	if (!reply || feedDeltaPatcher(reply))
+		return;
+
+	disconnect(reply, nullptr, this, nullptr);
+	reply->abort();
+	reply->deleteLater();
+	fallBackToFullDownload();
+}
+
+void CAutoUpdaterGithub::deltaDownloaded()
+{
+	auto* reply = qobject_cast<QNetworkReply *>(sender());
+	if (!reply)
+		return;
+
+	reply->deleteLater();
+
+	// The output is checked against the hash of the new version that the patch carries, and that one against the digest of the full asset
+	const bool patched = reply->error() == QNetworkReply::NoError && feedDeltaPatcher(reply) && _deltaPatcher->finished()
+		&& _downloadHash->result().toHex() == _deltaPatcher->newFileSha256() && (_expectedSha256.isEmpty() || _expectedSha256 == _deltaPatcher->newFileSha256());
+	if (!patched)
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	_downloadFileWriter->finish(_deltaOutputSize);
+	_downloadedBinaryFile.close();
+	_downloadBuffer = {};
+	_downloadHashComplete = true;
+
+	// Without a digest of the full asset, the hash from the patch will do: it comes from the same release
+	const QByteArray expectedSha256 = _expectedSha256.isEmpty() ? _deltaPatcher->newFileSha256() : _expectedSha256;
+	_deltaPatcher.reset();
+	installDownloadedUpdate(expectedSha256);
+}
+
+// The zsync index is small, it's downloaded in full before anything else
+void CAutoUpdaterGithub::startZsyncDownload(const QString& zsyncUrl, const QString& updateUrl)
+{
+	assert(!_downloadedBinaryFile.isOpen());
+
+	_downloadProgressThrottle.reset();
+
+	_fullUpdateUrl = updateUrl;
+	QNetworkReply * reply = _networkManager->get(updateDownloadRequest(QUrl(zsyncUrl)));
+	if (!reply)
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	connect(reply, &QNetworkReply::finished, this, &CAutoUpdaterGithub::zsyncIndexDownloaded);
+}
+
+void CAutoUpdaterGithub::zsyncIndexDownloaded()
+{
+	auto* reply = qobject_cast<QNetworkReply *>(sender());
+	if (!reply)
+		return;
+
+	reply->deleteLater();
+
+	_zsyncIndex = std::make_unique<CZsyncIndex>();
+	if (reply->error() != QNetworkReply::NoError || !_zsyncIndex->parse(reply->readAll()))
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	// Range support is required, and the redirect to the storage server is resolved here once rather than for every range
+	QNetworkReply * probeReply = _networkManager->head(updateDownloadRequest(QUrl(_fullUpdateUrl)));
+	if (!probeReply)
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	connect(probeReply, &QNetworkReply::finished, this, &CAutoUpdaterGithub::zsyncTargetProbed);
+}
+
+void CAutoUpdaterGithub::zsyncTargetProbed()
+{
+	auto* reply = qobject_cast<QNetworkReply *>(sender());
+	if (!reply)
+		return;
+
+	reply->deleteLater();
+
+	const qint64 totalSize = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+	if (reply->error() != QNetworkReply::NoError || !reply->rawHeader("Accept-Ranges").contains("bytes") || totalSize != _zsyncIndex->fileLength())
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	CDownloadJournal validators;
+	validators.etag = reply->rawHeader("ETag");
+	validators.lastModified = reply->rawHeader("Last-Modified");
+
+	_downloadedBinaryFile.setFileName(updateFilePath());
+	// The file is assembled in place of any partial download of the full update
+	QFile::remove(_downloadedBinaryFile.fileName() + ".journal");
+
+	// Finding the blocks reads the whole local file, and so does copying them: on the worker, through its own QFile and writer.
+	// The index is the task's until it hands it back.
+	auto assembly = std::make_shared<ZsyncAssembly>();
+	assembly->index = std::move(_zsyncIndex);
+	assembly->baseFilePath = _deltaUpdateBaseFilePath;
+	assembly->filePath = _downloadedBinaryFile.fileName();
+	// The blocks are written at their offsets, so the file is preallocated at least
+	assembly->ioStrategy = _downloadIoStrategy == DownloadIoStrategy::Append ? DownloadIoStrategy::Preallocated : _downloadIoStrategy;
+	processDownload([assembly, totalSize] {
+		QFile baseFile(assembly->baseFilePath), file(assembly->filePath);
+		CDownloadFileWriter writer(file);
+		const qint64 baseSize = baseFile.size();
+		const uchar* baseData = baseSize > 0 && baseFile.open(QFile::ReadOnly) ? baseFile.map(0, baseSize) : nullptr;
+		if (!baseData || !file.open(QFile::ReadWrite | QFile::Truncate | QFile::Unbuffered) || !writer.start(assembly->ioStrategy, totalSize))
+			return;
+
+		// The blocks that are already in the local file are copied from it, the rest are merged into ranges to download
+		const std::vector<qint64> localBlocks = assembly->index->findBlocks(baseData, baseSize);
+		const qint64 blockSize = assembly->index->blockSize();
+		for (size_t i = 0; i < localBlocks.size(); ++i)
+		{
+			const qint64 offset = static_cast<qint64>(i) * blockSize;
+			const qint64 length = std::min(blockSize, totalSize - offset);
+			if (localBlocks[i] >= 0 && localBlocks[i] + length <= baseSize)
+			{
+				if (!writer.write(offset, reinterpret_cast<const char*>(baseData + localBlocks[i]), length))
+					return;
+
+				assembly->localBytes += length;
+			}
+			else if (!assembly->missingRanges.empty() && offset - assembly->missingRanges.back().second <= zsyncRangeMergeGap)
+				assembly->missingRanges.back().second = offset + length;
+			else
+				assembly->missingRanges.emplace_back(offset, offset + length);
+		}
+
+		// The file keeps its full size, the missing ranges are written into it
+		assembly->copied = writer.finish(totalSize);
+	}, [this, assembly, url = reply->url(), ifRangeValidator = validators.ifRangeValidator()] {
+		_zsyncIndex = std::move(assembly->index);
+		zsyncLocalBlocksCopied(*assembly, url, ifRangeValidator);
+	});
+}
+
+// The redirects have been resolved by the HEAD request already, url is where the ranges are downloaded from
+void CAutoUpdaterGithub::zsyncLocalBlocksCopied(const ZsyncAssembly& assembly, const QUrl& url, const QByteArray& ifRangeValidator)
+{
+	const qint64 totalSize = _zsyncIndex->fileLength();
+	if (!assembly.copied || !_downloadedBinaryFile.open(QFile::ReadWrite | QFile::Unbuffered) || !_downloadFileWriter->start(assembly.ioStrategy, totalSize))
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	if (assembly.missingRanges.empty())
+	{
+		zsyncDownloadFinished({});
+		return;
+	}
+
+	_segmentedDownload = std::make_unique<CSegmentedDownload>(*_networkManager, *_downloadFileWriter,
+		[this, localBytes = assembly.localBytes, totalSize](qint64 bytesReceived) {
+			reportDownloadProgress(localBytes + bytesReceived, totalSize);
+		},
+		[this](const QString& errorMessage) {
+			_segmentedDownload.release()->deleteLater(); // This handler is called by the object itself
+			zsyncDownloadFinished(errorMessage);
+		}
+	);
+
+	_segmentedDownload->start(updateDownloadRequest(url), ifRangeValidator, assembly.missingRanges, zsyncMaxConnections, _downloadBufferSize);
+}
+
+void CAutoUpdaterGithub::zsyncDownloadFinished(const QString& errorMessage)
+{
+	_downloadFileWriter->finish(_zsyncIndex->fileLength());
+	_downloadedBinaryFile.close();
+	if (!errorMessage.isEmpty())
+	{
+		fallBackToFullDownload();
+		return;
+	}
+
+	// One pass over the assembled file for both the SHA-1 from the index and the SHA-256 to check against the release, on the worker.
+	// The task hashes into its own object, which takes the place of _downloadHash once it's done.
+	struct Check {
+		bool sha1Matches = false;
+		std::unique_ptr<QCryptographicHash> sha256 = std::make_unique<QCryptographicHash>(QCryptographicHash::Sha256);
+	};
 
-CAutoUpdaterGithub::CAutoUpdaterGithub(QString githubRepositoryName, QString currentVersionString, const std::function<bool (const QString&, const QString&)>& versionStringComparatorLessThan) :
-	_repoName(std::move(githubRepositoryName)),
-	_currentVersionString(std::move(currentVersionString)),
-	_lessThanVersionStringComparator(versionStringComparatorLessThan ? versionStringComparatorLessThan : naturalSortQstringComparator)
-{
-	assert(_repoName.count(QChar('/')) == 1);
-	assert(!_currentVersionString.isEmpty());
+	auto check = std::make_shared<Check>();
+	processDownload([check, filePath = _downloadedBinaryFile.fileName(), expectedSha1 = _zsyncIndex->sha1(), hashRequired = _downloadHashRequired, bufferSize = _downloadBufferSize] {
+		QFile file(filePath);
+		QCryptographicHash sha1(QCryptographicHash::Sha1);
+		std::vector<char> buffer(static_cast<size_t>(bufferSize));
+		const bool fileOpened = file.open(QFile::ReadOnly);
+		for (qint64 bytesRead = 0; fileOpened && (bytesRead = file.read(buffer.data(), bufferSize)) > 0;)
+		{
+			sha1.addData(buffer.data(), bytesRead);
+			if (hashRequired)
+				check->sha256->addData(buffer.data(), bytesRead);
+		}
+
+		check->sha1Matches = fileOpened && sha1.result().toHex() == expectedSha1;
+	}, [this, check] {
+		if (!check->sha1Matches)
+		{
+			fallBackToFullDownload();
+			return;
+		}
+
+		_downloadHash = std::move(check->sha256);
+		_downloadHashComplete = _downloadHashRequired;
+		_downloadBuffer = {};
+		_zsyncIndex.reset();
+		verifyAgainstPublishedHash(_fullUpdateUrl);
+	});
 }
 
-void CAutoUpdaterGithub::setUpdateStatusListener(UpdateStatusListener* listener)
+void CAutoUpdaterGithub::processDownload(std::function<void ()> work, std::function<void ()> continuation)
 {
-	_listener = listener;
+	_downloadProcessingPool.start([this, downloadId = _downloadId, work = std::move(work), continuation = std::move(continuation)] {
+		work();
+		QMetaObject::invokeMethod(this, [this, downloadId, continuation] {
+			if (downloadId == _downloadId)
+				continuation();
+		}, Qt::QueuedConnection);
+	});
 }
 
-void CAutoUpdaterGithub::checkForUpdates()
+void CAutoUpdaterGithub::fallBackToFullDownload()
 {
-	QNetworkRequest request;
-	request.setUrl(QUrl("https://api.github.com/repos/" + _repoName + "/releases"));
-	request.setRawHeader("Accept", "application/vnd.github+json");
-	QNetworkReply * reply = _networkManager.get(request);
-	if (!reply)
+	_deltaPatcher.reset();
+	_zsyncIndex.reset();
+	if (_downloadedBinaryFile.isOpen())
 	{
-		if (_listener)
-			_listener->onUpdateError("Network request rejected.");
-		return;
+		_downloadFileWriter->finish(0); // The file is truncated by startDownload() anyway
+		_downloadedBinaryFile.close();
 	}
 
-	connect(reply, &QNetworkReply::finished, this, &CAutoUpdaterGithub::updateCheckRequestFinished, Qt::UniqueConnection);
+	startDownload(_fullUpdateUrl, false);
 }
 
-void CAutoUpdaterGithub::downloadAndInstallUpdate(const QString& updateUrl)
+void CAutoUpdaterGithub::startDownload(const QString& updateUrl, bool resume)
 {
 	assert(!_downloadedBinaryFile.isOpen());
 
-	_downloadedBinaryFile.setFileName(QDir::tempPath() + '/' + QCoreApplication::applicationName() + UPDATE_FILE_EXTENSION);
-	if (!_downloadedBinaryFile.open(QFile::WriteOnly))
+	_downloadProgressThrottle.reset();
+
+	_downloadedBinaryFile.setFileName(updateFilePath());
+	_downloadJournalFilePath = _downloadedBinaryFile.fileName() + ".journal";
+
+	// The partial file can only be resumed if it's from the same URL and there is a validator to check that the resource hasn't changed since
+	resume = resume && _downloadJournal->load(_downloadJournalFilePath) && _downloadJournal->url == updateUrl
+		&& _downloadJournal->bytesReceived > 0 && !_downloadJournal->ifRangeValidator().isEmpty()
+		&& QFileInfo(_downloadedBinaryFile.fileName()).size() >= _downloadJournal->bytesReceived;
+
+	if (!resume)
+	{
+		*_downloadJournal = {};
+		_downloadJournal->url = updateUrl;
+	}
+
+	// Unbuffered: the chunks are written straight from _downloadBuffer, there's no point in copying them into QFile's own buffer first.
+	// ReadWrite, because a file can't be memory-mapped if it's only open for writing.
+	const bool fileOpened = resume
+		? _downloadedBinaryFile.open(QFile::ReadWrite | QFile::Unbuffered) && _downloadedBinaryFile.resize(_downloadJournal->bytesReceived)
+		: _downloadedBinaryFile.open(QFile::ReadWrite | QFile::Truncate | QFile::Unbuffered);
+
+	if (!fileOpened || !_downloadedBinaryFile.seek(_downloadJournal->bytesReceived))
 	{
+		_downloadedBinaryFile.close();
 		if (_listener)
 			_listener->onUpdateError("Failed to open temporary file " + _downloadedBinaryFile.fileName());
 		return;
 	}
 
-	QNetworkRequest request((QUrl(updateUrl)));
-	request.setSslConfiguration(QSslConfiguration::defaultConfiguration()); // HTTPS
-	request.setMaximumRedirectsAllowed(5);
-	request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
-	QNetworkReply * reply = _networkManager.get(request);
+	_downloadResumeOffset = _downloadJournal->bytesReceived;
+	_journalStoredBytes = _downloadResumeOffset;
+	_downloadResponseChecked = false;
+	_downloadResponseAccepted = false;
+	_downloadRestartRequired = false;
+	_downloadBuffer.resize(static_cast<size_t>(_downloadBufferSize));
+
+	// The hash is computed as the data is written
+	_downloadHash->reset();
+	_downloadHashComplete = _downloadHashRequired;
+	if (!_downloadHashComplete || _downloadResumeOffset == 0)
+	{
+		requestDownload();
+		return;
+	}
+
+	// A resumed download has to catch up with the part that's already there first. That's most of the file, possibly hundreds of MB:
+	// it's hashed on the worker, into a hash of its own that takes the place of _downloadHash, and the request is only sent after that.
+	struct CatchUp {
+		bool complete = false;
+		std::unique_ptr<QCryptographicHash> sha256 = std::make_unique<QCryptographicHash>(QCryptographicHash::Sha256);
+	};
+
+	auto catchUp = std::make_shared<CatchUp>();
+	processDownload([catchUp, filePath = _downloadedBinaryFile.fileName(), size = _downloadResumeOffset, bufferSize = _downloadBufferSize] {
+		QFile file(filePath);
+		if (!file.open(QFile::ReadOnly))
+			return;
+
+		std::vector<char> buffer(static_cast<size_t>(bufferSize));
+		qint64 totalBytesRead = 0;
+		for (qint64 bytesRead = 0; totalBytesRead < size && (bytesRead = file.read(buffer.data(), std::min(bufferSize, size - totalBytesRead))) > 0;)
+		{
+			catchUp->sha256->addData(buffer.data(), bytesRead);
+			totalBytesRead += bytesRead;
+		}
+
+		catchUp->complete = totalBytesRead == size;
+	}, [this, catchUp] {
+		_downloadHash = std::move(catchUp->sha256);
+		_downloadHashComplete = catchUp->complete; // Otherwise the file is hashed again once it's complete
+		requestDownload();
+	});
+}
+
+// Once the file is ready for the data: the HEAD request first in the multi-connection mode, the download itself otherwise
+void CAutoUpdaterGithub::requestDownload()
+{
+	if (_downloadSegmentCount > 1)
+	{
+		// The size of the file and the range support are needed to split the download into segments
+		QNetworkReply * reply = _networkManager->head(updateDownloadRequest(QUrl(_downloadJournal->url)));
+		if (!reply)
+		{
+			finishDownload("Network request rejected.");
+			return;
+		}
+
+		connect(reply, &QNetworkReply::finished, this, &CAutoUpdaterGithub::downloadSizeProbed);
+		return;
+	}
+
+	requestSingleDownload();
+}
+
+void CAutoUpdaterGithub::requestSingleDownload()
+{
+	QNetworkRequest request = updateDownloadRequest(QUrl(_downloadJournal->url));
+	if (_downloadResumeOffset > 0)
+	{
+		// If the resource has changed, If-Range makes the server ignore the range and send the new version in full
+		request.setRawHeader("Range", "bytes=" + QByteArray::number(_downloadResumeOffset) + '-');
+		request.setRawHeader("If-Range", _downloadJournal->ifRangeValidator());
+	}
+
+	QNetworkReply * reply = _networkManager->get(request);
 	if (!reply)
 	{
-		if (_listener)
-			_listener->onUpdateError("Network request rejected.");
+		finishDownload("Network request rejected.");
 		return;
 	}
 
+	reply->setReadBufferSize(_downloadBufferSize);
+
 	connect(reply, &QNetworkReply::readyRead, this, &CAutoUpdaterGithub::onNewDataDownloaded);
 	connect(reply, &QNetworkReply::downloadProgress, this, &CAutoUpdaterGithub::onDownloadProgress);
 	connect(reply, &QNetworkReply::finished, this, &CAutoUpdaterGithub::updateDownloaded, Qt::UniqueConnection);
 }
 
-void CAutoUpdaterGithub::updateCheckRequestFinished()
+void CAutoUpdaterGithub::downloadSizeProbed()
 {
 	auto* reply = qobject_cast<QNetworkReply *>(sender());
 	if (!reply)
@@ -93,97 +1065,390 @@ void CAutoUpdaterGithub::updateCheckRequestFinished()
 
 	reply->deleteLater();
 
-	if (reply->error() != QNetworkReply::NoError)
+	const qint64 totalSize = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+
+	// The validators of the current version of the file, the partial file is of no use if it's from another one
+	CDownloadJournal journal = *_downloadJournal;
+	journal.etag = reply->rawHeader("ETag");
+	journal.lastModified = reply->rawHeader("Last-Modified");
+	if (journal.etag != _downloadJournal->etag || journal.lastModified != _downloadJournal->lastModified)
+		journal.bytesReceived = 0;
+
+	// Without a validator there's no guarantee that all the segments come from the same version of the file
+	if (reply->error() != QNetworkReply::NoError || !reply->rawHeader("Accept-Ranges").contains("bytes") || journal.ifRangeValidator().isEmpty()
+		|| totalSize < journal.bytesReceived + 2 * _minDownloadSegmentSize)
 	{
-		if (_listener)
-			_listener->onUpdateError(reply->errorString());
+		requestSingleDownload(); // Not possible, or not worth it
+		return;
+	}
+
+	*_downloadJournal = journal;
+	_downloadResumeOffset = journal.bytesReceived;
 
+	// The redirects have been resolved by the HEAD request already
+	startSegmentedDownload(reply->url(), totalSize);
+}
+
+void CAutoUpdaterGithub::startSegmentedDownload(const QUrl& url, qint64 totalSize)
+{
+	// The segments arrive out of order, so the file is hashed once it's complete
+	_downloadHashComplete = false;
+
+	// Preallocated at least, as the segments are written at their offsets in any order
+	const auto ioStrategy = _downloadIoStrategy == DownloadIoStrategy::Append ? DownloadIoStrategy::Preallocated : _downloadIoStrategy;
+	if (!_downloadFileWriter->start(ioStrategy, totalSize))
+	{
+		finishDownload("Failed to write the update to " + _downloadedBinaryFile.fileName());
 		return;
 	}
 
-	if (reply->bytesAvailable() <= 0)
+	storeDownloadJournal();
+
+	_segmentedDownload = std::make_unique<CSegmentedDownload>(*_networkManager, *_downloadFileWriter,
+		[this, totalSize](qint64 bytesReceived) {
+			// Only the gapless beginning of the file can be resumed from
+			_downloadJournal->bytesReceived = _segmentedDownload->contiguousEnd();
+			if (_downloadJournal->bytesReceived - _journalStoredBytes >= downloadJournalUpdateInterval)
+				storeDownloadJournal();
+
+			reportDownloadProgress(_downloadResumeOffset + bytesReceived, totalSize);
+		},
+		[this](const QString& errorMessage) {
+			_downloadJournal->bytesReceived = _segmentedDownload->contiguousEnd();
+			_segmentedDownload.release()->deleteLater(); // This handler is called by the object itself
+			finishDownload(errorMessage);
+		}
+	);
+
+	_segmentedDownload->start(updateDownloadRequest(url), _downloadJournal->ifRangeValidator(), _downloadResumeOffset, totalSize, _downloadSegmentCount, _minDownloadSegmentSize, _downloadBufferSize);
+}
+
+// Called before the first byte of the reply body is written. Returns false if the body is not (a part of) the update.
+bool CAutoUpdaterGithub::acceptDownloadResponse(QNetworkReply* reply)
+{
+	const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (statusCode == 206)
+	{
+		if (CSegmentedDownload::contentRangeStart(*reply) != _downloadResumeOffset)
+		{
+			_downloadRestartRequired = true;
+			return false;
+		}
+	}
+	else if (statusCode == 200 || statusCode == 0 /* not HTTP */)
+	{
+		// The server doesn't support ranges, or the resource has changed: the whole file is being sent
+		if (_downloadResumeOffset > 0)
+		{
+			if (!_downloadedBinaryFile.resize(0) || !_downloadedBinaryFile.seek(0))
+				return false;
+
+			_downloadResumeOffset = 0;
+			_downloadHash->reset();
+			_downloadHashComplete = _downloadHashRequired;
+		}
+
+		_downloadJournal->etag = reply->rawHeader("ETag");
+		_downloadJournal->lastModified = reply->rawHeader("Last-Modified");
+		_downloadJournal->bytesReceived = 0;
+	}
+	else if (statusCode == 416 && _downloadResumeOffset > 0)
 	{
-		if (_listener)
-			_listener->onUpdateError("No data downloaded.");
+		// The partial file is longer than the resource
+		_downloadRestartRequired = true;
+		return false;
+	}
+	else
+		return false; // An error page, the error is reported when the reply is finished
+
+	if (!_downloadFileWriter->start(_downloadIoStrategy, downloadedFileSize(*reply)))
+		return false;
+
+	storeDownloadJournal();
+	return true;
+}
+
+void CAutoUpdaterGithub::storeDownloadJournal()
+{
+	_downloadJournal->store(_downloadJournalFilePath);
+	_journalStoredBytes = _downloadJournal->bytesReceived;
+}
+
+void CAutoUpdaterGithub::releasesDataReceived()
+{
+	auto* reply = qobject_cast<QNetworkReply *>(sender());
+	if (!reply || reply != _updateCheckReply)
 		return;
+
+	// The releases are extracted as the data arrives, on the worker: the complete reply is never held in memory
+	const QByteArray data = reply->readAll();
+	if (_updateCheckMetrics)
+	{
+		if (_updateCheckMetrics->firstByte < 0)
+			_updateCheckMetrics->firstByte = _updateCheckTimer.nsecsElapsed();
+
+		_updateCheckMetrics->bytesReceived += data.size();
 	}
 
-	const QJsonDocument jsonDocument = QJsonDocument::fromJson(reply->readAll());
-	assert(jsonDocument.isArray());
+	processReleases(_releasesProcessing, [this, processing = _releasesProcessing, reply, data] {
+		processing->feed(data);
 
-	ChangeLog changelog;
+		// Ordered feed mode: the rest of the list is not needed, don't waste time and bandwidth downloading it
+		if (!processing->parser->stopped() || processing->abortRequested)
+			return;
+
+		processing->abortRequested = true;
+		QMetaObject::invokeMethod(this, [this, processing, reply] {
+			if (processing == _releasesProcessing && reply == _updateCheckReply)
+				reply->abort();
+		}, Qt::QueuedConnection);
+	});
+}
+
+void CAutoUpdaterGithub::updateCheckRequestFinished()
+{
+	auto* reply = qobject_cast<QNetworkReply *>(sender());
+	if (!reply)
+		return;
+
+	reply->deleteLater();
+	if (reply != _updateCheckReply)
+		return;
 
-	for (const auto& item: jsonDocument.array())
+	_updateCheckReply = nullptr;
+
+	ReleasesPage page;
+	page.firstPage = _releasesPagesFetched++ == 0;
+	page.networkError = reply->error() != QNetworkReply::NoError;
+	page.errorString = reply->errorString();
+	page.notModified = page.firstPage && reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304;
+	page.remainingData = reply->readAll();
+	page.etag = reply->rawHeader("ETag");
+	page.lastModified = reply->rawHeader("Last-Modified");
+	if (_releasesPageSize > 0)
+		page.nextPage = nextPageUrl(reply->rawHeader("Link"));
+
+	if (_updateCheckMetrics)
 	{
-		const auto release = item.toObject();
-		if (release["draft"].toBool())
-			continue;
+		_updateCheckMetrics->lastByte = _updateCheckTimer.nsecsElapsed();
+		if (_updateCheckMetrics->firstByte < 0)
+			_updateCheckMetrics->firstByte = _updateCheckMetrics->lastByte;
 
-		QString updateVersion = release["tag_name"].toString();
+		_updateCheckMetrics->bytesReceived += page.remainingData.size();
+		++_updateCheckMetrics->pages;
+	}
 
-		if (updateVersion.startsWith(QStringLiteral(".v")))
-			updateVersion.remove(0, 2);
-		else if (updateVersion.startsWith('v'))
-			updateVersion.remove(0, 1);
+	processReleases(_releasesProcessing, [this, p = _releasesProcessing.get(), page = std::move(page)]() mutable {
+		processReleasesPage(*p, std::move(page));
+	}, [this, p = _releasesProcessing.get()] {
+		releasesProcessed(*p);
+	});
+}
 
-		if (!naturalSortQstringComparator(_currentVersionString, updateVersion))
-			continue; // version <= _currentVersionString, skipping
+// On the worker: the end of a page, and of the check if there are no more pages to request
+void CAutoUpdaterGithub::processReleasesPage(ReleasesProcessing& processing, ReleasesPage&& page) const
+{
+	const auto parser = std::move(processing.parser);
+	const bool feedTruncated = parser->stopped(); // Stopped early in the ordered feed mode, the reply was aborted on purpose
+	processing.nextPage = {};
 
-#ifdef _WIN32
-		static constexpr auto targetExtension = ".exe";
-#elif defined __APPLE__
-		static constexpr auto targetExtension = ".dmg";
-#elif defined __linux__
-		static constexpr auto targetExtension = ".AppImage";
-#else
-		static constexpr auto targetExtension = ".unknown";
-#endif
+	if (page.networkError && !feedTruncated)
+	{
+		processing.error = page.errorString;
+		return;
+	}
+
+	ChangeLog releases;
+	std::vector<CVersionKey> versionKeys;
+	if (page.notModified && processing.cache.hasValidators())
+	{
+		// Not modified - no body was transferred, the cached releases are still current
+		releases = std::move(processing.cache.releases);
+		processing.notModified = true;
+
+		versionKeys.reserve(releases.size());
+		for (const auto& release : releases)
+			versionKeys.emplace_back(release.versionString);
+	}
+	else
+	{
+		processing.feed(page.remainingData);
+		if (!parser->finished() && !feedTruncated)
+		{
+			processing.error = parser->hasError() ? "Failed to parse the list of releases." : "No data downloaded.";
+			return;
+		}
 
-		// Find the appropriate release URL for our platform
-		QString url; // [0]["browser_download_url"].toString()
-		for (const auto& releaseAsset : release["assets"].toArray())
+		if (page.firstPage)
 		{
-			const QString assetUrl = releaseAsset.toObject()["browser_download_url"].toString();
-			if (assetUrl.endsWith(targetExtension))
-			{
-				url = assetUrl;
-				break;
-			}
+			processing.cache.etag = page.etag;
+			processing.cache.lastModified = page.lastModified;
+		}
+
+		// Paginated mode: the next page is only needed if every release on this one is newer than the current version
+		if (!feedTruncated && !processing.pageHasOlderReleases && page.nextPage.isValid())
+		{
+			processing.nextPage = page.nextPage;
+			return;
+		}
+
+		releases = std::move(processing.fetchedReleases);
+		versionKeys = std::move(processing.fetchedVersionKeys);
+
+		if (!processing.cacheFilePath.isEmpty() && processing.cache.hasValidators())
+		{
+			// A 304 for this list only means the same to a check that would cut it short in the same place
+			processing.cache.truncationKey = feedTruncated || page.nextPage.isValid() ? processing.cacheTruncationKey : QString{};
+			processing.cache.releases = releases;
+			processing.cache.store(processing.cacheFilePath);
 		}
+	}
+
+	processing.cache = {};
+	processing.fetchedReleases.clear();
+	processing.fetchedVersionKeys.clear();
+	processing.releaseCount = static_cast<int>(releases.size());
+
+	QElapsedTimer timer;
+	timer.start();
+	processing.newerReleases = newerReleases(releases, versionKeys);
+	processing.filterTime = timer.nsecsElapsed();
+
+	// The listener is likely to show the release notes right away, and this is the part that takes time with long changelogs
+	timer.restart();
+	for (const auto& entry : processing.newerReleases)
+	{
+		if (processing.cancelled)
+			return;
+
+		(void)entry.versionChangesHtml();
+	}
+	processing.markdownTime = timer.nsecsElapsed();
+}
+
+// Back on the updater's thread
+void CAutoUpdaterGithub::releasesProcessed(ReleasesProcessing& processing)
+{
+	if (!processing.error.isEmpty())
+	{
+		if (_listener)
+			_listener->onUpdateError(processing.error);
 
-		if (url.isEmpty())
-			url = release["html_url"].toString(); // Fallback in case there is no download link available
+		return;
+	}
 
-		const QString updateChanges = release["body"].toString().remove('\r');
-		maddy::Parser markdownParser;
-		std::istringstream istream{ updateChanges.toStdString() };
-		std::string htmlChanges = markdownParser.Parse(istream);
+	if (processing.nextPage.isValid())
+	{
+		requestReleasesPage(processing.nextPage);
+		return;
+	}
 
-		QString dateString = release["created_at"].toString();
-		dateString = QDateTime::fromString(dateString, Qt::DateFormat::ISODate).toString("dd MMM yyyy");
+	_availableUpdates = std::move(processing.newerReleases);
+	if (!_updateCheckMetrics)
+	{
+		if (_listener)
+			_listener->onUpdateAvailable(_availableUpdates);
 
-		const bool prerelease = release["prerelease"].toBool();
-		changelog.push_back({ updateVersion, QString::fromStdString(htmlChanges), dateString, url, prerelease, release["name"].toString() });
+		return;
 	}
 
+	// The same, measured
+	UpdateCheckMetrics metrics = *std::exchange(_updateCheckMetrics, std::nullopt);
+	metrics.releases = processing.releaseCount;
+	metrics.newerReleases = static_cast<int>(_availableUpdates.size());
+	metrics.notModified = processing.notModified;
+	metrics.jsonParseTime = processing.jsonParseTime;
+	metrics.filterTime = processing.filterTime;
+	metrics.markdownTime = processing.markdownTime;
+
+	const qint64 listenerStart = _updateCheckTimer.nsecsElapsed();
 	if (_listener)
-		_listener->onUpdateAvailable(changelog);
+		_listener->onUpdateAvailable(_availableUpdates);
+
+	metrics.finished = _updateCheckTimer.nsecsElapsed();
+	metrics.listenerTime = metrics.finished - listenerStart;
+	if (_updateCheckMetricsHandler)
+		_updateCheckMetricsHandler(metrics);
 }
 
-void CAutoUpdaterGithub::updateDownloaded()
+// Selects the releases newer than the current version, versionKeys are the keys of the releases
+CAutoUpdaterGithub::ChangeLog CAutoUpdaterGithub::newerReleases(const ChangeLog& releases, const std::vector<CVersionKey>& versionKeys) const
+{
+	assert(versionKeys.size() == releases.size());
+	ChangeLog changelog;
+
+	for (size_t i = 0; i < releases.size(); ++i)
+	{
+		if (isNewerVersion(releases[i].versionString, versionKeys[i]))
+			changelog.push_back(releases[i]);
+	}
+
+	return changelog;
+}
+
+bool CAutoUpdaterGithub::isNewerVersion(const QString& version, const CVersionKey& versionKey) const
+{
+	if (_lessThanVersionStringComparator)
+		return _lessThanVersionStringComparator(_currentVersionString, version);
+
+	if (_currentVersionKey.isValid() && versionKey.isValid())
+		return _currentVersionKey < versionKey;
+
+	return naturalSortQstringComparator(_currentVersionString, version); // Not a version number, fall back to natural sorting
+}
+
+// The common end of the single- and multi-connection downloads
+void CAutoUpdaterGithub::finishDownload(const QString& errorMessage)
 {
+	_downloadFileWriter->finish(_downloadJournal->bytesReceived);
 	_downloadedBinaryFile.close();
+	_downloadBuffer = {};
 
-	auto* reply = qobject_cast<QNetworkReply *>(sender());
+	if (!errorMessage.isEmpty())
+	{
+		storeDownloadJournal(); // Keep what has been received for the next attempt
+
+		if (_listener)
+			_listener->onUpdateError(errorMessage);
+
+		return;
+	}
+
+	QFile::remove(_downloadJournalFilePath);
+	verifyAgainstPublishedHash(_downloadJournal->url);
+}
+
+// The hash published with the release is either known already, or is in a checksums file
+void CAutoUpdaterGithub::verifyAgainstPublishedHash(const QString& updateUrl)
+{
+	if (!_expectedSha256.isEmpty() || _checksumsUrl.isEmpty())
+	{
+		installDownloadedUpdate(_expectedSha256);
+		return;
+	}
+
+	// The expected hash is in a checksums file, which is tiny compared to the update
+	QNetworkReply * reply = _networkManager->get(updateDownloadRequest(QUrl(_checksumsUrl)));
 	if (!reply)
+	{
+		installDownloadedUpdate({});
 		return;
+	}
 
-	reply->deleteLater();
+	connect(reply, &QNetworkReply::finished, this, [this, reply, updateFileName = QUrl(updateUrl).fileName()] {
+		reply->deleteLater();
+		installDownloadedUpdate(reply->error() == QNetworkReply::NoError ? sha256FromChecksumsFile(reply->readAll(), updateFileName) : QByteArray{});
+	});
+}
 
-	if (reply->error() != QNetworkReply::NoError)
+// The file is read again for the hash check if it couldn't be hashed while it was being written. That and the installation itself run on a worker thread,
+// the results are reported back on this one.
+void CAutoUpdaterGithub::installDownloadedUpdate(const QByteArray& expectedSha256)
+{
+	if (expectedSha256.isEmpty() && _updateVerificationRequired)
 	{
 		if (_listener)
-			_listener->onUpdateError(reply->errorString());
+			_listener->onUpdateError("The update can't be verified: the release doesn't publish its SHA-256.");
 
 		return;
 	}
@@ -191,14 +1456,100 @@ void CAutoUpdaterGithub::updateDownloaded()
 	if (_listener)
 		_listener->onUpdateDownloadFinished();
 
-	if (!UpdateInstaller::install(_downloadedBinaryFile.fileName()) && _listener)
-		_listener->onUpdateError("Failed to launch the downloaded update.");
+	const QByteArray downloadSha256 = _downloadHashComplete ? _downloadHash->result().toHex() : QByteArray{};
+	_installationCancelled = false;
+	_installationThread.reset(QThread::create([this, filePath = _downloadedBinaryFile.fileName(), expectedSha256, downloadSha256, relaunch = _relaunchAfterInstall] {
+		const UpdateInstaller::ProgressHandler onProgress = [this](UpdateInstaller::Stage stage, float percentage) {
+			QMetaObject::invokeMethod(this, [this, stage, percentage] {
+				if (_listener)
+					_listener->onUpdateInstallationProgress(stage, percentage);
+			}, Qt::QueuedConnection);
+		};
+
+		InstallationResult result = InstallationResult::Installed;
+		if (!expectedSha256.isEmpty() && (downloadSha256.isEmpty() ? fileSha256(filePath, onProgress, _installationCancelled) : downloadSha256) != expectedSha256)
+			result = _installationCancelled ? InstallationResult::Cancelled : InstallationResult::Corrupted;
+		else if (!UpdateInstaller::install(filePath, relaunch, onProgress, &_installationCancelled))
+			result = _installationCancelled ? InstallationResult::Cancelled : InstallationResult::Failed;
+
+		QMetaObject::invokeMethod(this, [this, result] { installationFinished(result); }, Qt::QueuedConnection);
+	}));
+
+	_installationThread->start();
+}
+
+void CAutoUpdaterGithub::installationFinished(InstallationResult result)
+{
+	_installationThread->wait();
+	_installationThread.reset();
+
+	// Don't leave a corrupted file around for the next attempt to resume from
+	if (result == InstallationResult::Corrupted)
+		QFile::remove(_downloadedBinaryFile.fileName());
+
+	if (!_listener)
+		return;
+
+	switch (result)
+	{
+	case InstallationResult::Installed:
+		_listener->onUpdateInstalled();
+		break;
+	case InstallationResult::Corrupted:
+		_listener->onUpdateError("The downloaded update is corrupted: its SHA-256 doesn't match the one published with the release.");
+		break;
+	case InstallationResult::Failed:
+		_listener->onUpdateError("Failed to install the downloaded update.");
+		break;
+	case InstallationResult::Cancelled:
+		break;
+	}
+}
+
+void CAutoUpdaterGithub::cancelInstallation()
+{
+	_installationCancelled = true;
+}
+
+void CAutoUpdaterGithub::updateDownloaded()
+{
+	auto* reply = qobject_cast<QNetworkReply *>(sender());
+	if (!reply)
+		return;
+
+	reply->deleteLater();
+
+	if (_downloadRestartRequired)
+	{
+		// The partial file doesn't fit the resource on the server, start over
+		_downloadFileWriter->finish(_downloadJournal->bytesReceived);
+		_downloadedBinaryFile.close();
+		QFile::remove(_downloadJournalFilePath);
+		startDownload(_downloadJournal->url, false);
+		return;
+	}
+
+	finishDownload(reply->error() != QNetworkReply::NoError ? reply->errorString() : QString{});
+}
+
+void CAutoUpdaterGithub::reportDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
+{
+	DownloadProgress progress;
+	if (!_listener || !_downloadProgressThrottle.update(bytesReceived, bytesTotal, progress))
+		return;
+
+	_listener->onUpdateDownloadProgress(progress.percentage());
+	_listener->onUpdateDownloadProgressDetails(progress);
 }
 
 void CAutoUpdaterGithub::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
-	if (_listener)
-		_listener->onUpdateDownloadProgress(bytesReceived < bytesTotal ? static_cast<float>(bytesReceived * 100) / static_cast<float>(bytesTotal) : 100.0f);
+	// A resumed download only transfers the rest of the file
+	bytesReceived += _downloadResumeOffset;
+	if (bytesTotal > 0)
+		bytesTotal += _downloadResumeOffset;
+
+	reportDownloadProgress(bytesReceived, bytesTotal);
 }
 
 void CAutoUpdaterGithub::onNewDataDownloaded()
@@ -207,5 +1558,40 @@ void CAutoUpdaterGithub::onNewDataDownloaded()
 	if (!reply)
 		return;
 
-	_downloadedBinaryFile.write(reply->readAll());
+	if (!_downloadResponseChecked)
+	{
+		_downloadResponseChecked = true;
+		_downloadResponseAccepted = acceptDownloadResponse(reply);
+		if (_downloadRestartRequired)
+		{
+			reply->abort();
+			return;
+		}
+	}
+
+	if (!_downloadResponseAccepted)
+	{
+		reply->skip(reply->bytesAvailable());
+		return;
+	}
+
+	// No allocations per chunk: the data is read into the same buffer every time and written through to the file
+	for (qint64 bytesRead = 0; (bytesRead = reply->read(_downloadBuffer.data(), _downloadBufferSize)) > 0;)
+	{
+		if (!_downloadFileWriter->write(_downloadJournal->bytesReceived, _downloadBuffer.data(), bytesRead))
+		{
+			disconnect(reply, nullptr, this, nullptr);
+			reply->abort();
+			reply->deleteLater();
+			finishDownload("Failed to write the update to " + _downloadedBinaryFile.fileName());
+			return;
+		}
+
+		if (_downloadHashComplete)
+			_downloadHash->addData(_downloadBuffer.data(), bytesRead);
+		_downloadJournal->bytesReceived += bytesRead;
+	}
+
+	if (_downloadJournal->bytesReceived - _journalStoredBytes >= downloadJournalUpdateInterval)
+		storeDownloadJournal();
 }
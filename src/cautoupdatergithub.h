@@ -1,14 +1,24 @@
 #pragma once
 
 #include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+#include "cdownloadprogressthrottle.h"
+#include "cversionkey.h"
+#include "updateinstaller.hpp"
 
 DISABLE_COMPILER_WARNINGS
+#include <QCryptographicHash>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QNetworkAccessManager>
 #include <QString>
+#include <QStringList>
+#include <QThreadPool>
 RESTORE_COMPILER_WARNINGS
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #if defined _WIN32
@@ -19,6 +29,14 @@ RESTORE_COMPILER_WARNINGS
 #define UPDATE_FILE_EXTENSION QLatin1String(".AppImage")
 #endif
 
+class CDeltaPatcher;
+class CDownloadFileWriter;
+class CDownloadJournal;
+class CSegmentedDownload;
+class CZsyncIndex;
+class QNetworkReply;
+class QThread;
+
 class CAutoUpdaterGithub final : public QObject
 {
 public:
@@ -26,51 +44,238 @@ public:
 
 	struct VersionEntry {
 		QString versionString;
-		QString versionChanges;
+		QString versionChanges; // The release notes in Markdown, as published
 		QString date;
 		QString versionUpdateUrl;
 		bool isPrerelease = false;
 		QString releaseTitle;
+		QByteArray updateSha256 = {}; // Hex, empty if the release doesn't publish a digest for the update asset
+		QString updateChecksumsUrl = {}; // A SHA256SUMS / <asset>.sha256 file of the release, if the asset has no digest of its own
+		QStringList deltaUpdateUrls = {}; // The <asset>.from-<version>.delta patches of the release, from any version
+		QString zsyncUrl = {}; // The <asset>.zsync block index, published with AppImages
+
+		// The release notes converted to HTML. The entries reported by onUpdateAvailable() have been converted on a worker thread during the check,
+		// any others are converted on first access.
+		[[nodiscard]] const QString& versionChangesHtml() const;
+
+		mutable std::optional<QString> versionChangesHtmlCache = {};
 	};
 
 	using ChangeLog = std::vector<VersionEntry>;
 
+	// How the downloaded update is written to disk
+	enum class DownloadIoStrategy {
+		Append,       // The file grows with every chunk
+		Preallocated, // The space for the whole file is reserved up front when its size is known, the chunks are written at their offsets
+		MemoryMapped  // Preallocated, and the chunks are copied into a mapping of the file instead of being written with a system call each
+	};
+
+	using DownloadProgress = CDownloadProgressThrottle::Progress;
+
+	// Where the time of an update check goes. The timestamps are in nanoseconds since checkForUpdates() (monotonic), -1 if not reached;
+	// the durations are in nanoseconds as well. Pages and sizes cover all the pages requested.
+	struct UpdateCheckMetrics {
+		qint64 firstByte = -1;    // Of the reply to the first request: DNS, TCP / TLS and GitHub's own time
+		qint64 lastByte = -1;     // Of the last page
+		qint64 finished = -1;     // When the listener has returned
+		qint64 jsonParseTime = 0; // Parsing the JSON and building the VersionEntry list as the data arrived, on the worker thread
+		qint64 filterTime = 0;    // Selecting the releases newer than the current version, on the worker thread
+		qint64 markdownTime = 0;  // Converting the release notes of the newer releases to HTML, on the worker thread
+		qint64 listenerTime = 0;  // onUpdateAvailable()
+		qint64 bytesReceived = 0; // The bodies of the replies
+		int pages = 0;
+		int releases = 0;         // Parsed, or loaded from the cache
+		int newerReleases = 0;
+		bool notModified = false; // 304, the releases came from the cache
+
+		// One line of JSON with a "format" version, for collecting the metrics from many machines
+		[[nodiscard]] QByteArray toJson() const;
+	};
+
 	struct UpdateStatusListener {
 		virtual ~UpdateStatusListener() = default;
 		// If no updates are found, the changelog is empty
 		virtual void onUpdateAvailable(const ChangeLog& changelog) = 0;
 		virtual void onUpdateDownloadProgress(float percentageDownloaded) = 0;
+		// Called right after onUpdateDownloadProgress(), with the sizes, the transfer rate and the time remaining
+		virtual void onUpdateDownloadProgressDetails(const DownloadProgress& /*progress*/) {}
 		virtual void onUpdateDownloadFinished() = 0;
 		virtual void onUpdateError(const QString& errorMessage) = 0;
+		// The downloaded update is verified and installed on a worker thread, these are called on the thread that requested the update
+		virtual void onUpdateInstallationProgress(UpdateInstaller::Stage /*stage*/, float /*percentage*/) {}
+		virtual void onUpdateInstalled() {}
 	};
 
 public:
-	// If the string comparison functior is not supplied, case-insensitive natural sorting is used (using QCollator)
+	// If the string comparison functior is not supplied, the versions are parsed into CVersionKey (numeric segments + semver pre-release tags),
+	// falling back to case-insensitive natural sorting (using QCollator) for version strings that don't start with a number.
+	// The releases list is processed on a worker thread, and so is the comparator called; all the listener callbacks still arrive on the thread
+	// that owns the updater.
 	CAutoUpdaterGithub(QString githubRepositoryName, // Name of the repo, e. g. VioletGiraffe/github-releases-autoupdater
 					   QString currentVersionString,
 					   const std::function<bool (const QString&, const QString&)>& versionStringComparatorLessThan = {});
+	~CAutoUpdaterGithub() override;
 
 	CAutoUpdaterGithub& operator=(const CAutoUpdaterGithub& other) = delete;
 
 	void setUpdateStatusListener(UpdateStatusListener* listener);
+	// https://api.github.com by default. For a GitHub Enterprise server (https://<host>/api/v3), or a local stand-in for testing.
+	void setApiBaseUrl(const QString& baseUrl);
+	// All the requests - the update check, the downloads - go through this manager instead of the updater's own one (nullptr switches back).
+	// A subclass that overrides createRequest() can serve them from anywhere, e. g. to simulate a slow network. It must outlive the requests made through it.
+	void setNetworkAccessManager(QNetworkAccessManager* networkManager);
+	// The releases list is cached on disk together with its ETag / Last-Modified, and the next check is a conditional request.
+	// If GitHub replies 304 Not Modified, the changelog is rebuilt from the cache. The default location is under QStandardPaths::CacheLocation.
+	// Pass an empty path to disable the cache.
+	void setReleaseCacheFilePath(const QString& cacheFilePath);
+	// Ordered feed mode: GitHub lists the releases newest first, so once this many consecutive releases are not newer than the current version,
+	// parsing stops and the rest of the list is not downloaded. 0 (the default) disables the mode and the whole list is processed.
+	void setOrderedFeedStopThreshold(int consecutiveOlderReleases);
+	// Paginated mode: the releases are requested in pages of this size (GitHub allows up to 100), and the next page is only requested
+	// while every release on the current one is newer than the current version, following the Link: rel="next" header.
+	// 0 (the default) requests the single default page.
+	void setReleasesPageSize(int releasesPerPage);
+	// The update is downloaded in chunks of this size: the data is read from the network reply into one reusable buffer and written to the file
+	// from there, and the reply doesn't buffer more than that either. The default is 256 KiB.
+	void setDownloadBufferSize(qint64 bufferSize);
+	// Multi-connection mode: the update is split into up to segmentCount byte ranges of at least minSegmentSize bytes each, which are downloaded
+	// concurrently and written at their offsets into the preallocated file. Requires range support on the server (checked with a HEAD request first),
+	// otherwise the update is downloaded over a single connection. Qt opens at most 6 connections per host. 1 (the default) disables the mode.
+	void setDownloadSegmentation(int segmentCount, qint64 minSegmentSize = 4 * 1024 * 1024);
+	// The download progress is reported at most once per minimumInterval (ms), and only once it has moved on by minimumDelta percentage points;
+	// the notifications in between are dropped. 100 ms and 0.1 % by default, 0 for both reports every notification from the network.
+	void setDownloadProgressThrottling(qint64 minimumInterval, float minimumDelta);
+	// Preallocated by default. Segmented downloads are always at least Preallocated.
+	void setDownloadIoStrategy(DownloadIoStrategy strategy);
+	// If the update is from the last reported changelog and the release publishes its SHA-256 (the asset digest, or a SHA256SUMS / <asset>.sha256 file),
+	// the file is hashed while it's being written and only installed if the hash matches.
+	// Off by default: requires a published SHA-256 for every update, the updates without one are not installed.
+	void setUpdateVerificationRequired(bool required);
+	// Delta updates: if the release has a <update asset>.from-<current version string>.delta asset, only the patch is downloaded and applied
+	// to this file, which must be the installed copy of the previous version of the same asset (see CDeltaPatcher for the format, DeltaGenerator for making the patches).
+	// Falls back to the full update if there's no such patch, or if the patch doesn't apply. Defaults to $APPIMAGE on Linux / FreeBSD, unset elsewhere.
+	// Without a patch, if the release has a <update asset>.zsync index, the blocks of the update that are already in this file are copied from it,
+	// and only the rest is downloaded with Range requests.
+	void setDeltaUpdateBaseFile(const QString& filePath);
+	// Linux / FreeBSD: start the new version once it has replaced the running AppImage. The application should quit on onUpdateInstalled() then.
+	void setRelaunchAfterInstall(bool relaunch);
+
+	// Collects UpdateCheckMetrics for every successful check and hands them over right after onUpdateAvailable(). No handler (the default): no metrics,
+	// and no overhead beyond a null check per chunk of data.
+	void setUpdateCheckMetricsHandler(std::function<void (const UpdateCheckMetrics&)> metricsHandler);
 
 	void checkForUpdates();
+	// An interrupted download is resumed where it stopped (Range / If-Range), provided that it's the same URL and the server supports it
 	void downloadAndInstallUpdate(const QString& updateUrl);
+	// Stops the installation of the downloaded update unless it's already replacing the installed version, which is then left as it was.
+	// There's no callback for a cancelled installation. The destructor waits for an installation that is not cancelled to finish.
+	void cancelInstallation();
 
 private:
+	enum class InstallationResult { Installed, Corrupted, Failed, Cancelled };
+	struct ReleasesProcessing;
+	struct ReleasesPage;
+	struct ZsyncAssembly;
+
+	void requestReleasesPage(const QUrl& url);
+	void releasesDataReceived();
 	void updateCheckRequestFinished();
+	void processReleasesPage(ReleasesProcessing& processing, ReleasesPage&& page) const;
+	void releasesProcessed(ReleasesProcessing& processing);
+	// Runs work on _releasesProcessingPool, then continuation on this thread unless another check has started in the meantime
+	void processReleases(const std::shared_ptr<ReleasesProcessing>& processing, std::function<void ()> work, std::function<void ()> continuation = {});
+	ChangeLog newerReleases(const ChangeLog& releases, const std::vector<CVersionKey>& versionKeys) const;
+	// versionKey is built from version once per release, and only used without a custom comparator
+	bool isNewerVersion(const QString& version, const CVersionKey& versionKey) const;
+
+	void startDeltaDownload(const QString& deltaUrl, const QString& updateUrl);
+	void requestDeltaUpdate(const QString& deltaUrl, const QByteArray& baseFileSha256);
+	bool feedDeltaPatcher(QNetworkReply* reply);
+	void onNewDeltaDataDownloaded();
+	void deltaDownloaded();
+	void startZsyncDownload(const QString& zsyncUrl, const QString& updateUrl);
+	void zsyncIndexDownloaded();
+	void zsyncTargetProbed();
+	void zsyncLocalBlocksCopied(const ZsyncAssembly& assembly, const QUrl& url, const QByteArray& ifRangeValidator);
+	void zsyncDownloadFinished(const QString& errorMessage);
+	// Runs work on _downloadProcessingPool, then continuation on this thread unless another download has started in the meantime.
+	// For reading whole files, which would block the event loop. work only has what it has been given, none of the download's members.
+	void processDownload(std::function<void ()> work, std::function<void ()> continuation);
+	void fallBackToFullDownload();
+	void startDownload(const QString& updateUrl, bool resume);
+	void requestDownload();
+	void requestSingleDownload();
+	void downloadSizeProbed();
+	void startSegmentedDownload(const QUrl& url, qint64 totalSize);
+	bool acceptDownloadResponse(QNetworkReply* reply);
+	void storeDownloadJournal();
+	void finishDownload(const QString& errorMessage);
+	void verifyAgainstPublishedHash(const QString& updateUrl);
+	void installDownloadedUpdate(const QByteArray& expectedSha256);
+	void installationFinished(InstallationResult result);
 	void updateDownloaded();
+	void reportDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 	void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 	void onNewDataDownloaded();
 
 private:
 	QFile _downloadedBinaryFile;
+	std::vector<char> _downloadBuffer;
+	qint64 _downloadBufferSize = 256 * 1024;
+	QString _downloadJournalFilePath;
+	std::unique_ptr<CDownloadJournal> _downloadJournal;
+	qint64 _downloadResumeOffset = 0;
+	qint64 _journalStoredBytes = 0;
+	bool _downloadResponseChecked = false;
+	bool _downloadResponseAccepted = false;
+	bool _downloadRestartRequired = false;
+	int _downloadSegmentCount = 1;
+	qint64 _minDownloadSegmentSize = 4 * 1024 * 1024;
+	std::unique_ptr<CSegmentedDownload> _segmentedDownload;
+	std::unique_ptr<CDownloadFileWriter> _downloadFileWriter;
+	DownloadIoStrategy _downloadIoStrategy = DownloadIoStrategy::Preallocated;
+	CDownloadProgressThrottle _downloadProgressThrottle;
+	// Replaced rather than reset by the tasks on _downloadProcessingPool, which hash into their own object and hand it over when done
+	std::unique_ptr<QCryptographicHash> _downloadHash = std::make_unique<QCryptographicHash>(QCryptographicHash::Sha256);
+	bool _downloadHashComplete = false; // Whether _downloadHash covers the whole file, i. e. the data has been written strictly in order
+	bool _downloadHashRequired = false; // There's a published SHA-256 to check the download against, or one to look up once it's complete
+	QByteArray _expectedSha256;
+	QString _checksumsUrl;
+	bool _updateVerificationRequired = false;
+	QString _deltaUpdateBaseFilePath;
+	std::unique_ptr<CDeltaPatcher> _deltaPatcher;
+	QString _fullUpdateUrl; // The fallback if the delta or zsync update fails
+	qint64 _deltaOutputSize = 0;
+	std::unique_ptr<CZsyncIndex> _zsyncIndex;
+	QThreadPool _downloadProcessingPool; // A single thread, the download is paused while it works on its files
+	quint64 _downloadId = 0; // Of the current downloadAndInstallUpdate(), the continuations of the tasks started for an earlier one are dropped
+	bool _relaunchAfterInstall = false;
+	std::unique_ptr<QThread> _installationThread;
+	std::atomic<bool> _installationCancelled{ false };
+
+	QString _apiBaseUrl = QStringLiteral("https://api.github.com");
 	const QString _repoName;
 	const QString _currentVersionString;
+	const CVersionKey _currentVersionKey;
 	const std::function<bool (const QString&, const QString&)> _lessThanVersionStringComparator;
 
+	QString _releaseCacheFilePath;
+
+	QNetworkReply* _updateCheckReply = nullptr;
+	std::shared_ptr<ReleasesProcessing> _releasesProcessing; // Of the check in progress
+	QThreadPool _releasesProcessingPool; // A single thread: the tasks run one at a time, in the order they were started
+	ChangeLog _availableUpdates; // The last reported changelog
+	int _orderedFeedStopThreshold = 0;
+	int _releasesPageSize = 0;
+	int _releasesPagesFetched = 0;
+
+	std::function<void (const UpdateCheckMetrics&)> _updateCheckMetricsHandler;
+	std::optional<UpdateCheckMetrics> _updateCheckMetrics; // Only while a check is running with a handler set
+	QElapsedTimer _updateCheckTimer;
+
 	UpdateStatusListener* _listener = nullptr;
 
-	QNetworkAccessManager _networkManager;
+	QNetworkAccessManager _ownNetworkManager;
+	QNetworkAccessManager* _networkManager = &_ownNetworkManager;
 };
 
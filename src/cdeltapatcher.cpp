@@ -0,0 +1,204 @@
+#include "cdeltapatcher.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+#include <utility>
+
+static constexpr char deltaMagic[8] = {'G', 'H', 'R', 'D', 'I', 'F', 'F', '1'};
+static constexpr qint64 deltaHeaderSize = sizeof(deltaMagic) + 2 * 8 + 2 * 32;
+// A sanity limit, the blocks are expected to be a few MB at most
+static constexpr qint64 maxBlockSize = 64 * 1024 * 1024;
+
+static uint64_t readBigEndian(const char* data, size_t size)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < size; ++i)
+		value = (value << 8) | static_cast<uint8_t>(data[i]);
+
+	return value;
+}
+
+static qint64 readInt64(const char* data)
+{
+	return static_cast<qint64>(readBigEndian(data, 8));
+}
+
+CDeltaPatcher::CDeltaPatcher(const QString& oldFilePath, QByteArray oldFileSha256, OutputHandler outputHandler) :
+	_oldFile(oldFilePath),
+	_oldFileSha256(std::move(oldFileSha256)),
+	_outputHandler(std::move(outputHandler))
+{
+	assert(_outputHandler);
+}
+
+bool CDeltaPatcher::feed(const char* data, qint64 size)
+{
+	if (!_errorString.isEmpty())
+		return false;
+
+	_input.append(data, size);
+
+	qint64 position = 0;
+	for (;;)
+	{
+		const qint64 available = _input.size() - position;
+		if (_oldSize < 0)
+		{
+			if (available < deltaHeaderSize)
+				break;
+
+			if (!parseHeader(_input.constData() + position))
+				return false;
+
+			position += deltaHeaderSize;
+			continue;
+		}
+
+		if (available < 4)
+			break;
+
+		const auto blockSize = static_cast<qint64>(readBigEndian(_input.constData() + position, 4));
+		if (blockSize < 4 || blockSize > maxBlockSize)
+			return fail("Invalid delta block.");
+
+		if (available < 4 + blockSize)
+			break;
+
+		if (!processBlock(_input.constData() + position + 4, blockSize))
+			return false;
+
+		position += 4 + blockSize;
+	}
+
+	_input.remove(0, position);
+	return true;
+}
+
+bool CDeltaPatcher::finished() const
+{
+	return _errorString.isEmpty() && _oldSize >= 0 && _newPosition == _newSize && _recordHeaderSize == 0 && _diffRemaining == 0 && _extraRemaining == 0 && _input.isEmpty();
+}
+
+const QString& CDeltaPatcher::errorString() const
+{
+	return _errorString;
+}
+
+qint64 CDeltaPatcher::newFileSize() const
+{
+	return _newSize;
+}
+
+QByteArray CDeltaPatcher::newFileSha256() const
+{
+	return _newFileSha256;
+}
+
+bool CDeltaPatcher::parseHeader(const char* header)
+{
+	if (::memcmp(header, deltaMagic, sizeof(deltaMagic)) != 0)
+		return fail("Not a delta update.");
+
+	header += sizeof(deltaMagic);
+	_oldSize = readInt64(header);
+	_newSize = readInt64(header + 8);
+	const QByteArray oldFileSha256 = QByteArray(header + 16, 32).toHex();
+	_newFileSha256 = QByteArray(header + 48, 32).toHex();
+
+	if (_oldSize < 0 || _newSize < 0)
+		return fail("Invalid delta header.");
+
+	// The delta only applies to the exact file it was made from
+	if (oldFileSha256 != _oldFileSha256 || !_oldFile.open(QFile::ReadOnly) || _oldFile.size() != _oldSize)
+		return fail("The delta doesn't apply to the installed version.");
+
+	return true;
+}
+
+bool CDeltaPatcher::processBlock(const char* data, qint64 size)
+{
+	const QByteArray block = qUncompress(reinterpret_cast<const uchar*>(data), static_cast<qsizetype>(size));
+	if (block.isEmpty())
+		return fail("Invalid delta block.");
+
+	const char* recordData = block.constData();
+	qint64 remaining = block.size();
+	while (remaining > 0)
+	{
+		if (_diffRemaining == 0 && _extraRemaining == 0)
+		{
+			// The record header, possibly split between two blocks
+			const size_t headerBytes = std::min(sizeof(_recordHeader) - _recordHeaderSize, static_cast<size_t>(remaining));
+			::memcpy(_recordHeader + _recordHeaderSize, recordData, headerBytes);
+			_recordHeaderSize += headerBytes;
+			recordData += headerBytes;
+			remaining -= static_cast<qint64>(headerBytes);
+			if (_recordHeaderSize < sizeof(_recordHeader))
+				break;
+
+			_recordHeaderSize = 0;
+			_diffRemaining = readInt64(_recordHeader);
+			_extraRemaining = readInt64(_recordHeader + 8);
+			_oldSeek = readInt64(_recordHeader + 16);
+			if (_diffRemaining < 0 || _extraRemaining < 0 || _diffRemaining > _newSize - _newPosition || _extraRemaining > _newSize - _newPosition - _diffRemaining)
+				return fail("Invalid delta record.");
+		}
+		else
+		{
+			const qint64 length = std::min(remaining, _diffRemaining > 0 ? _diffRemaining : _extraRemaining);
+			if (!processRecordData(recordData, length))
+				return false;
+
+			recordData += length;
+			remaining -= length;
+		}
+
+		// The record is complete
+		if (_recordHeaderSize == 0 && _diffRemaining == 0 && _extraRemaining == 0)
+		{
+			_oldPosition += _oldSeek;
+			_oldSeek = 0;
+		}
+	}
+
+	return true;
+}
+
+bool CDeltaPatcher::processRecordData(const char* data, qint64 size)
+{
+	if (_diffRemaining == 0)
+	{
+		// Extra bytes: new data that isn't in the old file
+		if (!_outputHandler(data, size))
+			return fail("Failed to write the update.");
+
+		_extraRemaining -= size;
+		_newPosition += size;
+		return true;
+	}
+
+	if (_oldPosition < 0 || size > _oldSize - _oldPosition)
+		return fail("Invalid delta record.");
+
+	_oldData.resize(static_cast<size_t>(size));
+	if (!_oldFile.seek(_oldPosition) || _oldFile.read(_oldData.data(), size) != size)
+		return fail("Failed to read the installed version.");
+
+	for (size_t i = 0; i < _oldData.size(); ++i)
+		_oldData[i] = static_cast<char>(static_cast<uint8_t>(_oldData[i]) + static_cast<uint8_t>(data[i]));
+
+	if (!_outputHandler(_oldData.data(), size))
+		return fail("Failed to write the update.");
+
+	_diffRemaining -= size;
+	_oldPosition += size;
+	_newPosition += size;
+	return true;
+}
+
+bool CDeltaPatcher::fail(const QString& errorMessage)
+{
+	_errorString = errorMessage;
+	return false;
+}
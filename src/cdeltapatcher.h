@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+
+// Applies a binary delta to the installed version of the program as the delta is being downloaded, producing the new version without
+// ever holding either file or the delta in memory. The new file is handed out in order, chunk by chunk.
+//
+// The delta format ("GHRDIFF1") is bsdiff-like, with zlib compression in independent blocks so that it can be decompressed as it arrives:
+//   header:  "GHRDIFF1", the old and the new file size (int64 BE each), the SHA-256 of the old and of the new file (32 bytes each)
+//   then blocks: uint32 BE length, followed by that many bytes of qCompress() output (a uint32 BE uncompressed size + a zlib stream).
+// The uncompressed blocks, concatenated, form a sequence of records (which may span blocks):
+//   int64 BE diff length, int64 BE extra length, int64 BE old seek,
+//   the diff bytes, which are added (mod 256) to as many bytes of the old file from the current old position on,
+//   the extra bytes, which are copied as they are,
+//   after which the old position moves by the diff length plus the old seek.
+// DeltaGenerator (deltagenerator.hpp) makes the deltas.
+class CDeltaPatcher
+{
+public:
+	using OutputHandler = std::function<bool (const char* data, qint64 size)>;
+
+	// oldFileSha256 (hex) is the hash of the old file, which the delta must have been made from. Hashing the whole file is up to the caller,
+	// so that it can be done on a worker thread.
+	CDeltaPatcher(const QString& oldFilePath, QByteArray oldFileSha256, OutputHandler outputHandler);
+
+	// Returns false if the delta is invalid, doesn't apply to the old file, or the output can't be written
+	bool feed(const char* data, qint64 size);
+	// True once the complete new file has been produced
+	[[nodiscard]] bool finished() const;
+	[[nodiscard]] const QString& errorString() const;
+
+	// Known once the header has been received, i. e. by the first call of the output handler
+	[[nodiscard]] qint64 newFileSize() const;
+	// Hex, known once the header has been received. It's up to the caller to check the output against it.
+	[[nodiscard]] QByteArray newFileSha256() const;
+
+private:
+	bool parseHeader(const char* header);
+	bool processBlock(const char* data, qint64 size);
+	bool processRecordData(const char* data, qint64 size);
+	bool fail(const QString& errorMessage);
+
+private:
+	QFile _oldFile;
+	const QByteArray _oldFileSha256;
+	const OutputHandler _outputHandler;
+
+	QByteArray _input; // Received, but not processed yet: an incomplete header or block
+	std::vector<char> _oldData;
+
+	qint64 _oldSize = -1; // -1 until the header is parsed
+	qint64 _newSize = 0;
+	QByteArray _newFileSha256;
+
+	char _recordHeader[24];
+	size_t _recordHeaderSize = 0;
+	qint64 _diffRemaining = 0;
+	qint64 _extraRemaining = 0;
+	qint64 _oldSeek = 0;
+	qint64 _oldPosition = 0;
+	qint64 _newPosition = 0;
+
+	QString _errorString;
+};
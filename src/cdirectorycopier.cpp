@@ -0,0 +1,283 @@
+#include "cdirectorycopier.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <copyfile.h>
+#endif
+
+namespace {
+
+struct FileCopyJob {
+	std::string source;
+	std::string target;
+	mode_t mode;
+	off_t size;
+};
+
+struct DirectoryPermissions {
+	std::string path;
+	mode_t mode;
+};
+
+} // namespace
+
+static std::string systemErrorMessage(const char* operation, const std::string& path)
+{
+	return std::string("Failed to ") + operation + ' ' + path + ": " + ::strerror(errno);
+}
+
+// Creates the directories and the symlinks, and collects the files to be copied
+static bool walk(const std::string& source, const std::string& target, std::vector<FileCopyJob>& files, std::vector<DirectoryPermissions>& directories, std::string& error)
+{
+	struct stat sourceStat;
+	if (::lstat(source.c_str(), &sourceStat) != 0)
+	{
+		error = systemErrorMessage("access", source);
+		return false;
+	}
+
+	if (S_ISDIR(sourceStat.st_mode))
+	{
+		// Writable until everything has been copied into it, the actual permissions are set at the end
+		if (::mkdir(target.c_str(), 0700) != 0)
+		{
+			error = systemErrorMessage("create", target);
+			return false;
+		}
+
+		directories.push_back({ target, static_cast<mode_t>(sourceStat.st_mode & 07777) });
+
+		DIR* directory = ::opendir(source.c_str());
+		if (!directory)
+		{
+			error = systemErrorMessage("open", source);
+			return false;
+		}
+
+		bool ok = true;
+		while (const dirent* entry = ok ? ::readdir(directory) : nullptr)
+		{
+			if (::strcmp(entry->d_name, ".") != 0 && ::strcmp(entry->d_name, "..") != 0)
+				ok = walk(source + '/' + entry->d_name, target + '/' + entry->d_name, files, directories, error);
+		}
+
+		::closedir(directory);
+		return ok;
+	}
+	else if (S_ISLNK(sourceStat.st_mode))
+	{
+		// Bundles link within themselves (e. g. Versions/Current), the links are copied as they are
+		std::string linkTarget(static_cast<size_t>(std::max<off_t>(sourceStat.st_size, 0)) + 256, '\0');
+		const ssize_t length = ::readlink(source.c_str(), linkTarget.data(), linkTarget.size());
+		if (length < 0 || static_cast<size_t>(length) == linkTarget.size())
+		{
+			error = systemErrorMessage("read the link", source);
+			return false;
+		}
+
+		linkTarget.resize(static_cast<size_t>(length));
+		if (::symlink(linkTarget.c_str(), target.c_str()) != 0)
+		{
+			error = systemErrorMessage("create", target);
+			return false;
+		}
+	}
+	else if (S_ISREG(sourceStat.st_mode))
+		files.push_back({ source, target, static_cast<mode_t>(sourceStat.st_mode & 07777), sourceStat.st_size });
+
+	// Anything else (sockets, FIFOs, devices) doesn't belong in a bundle and is skipped
+	return true;
+}
+
+static bool copyFile(const FileCopyJob& file, std::string& error)
+{
+#ifdef __APPLE__
+	// Clones the file if the source and the target are on the same APFS volume, copies the data, permissions and extended attributes otherwise
+	if (::copyfile(file.source.c_str(), file.target.c_str(), nullptr, COPYFILE_ALL | COPYFILE_CLONE | COPYFILE_EXCL | COPYFILE_NOFOLLOW) != 0)
+	{
+		error = systemErrorMessage("copy", file.source);
+		return false;
+	}
+
+	return true;
+#else
+	const int sourceFd = ::open(file.source.c_str(), O_RDONLY | O_CLOEXEC);
+	if (sourceFd < 0)
+	{
+		error = systemErrorMessage("open", file.source);
+		return false;
+	}
+
+	const int targetFd = ::open(file.target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	const bool copied = targetFd >= 0 && CDirectoryCopier::copyFileContents(sourceFd, targetFd) && ::fchmod(targetFd, file.mode) == 0;
+	if (!copied)
+		error = systemErrorMessage("copy", file.source);
+
+	::close(sourceFd);
+	if (targetFd >= 0)
+		::close(targetFd);
+
+	return copied;
+#endif
+}
+
+CDirectoryCopier::CDirectoryCopier(int threadCount) :
+	_threadCount(threadCount > 0 ? threadCount : static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u)))
+{
+}
+
+void CDirectoryCopier::setProgressHandler(std::function<void (float percentage)> onProgress)
+{
+	_onProgress = std::move(onProgress);
+}
+
+void CDirectoryCopier::setCancellationFlag(const std::atomic<bool>* cancelled)
+{
+	_cancelled = cancelled;
+}
+
+bool CDirectoryCopier::copy(const QString& sourcePath, const QString& targetPath)
+{
+	_errorString.clear();
+
+	std::vector<FileCopyJob> files;
+	std::vector<DirectoryPermissions> directories;
+	std::string error;
+	if (!walk(QFile::encodeName(sourcePath).toStdString(), QFile::encodeName(targetPath).toStdString(), files, directories, error))
+	{
+		_errorString = QString::fromStdString(error);
+		return false;
+	}
+
+	// The largest files first, so that a big one doesn't end up being copied alone at the end
+	std::sort(files.begin(), files.end(), [](const FileCopyJob& l, const FileCopyJob& r) { return l.size > r.size; });
+
+	qint64 totalSize = 0;
+	for (const FileCopyJob& file : files)
+		totalSize += file.size;
+
+	std::atomic<size_t> nextFile{ 0 };
+	std::atomic<qint64> copiedSize{ 0 };
+	std::atomic<int> reportedPercentage{ 0 };
+	std::atomic<bool> failed{ false };
+	std::mutex errorMutex;
+	const auto copyFiles = [&] {
+		std::string fileError;
+		for (size_t i = 0; !failed && (i = nextFile++) < files.size();)
+		{
+			if (_cancelled && *_cancelled)
+				fileError = "The copying has been cancelled";
+			else if (copyFile(files[i], fileError))
+			{
+				const qint64 copied = copiedSize += files[i].size;
+				const int percentage = totalSize > 0 ? static_cast<int>(copied * 100 / totalSize) : 100;
+				// Only the thread that moves the percentage on reports it
+				int reported = reportedPercentage;
+				while (_onProgress && percentage > reported && !reportedPercentage.compare_exchange_weak(reported, percentage));
+				if (_onProgress && percentage > reported)
+					_onProgress(static_cast<float>(percentage));
+
+				continue;
+			}
+
+			failed = true;
+			const std::lock_guard lock(errorMutex);
+			if (error.empty())
+				error = fileError;
+		}
+	};
+
+	// The calling thread is one of the workers
+	std::vector<std::thread> threads;
+	const size_t threadCount = std::min(files.size(), static_cast<size_t>(_threadCount));
+	for (size_t i = 1; i < threadCount; ++i)
+		threads.emplace_back(copyFiles);
+
+	copyFiles();
+	for (std::thread& thread : threads)
+		thread.join();
+
+	if (failed)
+	{
+		_errorString = QString::fromStdString(error);
+		return false;
+	}
+
+	// The innermost directories first, in case a parent directory is not writable
+	for (auto it = directories.rbegin(); it != directories.rend(); ++it)
+	{
+		if (::chmod(it->path.c_str(), it->mode) != 0)
+		{
+			_errorString = QString::fromStdString(systemErrorMessage("set the permissions of", it->path));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const QString& CDirectoryCopier::errorString() const
+{
+	return _errorString;
+}
+
+bool CDirectoryCopier::copyFileContents(int sourceFd, int targetFd)
+{
+#if defined __linux__ || defined __FreeBSD__
+	for (;;)
+	{
+		// In the kernel, without copying the data through user space. Some file systems share the blocks instead of copying them (btrfs, XFS).
+		const ssize_t copied = ::copy_file_range(sourceFd, nullptr, targetFd, nullptr, 1024 * 1024 * 1024, 0);
+		if (copied == 0)
+			return true;
+		if (copied > 0 || errno == EINTR)
+			continue;
+		if (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP)
+			return false;
+
+		break; // Not supported between these two files
+	}
+#endif
+
+	// One buffer per thread, a bundle can have thousands of small files
+	thread_local std::vector<char> buffer(256 * 1024);
+	for (;;)
+	{
+		const ssize_t bytesRead = ::read(sourceFd, buffer.data(), buffer.size());
+		if (bytesRead == 0)
+			return true;
+		if (bytesRead < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		for (ssize_t written = 0; written < bytesRead;)
+		{
+			const ssize_t result = ::write(targetFd, buffer.data() + written, static_cast<size_t>(bytesRead - written));
+			if (result < 0 && errno != EINTR)
+				return false;
+			if (result > 0)
+				written += result;
+		}
+	}
+}
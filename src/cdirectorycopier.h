@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <atomic>
+#include <functional>
+
+// Copies a directory tree - directories, regular files and symlinks, with their permissions - into a new directory, e. g. an app bundle.
+// The tree is walked on the calling thread, which also creates the directories and symlinks, and the files are copied by a pool of threads,
+// largest first. A file is cloned where the file system supports it (macOS: copyfile() with COPYFILE_CLONE, which also copies the extended attributes),
+// copied in the kernel where possible (copy_file_range() on Linux / FreeBSD), and through a buffer otherwise. POSIX only.
+class CDirectoryCopier
+{
+public:
+	// 0: one thread per core
+	explicit CDirectoryCopier(int threadCount = 0);
+
+	// Called whenever another whole percent of the data has been copied, from any of the copying threads (possibly from several at once)
+	void setProgressHandler(std::function<void (float percentage)> onProgress);
+	// The copying stops, failing, once *cancelled is set
+	void setCancellationFlag(const std::atomic<bool>* cancelled);
+
+	// targetPath must not exist. On failure, whatever has been copied is left in place for the caller to remove.
+	bool copy(const QString& sourcePath, const QString& targetPath);
+	[[nodiscard]] const QString& errorString() const;
+
+	// Copies from the current position of sourceFd to the current position of targetFd until the end of the source
+	static bool copyFileContents(int sourceFd, int targetFd);
+
+private:
+	int _threadCount;
+	std::function<void (float percentage)> _onProgress;
+	const std::atomic<bool>* _cancelled = nullptr;
+	QString _errorString;
+};
@@ -0,0 +1,92 @@
+#include "cdownloadfilewriter.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#if defined __linux__ || defined __FreeBSD__
+#include <fcntl.h>
+#endif
+
+#include <string.h>
+
+// Reserves the disk space for the whole file at once, so that it's allocated in as few extents as possible and its metadata isn't updated on every write.
+// QFile::resize() alone only sets the size: most file systems leave the file sparse and allocate the blocks as they are written.
+static bool preallocate(QFile& file, qint64 size)
+{
+#if defined __linux__
+	// Not posix_fallocate(): glibc emulates it by writing to every block where the file system doesn't support fallocate
+	(void)::fallocate(file.handle(), 0, 0, static_cast<off_t>(size));
+#elif defined __FreeBSD__
+	(void)::posix_fallocate(file.handle(), 0, static_cast<off_t>(size));
+#endif
+	// Not an error if the preallocation above isn't supported, the file just stays sparse
+	return file.size() == size || file.resize(size);
+}
+
+CDownloadFileWriter::CDownloadFileWriter(QFile& file) :
+	_file(file)
+{
+}
+
+CDownloadFileWriter::~CDownloadFileWriter()
+{
+	if (_mapping)
+		_file.unmap(_mapping);
+}
+
+bool CDownloadFileWriter::start(CAutoUpdaterGithub::DownloadIoStrategy strategy, qint64 fileSize)
+{
+	if (_mapping)
+	{
+		_file.unmap(_mapping);
+		_mapping = nullptr;
+	}
+
+	_fileSize = -1;
+	if (fileSize <= 0 || strategy == CAutoUpdaterGithub::DownloadIoStrategy::Append)
+		return true;
+
+	if (!preallocate(_file, fileSize))
+		return false;
+
+	_fileSize = fileSize;
+	// Falls back to writing through the file if it can't be mapped, e. g. for lack of address space in a 32-bit process
+	if (strategy == CAutoUpdaterGithub::DownloadIoStrategy::MemoryMapped)
+		_mapping = _file.map(0, fileSize);
+
+	return true;
+}
+
+bool CDownloadFileWriter::write(qint64 offset, const char* data, qint64 size)
+{
+	if (_mapping && offset + size <= _fileSize)
+	{
+		::memcpy(_mapping + offset, data, static_cast<size_t>(size));
+		return true;
+	}
+
+	// Consecutive chunks of a single-connection download don't need a seek
+	if (_file.pos() != offset && !_file.seek(offset))
+		return false;
+
+	return _file.write(data, size) == size;
+}
+
+bool CDownloadFileWriter::finish(qint64 dataSize)
+{
+	if (_mapping)
+	{
+		_file.unmap(_mapping);
+		_mapping = nullptr;
+	}
+
+	const bool preallocated = _fileSize >= 0;
+	_fileSize = -1;
+	return !preallocated || _file.size() == dataSize || _file.resize(dataSize);
+}
+
+QString CDownloadFileWriter::fileName() const
+{
+	return _file.fileName();
+}
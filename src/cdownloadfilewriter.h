@@ -0,0 +1,33 @@
+#pragma once
+
+#include "cautoupdatergithub.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+class QFile;
+
+// Writes the downloaded data to the update file at the given offsets, using the selected CAutoUpdaterGithub::DownloadIoStrategy.
+// The file must be open for reading and writing (memory mapping needs both).
+class CDownloadFileWriter
+{
+public:
+	explicit CDownloadFileWriter(QFile& file);
+	~CDownloadFileWriter();
+
+	CDownloadFileWriter& operator=(const CDownloadFileWriter&) = delete;
+
+	// fileSize is the size of the complete file, -1 if it's not known (the data can only be appended then)
+	bool start(CAutoUpdaterGithub::DownloadIoStrategy strategy, qint64 fileSize);
+	bool write(qint64 offset, const char* data, qint64 size);
+	// Unmaps the file and cuts it to the length of the data actually received, in case it has been preallocated for more
+	bool finish(qint64 dataSize);
+
+	[[nodiscard]] QString fileName() const;
+
+private:
+	QFile& _file;
+	uchar* _mapping = nullptr;
+	qint64 _fileSize = -1;
+};
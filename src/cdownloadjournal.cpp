@@ -0,0 +1,67 @@
+#include "cdownloadjournal.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+RESTORE_COMPILER_WARNINGS
+
+static constexpr quint32 journalFileMagic = 0x4748444A; // "GHDJ"
+static constexpr quint16 journalFileFormatVersion = 1;
+
+bool CDownloadJournal::load(const QString& filePath)
+{
+	*this = {};
+
+	QFile file(filePath);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+
+	quint32 magic = 0;
+	quint16 formatVersion = 0;
+	stream >> magic >> formatVersion;
+	if (magic != journalFileMagic || formatVersion != journalFileFormatVersion)
+		return false;
+
+	stream >> url >> etag >> lastModified >> bytesReceived;
+	if (stream.status() != QDataStream::Ok || bytesReceived < 0)
+	{
+		*this = {};
+		return false;
+	}
+
+	return true;
+}
+
+bool CDownloadJournal::store(const QString& filePath) const
+{
+	QSaveFile file(filePath);
+	if (!file.open(QFile::WriteOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+
+	stream << journalFileMagic << journalFileFormatVersion;
+	stream << url << etag << lastModified << bytesReceived;
+
+	if (stream.status() != QDataStream::Ok)
+	{
+		file.cancelWriting();
+		return false;
+	}
+
+	return file.commit();
+}
+
+QByteArray CDownloadJournal::ifRangeValidator() const
+{
+	// Weak ETags are not allowed in If-Range
+	if (!etag.isEmpty() && !etag.startsWith("W/"))
+		return etag;
+
+	return lastModified;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+// Sidecar file of a partially downloaded update: where the data came from, the validators of the downloaded version of the resource,
+// and how many bytes of it are safely in the file. Used to resume an interrupted download with Range / If-Range.
+class CDownloadJournal
+{
+public:
+	bool load(const QString& filePath);
+	bool store(const QString& filePath) const;
+
+	// The value for If-Range: the ETag if it's a strong one, otherwise Last-Modified. Empty if the download can't be resumed safely.
+	[[nodiscard]] QByteArray ifRangeValidator() const;
+
+public:
+	QString url;
+	QByteArray etag;
+	QByteArray lastModified;
+	qint64 bytesReceived = 0;
+};
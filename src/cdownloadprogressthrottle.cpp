@@ -0,0 +1,94 @@
+#include "cdownloadprogressthrottle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// The weight of a rate sample grows with the time it covers, the older samples fade out over about this long
+static constexpr double rateSmoothingTime = 3000.0;
+
+float CDownloadProgressThrottle::Progress::percentage() const
+{
+	if (bytesTotal <= 0)
+		return 0.0f;
+
+	return bytesReceived < bytesTotal ? static_cast<float>(bytesReceived * 100) / static_cast<float>(bytesTotal) : 100.0f;
+}
+
+void CDownloadProgressThrottle::setMinimumInterval(qint64 milliseconds)
+{
+	_minimumInterval = milliseconds;
+}
+
+void CDownloadProgressThrottle::setMinimumDelta(float percentage)
+{
+	_minimumDelta = percentage;
+}
+
+void CDownloadProgressThrottle::setClock(std::function<qint64 ()> clock)
+{
+	_clock = std::move(clock);
+	reset();
+}
+
+void CDownloadProgressThrottle::reset()
+{
+	_lastReported = {};
+	_startTime = -1;
+	_lastReportTime = 0;
+}
+
+qint64 CDownloadProgressThrottle::currentTime()
+{
+	if (_clock)
+		return _clock();
+
+	if (!_timer.isValid())
+		_timer.start();
+
+	return _timer.elapsed();
+}
+
+bool CDownloadProgressThrottle::update(qint64 bytesReceived, qint64 bytesTotal, Progress& progress)
+{
+	// Going back means that the download has started over
+	if (_startTime < 0 || bytesReceived < _lastReported.bytesReceived)
+	{
+		_startTime = currentTime();
+		_lastReported = { bytesReceived, bytesTotal };
+		_lastReportTime = 0;
+		progress = _lastReported;
+		return true;
+	}
+
+	Progress current{ bytesReceived, bytesTotal };
+	const qint64 now = currentTime() - _startTime;
+	const bool finished = bytesTotal > 0 && bytesReceived >= bytesTotal;
+	if (bytesReceived == _lastReported.bytesReceived && bytesTotal == _lastReported.bytesTotal)
+		return false;
+
+	if (!finished)
+	{
+		if (now - _lastReportTime < _minimumInterval)
+			return false;
+		if (bytesTotal > 0 && current.percentage() - _lastReported.percentage() < _minimumDelta)
+			return false;
+	}
+
+	current.bytesPerSecond = _lastReported.bytesPerSecond;
+	if (now > _lastReportTime)
+	{
+		const double elapsed = static_cast<double>(now - _lastReportTime);
+		const double sampleRate = static_cast<double>(bytesReceived - _lastReported.bytesReceived) * 1000.0 / elapsed;
+		const double weight = _lastReported.bytesPerSecond > 0.0 ? 1.0 - std::exp(-elapsed / rateSmoothingTime) : 1.0;
+		current.bytesPerSecond += (sampleRate - current.bytesPerSecond) * weight;
+	}
+
+	if (bytesTotal > 0 && current.bytesPerSecond > 0.0)
+		current.secondsRemaining = static_cast<qint64>(std::ceil(static_cast<double>(std::max(bytesTotal - bytesReceived, qint64{0})) / current.bytesPerSecond));
+
+	_lastReported = current;
+	_lastReportTime = now;
+	progress = current;
+	return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QElapsedTimer>
+RESTORE_COMPILER_WARNINGS
+
+#include <functional>
+
+// Coalesces the download progress notifications, which can arrive thousands of times per second on a fast link, into the updates worth reporting:
+// at most one per minimum interval, and only once the download has moved on by the minimum delta. The first and the final updates always pass.
+// Also estimates the transfer rate and the time remaining.
+class CDownloadProgressThrottle
+{
+public:
+	struct Progress {
+		qint64 bytesReceived = 0;
+		qint64 bytesTotal = -1; // -1 if unknown
+		double bytesPerSecond = 0.0; // Smoothed over the last few seconds, 0 until there are two updates to compare
+		qint64 secondsRemaining = -1; // -1 if unknown
+
+		// 0 if the total is not known
+		[[nodiscard]] float percentage() const;
+	};
+
+	// 0 for both passes every update through
+	void setMinimumInterval(qint64 milliseconds);
+	// In percentage points, ignored if the total size is not known
+	void setMinimumDelta(float percentage);
+	// Milliseconds from any fixed point; a monotonic clock (QElapsedTimer) by default, or if clock is empty. For the tests to control the time.
+	void setClock(std::function<qint64 ()> clock);
+
+	// Starts over for a new transfer
+	void reset();
+	// Returns true if the update is to be reported, and fills progress in then
+	bool update(qint64 bytesReceived, qint64 bytesTotal, Progress& progress);
+
+private:
+	[[nodiscard]] qint64 currentTime();
+
+private:
+	std::function<qint64 ()> _clock;
+	QElapsedTimer _timer;
+	qint64 _minimumInterval = 100;
+	float _minimumDelta = 0.1f;
+
+	Progress _lastReported;
+	qint64 _startTime = -1; // -1 until the first update of the transfer
+	qint64 _lastReportTime = 0; // Since the start
+};
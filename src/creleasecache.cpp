@@ -0,0 +1,87 @@
+#include "creleasecache.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+RESTORE_COMPILER_WARNINGS
+
+static constexpr quint32 cacheFileMagic = 0x47485243; // "GHRC"
+static constexpr quint16 cacheFileFormatVersion = 5;
+
+bool CReleaseCache::load(const QString& filePath)
+{
+	*this = {};
+
+	QFile file(filePath);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+
+	quint32 magic = 0;
+	quint16 formatVersion = 0;
+	stream >> magic >> formatVersion;
+	if (magic != cacheFileMagic || formatVersion != cacheFileFormatVersion)
+		return false;
+
+	quint32 releaseCount = 0;
+	stream >> etag >> lastModified >> truncationKey >> releaseCount;
+	if (stream.status() != QDataStream::Ok)
+		return false;
+
+	releases.reserve(releaseCount);
+	for (quint32 i = 0; i < releaseCount && stream.status() == QDataStream::Ok; ++i)
+	{
+		CAutoUpdaterGithub::VersionEntry release;
+		stream >> release.versionString >> release.versionChanges >> release.date >> release.versionUpdateUrl >> release.isPrerelease >> release.releaseTitle >> release.updateSha256 >> release.updateChecksumsUrl >> release.deltaUpdateUrls >> release.zsyncUrl;
+		releases.push_back(std::move(release));
+	}
+
+	if (stream.status() != QDataStream::Ok)
+	{
+		*this = {};
+		return false;
+	}
+
+	return true;
+}
+
+bool CReleaseCache::store(const QString& filePath) const
+{
+	if (!QDir{}.mkpath(QFileInfo(filePath).absolutePath()))
+		return false;
+
+	QSaveFile file(filePath);
+	if (!file.open(QFile::WriteOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_12);
+
+	stream << cacheFileMagic << cacheFileFormatVersion;
+	stream << etag << lastModified << truncationKey << static_cast<quint32>(releases.size());
+	for (const auto& release : releases)
+		stream << release.versionString << release.versionChanges << release.date << release.versionUpdateUrl << release.isPrerelease << release.releaseTitle << release.updateSha256 << release.updateChecksumsUrl << release.deltaUpdateUrls << release.zsyncUrl;
+
+	if (stream.status() != QDataStream::Ok)
+	{
+		file.cancelWriting();
+		return false;
+	}
+
+	return file.commit();
+}
+
+bool CReleaseCache::hasValidators() const
+{
+	return !etag.isEmpty() || !lastModified.isEmpty();
+}
+
+bool CReleaseCache::isValidFor(const QString& checkTruncationKey) const
+{
+	return truncationKey.isEmpty() || truncationKey == checkTruncationKey;
+}
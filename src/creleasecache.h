@@ -0,0 +1,30 @@
+#pragma once
+
+#include "cautoupdatergithub.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+// On-disk copy of the last /releases response: the releases already extracted from the JSON, plus the HTTP validators
+// (ETag / Last-Modified) needed to make the next update check a conditional request.
+// The releases are stored unfiltered, so that the cache of the complete list stays valid when the current version of the program changes.
+// A list that the check has cut short (the ordered feed mode, or the paginated mode stopping before the last page) only has the releases
+// that check needed: it's tagged with the current version and the settings it was fetched for, and only used by a check with the same ones.
+class CReleaseCache
+{
+public:
+	bool load(const QString& filePath);
+	bool store(const QString& filePath) const;
+
+	[[nodiscard]] bool hasValidators() const;
+	// Whether the releases can stand for the list a check with the given truncation key would get
+	[[nodiscard]] bool isValidFor(const QString& checkTruncationKey) const;
+
+public:
+	QByteArray etag;
+	QByteArray lastModified;
+	QString truncationKey; // Empty if the list is complete
+	CAutoUpdaterGithub::ChangeLog releases;
+};
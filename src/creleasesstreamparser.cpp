@@ -0,0 +1,511 @@
+#include "creleasesstreamparser.h"
+
+#include <assert.h>
+#include <string.h>
+#include <utility>
+
+static constexpr bool isWhitespace(char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static constexpr bool isLiteralCharacter(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+static constexpr int hexDigitValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	else if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	else if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	else
+		return -1;
+}
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool isJsonNumber(const std::string& literal)
+{
+	size_t i = 0;
+	const auto skipDigits = [&literal, &i] {
+		const size_t start = i;
+		while (i < literal.size() && literal[i] >= '0' && literal[i] <= '9')
+			++i;
+		return i > start;
+	};
+
+	if (i < literal.size() && literal[i] == '-')
+		++i;
+
+	if (i < literal.size() && literal[i] == '0')
+		++i;
+	else if (!skipDigits())
+		return false;
+
+	if (i < literal.size() && literal[i] == '.')
+	{
+		++i;
+		if (!skipDigits())
+			return false;
+	}
+
+	if (i < literal.size() && (literal[i] == 'e' || literal[i] == 'E'))
+	{
+		++i;
+		if (i < literal.size() && (literal[i] == '+' || literal[i] == '-'))
+			++i;
+		if (!skipDigits())
+			return false;
+	}
+
+	return i == literal.size();
+}
+
+// Nesting levels: 1 - the releases array, 2 - a release object, 3 - the assets array, 4 - an asset object
+static constexpr size_t releaseDepth = 2;
+static constexpr size_t assetsDepth = 3;
+static constexpr size_t assetDepth = 4;
+
+CReleasesStreamParser::CReleasesStreamParser(ReleaseHandler releaseHandler) :
+	_releaseHandler(std::move(releaseHandler))
+{
+	assert(_releaseHandler);
+}
+
+bool CReleasesStreamParser::feed(const char* data, size_t size)
+{
+	size_t i = 0;
+	while (i < size)
+	{
+		if (_stopped || _state == State::Error)
+			return false;
+
+		const char c = data[i];
+		switch (_state)
+		{
+		case State::String:
+		{
+			// Fast path: copy (or skip) everything up to the next quote or escape sequence (or a control character, which must be escaped)
+			const char* const begin = data + i;
+			const char* end = begin;
+			for (const char* const dataEnd = data + size; end != dataEnd && *end != '"' && *end != '\\' && static_cast<unsigned char>(*end) >= 0x20; ++end);
+
+			if (_stringTarget && end != begin)
+			{
+				if (_highSurrogate != 0)
+					appendCodePoint(0xFFFD);
+				_stringTarget->append(begin, static_cast<size_t>(end - begin));
+			}
+
+			i += static_cast<size_t>(end - begin);
+			if (i == size)
+				break;
+
+			if (data[i] == '"')
+				endString();
+			else if (data[i] == '\\')
+				_state = State::StringEscape;
+			else
+			{
+				_state = State::Error;
+				return false;
+			}
+
+			++i;
+			break;
+		}
+		case State::StringEscape:
+		{
+			char unescaped = 0;
+			switch (c)
+			{
+			case '"':
+			case '\\':
+			case '/':
+				unescaped = c;
+				break;
+			case 'b':
+				unescaped = '\b';
+				break;
+			case 'f':
+				unescaped = '\f';
+				break;
+			case 'n':
+				unescaped = '\n';
+				break;
+			case 'r':
+				unescaped = '\r';
+				break;
+			case 't':
+				unescaped = '\t';
+				break;
+			case 'u':
+				_unicodeEscape = 0;
+				_unicodeEscapeDigits = 0;
+				_state = State::StringUnicodeEscape;
+				++i;
+				continue;
+			default:
+				_state = State::Error;
+				return false;
+			}
+
+			if (_stringTarget)
+			{
+				if (_highSurrogate != 0)
+					appendCodePoint(0xFFFD);
+				_stringTarget->push_back(unescaped);
+			}
+
+			_state = State::String;
+			++i;
+			break;
+		}
+		case State::StringUnicodeEscape:
+		{
+			const int digit = hexDigitValue(c);
+			if (digit < 0)
+			{
+				_state = State::Error;
+				return false;
+			}
+
+			_unicodeEscape = (_unicodeEscape << 4) | static_cast<uint32_t>(digit);
+			if (++_unicodeEscapeDigits == 4)
+			{
+				if (_stringTarget)
+					appendCodePoint(_unicodeEscape);
+				_state = State::String;
+			}
+
+			++i;
+			break;
+		}
+		case State::Literal:
+			if (isLiteralCharacter(c))
+			{
+				_literal.push_back(c);
+				++i;
+			}
+			else
+				endLiteral(); // The current character is processed in the next iteration
+
+			break;
+		default:
+			if (isWhitespace(c))
+			{
+				++i;
+				break;
+			}
+
+			switch (_state)
+			{
+			case State::Value:
+			case State::ValueOrArrayEnd:
+				if (_containers.empty() && c != '[')
+					_state = State::Error; // The releases list must be an array
+				else if (c == '{')
+					startObject();
+				else if (c == '[')
+					startArray();
+				else if (c == '"')
+				{
+					_stringIsKey = false;
+					startString();
+				}
+				else if (c == ']' && _state == State::ValueOrArrayEnd)
+					endContainer(c);
+				else if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')
+				{
+					_literal.clear();
+					_state = State::Literal;
+					continue; // The literal state consumes this character
+				}
+				else
+					_state = State::Error;
+				break;
+			case State::KeyOrObjectEnd:
+			case State::Key:
+				if (c == '"')
+				{
+					_stringIsKey = true;
+					startString();
+				}
+				else if (c == '}' && _state == State::KeyOrObjectEnd)
+					endContainer(c);
+				else
+					_state = State::Error;
+				break;
+			case State::Colon:
+				_state = c == ':' ? State::Value : State::Error;
+				break;
+			case State::CommaOrEnd:
+				if (c == ',')
+					_state = _containers.back() == '{' ? State::Key : State::Value;
+				else if (c == '}' || c == ']')
+					endContainer(c);
+				else
+					_state = State::Error;
+				break;
+			case State::Done:
+			default:
+				_state = State::Error; // Trailing garbage
+				break;
+			}
+
+			++i;
+			break;
+		}
+	}
+
+	return !_stopped && _state != State::Error;
+}
+
+bool CReleasesStreamParser::finished() const
+{
+	return _state == State::Done;
+}
+
+bool CReleasesStreamParser::hasError() const
+{
+	return _state == State::Error;
+}
+
+void CReleasesStreamParser::stop()
+{
+	_stopped = true;
+}
+
+bool CReleasesStreamParser::stopped() const
+{
+	return _stopped;
+}
+
+void CReleasesStreamParser::startObject()
+{
+	_containers.push_back('{');
+	if (_containers.size() == releaseDepth)
+		_release = {};
+	else if (_containers.size() == assetDepth && _inAssets)
+		_release.assets.emplace_back();
+
+	_state = State::KeyOrObjectEnd;
+}
+
+void CReleasesStreamParser::startArray()
+{
+	if (_containers.size() == releaseDepth && _releaseField == Field::Assets)
+		_inAssets = true;
+
+	_containers.push_back('[');
+	_state = State::ValueOrArrayEnd;
+}
+
+void CReleasesStreamParser::endContainer(char closingBracket)
+{
+	const char openingBracket = closingBracket == '}' ? '{' : '[';
+	if (_containers.empty() || _containers.back() != openingBracket)
+	{
+		_state = State::Error;
+		return;
+	}
+
+	_containers.pop_back();
+
+	if (openingBracket == '{' && _containers.size() == releaseDepth - 1)
+	{
+		if (!_stopped)
+			_releaseHandler(std::move(_release));
+		_release = {};
+	}
+	else if (openingBracket == '[' && _containers.size() == releaseDepth)
+		_inAssets = false;
+
+	valueCompleted();
+}
+
+void CReleasesStreamParser::startString()
+{
+	_highSurrogate = 0;
+	_stringTarget = nullptr;
+
+	const size_t depth = _containers.size();
+	if (_stringIsKey)
+	{
+		if (depth == releaseDepth || (depth == assetDepth && _inAssets))
+		{
+			_key.clear();
+			_stringTarget = &_key;
+		}
+	}
+	else if (depth == releaseDepth)
+	{
+		switch (_releaseField)
+		{
+		case Field::TagName:
+			_stringTarget = &_release.tagName;
+			break;
+		case Field::Name:
+			_stringTarget = &_release.name;
+			break;
+		case Field::Body:
+			_stringTarget = &_release.body;
+			break;
+		case Field::CreatedAt:
+			_stringTarget = &_release.createdAt;
+			break;
+		case Field::HtmlUrl:
+			_stringTarget = &_release.htmlUrl;
+			break;
+		default:
+			break;
+		}
+
+		if (_stringTarget)
+			_stringTarget->clear();
+	}
+	else if (depth == assetDepth && _inAssets)
+	{
+		switch (_assetField)
+		{
+		case Field::Name:
+			_stringTarget = &_release.assets.back().name;
+			break;
+		case Field::BrowserDownloadUrl:
+			_stringTarget = &_release.assets.back().browserDownloadUrl;
+			break;
+		case Field::Digest:
+			_stringTarget = &_release.assets.back().digest;
+			break;
+		default:
+			break;
+		}
+
+		if (_stringTarget)
+			_stringTarget->clear();
+	}
+
+	_state = State::String;
+}
+
+void CReleasesStreamParser::endString()
+{
+	if (_stringTarget && _highSurrogate != 0)
+		appendCodePoint(0xFFFD);
+
+	_stringTarget = nullptr;
+
+	if (!_stringIsKey)
+	{
+		valueCompleted();
+		return;
+	}
+
+	const size_t depth = _containers.size();
+	if (depth == releaseDepth)
+		_releaseField = fieldForKey(_key);
+	else if (depth == assetDepth && _inAssets)
+		_assetField = fieldForKey(_key);
+
+	_state = State::Colon;
+}
+
+void CReleasesStreamParser::endLiteral()
+{
+	if (_literal != "true" && _literal != "false" && _literal != "null" && !isJsonNumber(_literal))
+	{
+		_state = State::Error;
+		return;
+	}
+
+	if (_containers.size() == releaseDepth)
+	{
+		if (_releaseField == Field::Draft)
+			_release.draft = _literal == "true";
+		else if (_releaseField == Field::Prerelease)
+			_release.prerelease = _literal == "true";
+	}
+
+	valueCompleted();
+}
+
+void CReleasesStreamParser::valueCompleted()
+{
+	_state = _containers.empty() ? State::Done : State::CommaOrEnd;
+}
+
+void CReleasesStreamParser::appendCodePoint(uint32_t codePoint)
+{
+	assert(_stringTarget);
+
+	if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+	{
+		if (_highSurrogate != 0)
+			appendCodePoint(0xFFFD);
+		_highSurrogate = codePoint;
+		return;
+	}
+	else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+	{
+		if (_highSurrogate == 0)
+			codePoint = 0xFFFD;
+		else
+			codePoint = 0x10000 + ((_highSurrogate - 0xD800) << 10) + (codePoint - 0xDC00);
+	}
+	else if (_highSurrogate != 0 && codePoint != 0xFFFD)
+		appendCodePoint(0xFFFD);
+
+	_highSurrogate = 0;
+
+	std::string& target = *_stringTarget;
+	if (codePoint < 0x80)
+		target.push_back(static_cast<char>(codePoint));
+	else if (codePoint < 0x800)
+	{
+		target.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+		target.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+	else if (codePoint < 0x10000)
+	{
+		target.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+		target.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		target.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+	else
+	{
+		target.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+		target.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+		target.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		target.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+}
+
+CReleasesStreamParser::Field CReleasesStreamParser::fieldForKey(const std::string& key)
+{
+	static constexpr struct {
+		const char* key;
+		Field field;
+	} knownFields[] {
+		{"tag_name", Field::TagName},
+		{"name", Field::Name},
+		{"body", Field::Body},
+		{"created_at", Field::CreatedAt},
+		{"html_url", Field::HtmlUrl},
+		{"assets", Field::Assets},
+		{"draft", Field::Draft},
+		{"prerelease", Field::Prerelease},
+		{"browser_download_url", Field::BrowserDownloadUrl},
+		{"digest", Field::Digest},
+	};
+
+	for (const auto& knownField : knownFields)
+	{
+		if (key == knownField.key)
+			return knownField.field;
+	}
+
+	return Field::Other;
+}
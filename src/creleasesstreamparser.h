@@ -0,0 +1,107 @@
+#pragma once
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Incremental parser for the GitHub /releases JSON array.
+// The data can be fed in chunks of any size as it arrives from the network; every release is reported as soon as its
+// closing brace has been parsed. Only the fields needed by the updater are extracted, all the other values are skipped
+// without being decoded or stored, and no DOM is ever built.
+class CReleasesStreamParser
+{
+public:
+	struct Asset {
+		std::string name;
+		std::string browserDownloadUrl;
+		std::string digest; // e. g. "sha256:<hex>", empty for the assets uploaded before GitHub started publishing digests
+	};
+
+	struct Release {
+		std::string tagName;
+		std::string name;
+		std::string body;
+		std::string createdAt;
+		std::string htmlUrl;
+		std::vector<Asset> assets;
+		bool draft = false;
+		bool prerelease = false;
+	};
+
+	using ReleaseHandler = std::function<void (Release&& release)>;
+
+	explicit CReleasesStreamParser(ReleaseHandler releaseHandler);
+
+	// Returns false if the data is not a valid JSON array (e. g. an error object) or if parsing has been stopped
+	bool feed(const char* data, size_t size);
+	// Returns true if a complete, valid document has been parsed
+	[[nodiscard]] bool finished() const;
+	[[nodiscard]] bool hasError() const;
+
+	// No more data will be processed and no more releases will be reported
+	void stop();
+	[[nodiscard]] bool stopped() const;
+
+private:
+	enum class State {
+		Value,
+		ValueOrArrayEnd,
+		KeyOrObjectEnd,
+		Key,
+		Colon,
+		CommaOrEnd,
+		String,
+		StringEscape,
+		StringUnicodeEscape,
+		Literal,
+		Done,
+		Error
+	};
+
+	enum class Field {
+		Other,
+		TagName,
+		Name,
+		Body,
+		CreatedAt,
+		HtmlUrl,
+		Assets,
+		Draft,
+		Prerelease,
+		BrowserDownloadUrl,
+		Digest
+	};
+
+	void startObject();
+	void startArray();
+	void endContainer(char closingBracket);
+	void startString();
+	void endString();
+	void endLiteral();
+	void valueCompleted();
+	void appendCodePoint(uint32_t codePoint);
+
+	static Field fieldForKey(const std::string& key);
+
+private:
+	const ReleaseHandler _releaseHandler;
+
+	std::vector<char> _containers; // '[' or '{' for each nesting level
+	State _state = State::Value;
+
+	bool _stringIsKey = false;
+	std::string* _stringTarget = nullptr; // nullptr if the string value is being skipped
+	std::string _key;
+	std::string _literal;
+	uint32_t _unicodeEscape = 0;
+	uint32_t _highSurrogate = 0;
+	int _unicodeEscapeDigits = 0;
+
+	Release _release;
+	Field _releaseField = Field::Other;
+	Field _assetField = Field::Other;
+	bool _inAssets = false;
+	bool _stopped = false;
+};
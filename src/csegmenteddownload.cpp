@@ -0,0 +1,189 @@
+#include "csegmenteddownload.h"
+#include "cdownloadfilewriter.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <assert.h>
+#include <utility>
+
+CSegmentedDownload::CSegmentedDownload(QNetworkAccessManager& networkManager, CDownloadFileWriter& fileWriter, ProgressHandler progressHandler, FinishedHandler finishedHandler) :
+	_networkManager(networkManager),
+	_fileWriter(fileWriter),
+	_progressHandler(std::move(progressHandler)),
+	_finishedHandler(std::move(finishedHandler))
+{
+}
+
+void CSegmentedDownload::start(QNetworkRequest request, const QByteArray& ifRangeValidator, qint64 first, qint64 end, int segmentCount, qint64 minSegmentSize, qint64 bufferSize)
+{
+	assert(first < end && segmentCount > 0);
+
+	const qint64 length = end - first;
+	const qint64 count = std::clamp<qint64>(length / std::max<qint64>(minSegmentSize, 1), 1, segmentCount);
+
+	std::vector<std::pair<qint64, qint64>> ranges(static_cast<size_t>(count));
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		ranges[i].first = first + length * static_cast<qint64>(i) / count;
+		ranges[i].second = first + length * static_cast<qint64>(i + 1) / count;
+	}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+	// Every segment needs its own connection, HTTP/2 would multiplex them all over a single one
+	request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
+#endif
+
+	start(std::move(request), ifRangeValidator, ranges, static_cast<int>(count), bufferSize);
+}
+
+void CSegmentedDownload::start(QNetworkRequest request, const QByteArray& ifRangeValidator, const std::vector<std::pair<qint64, qint64>>& ranges, int maxConnections, qint64 bufferSize)
+{
+	assert(_segments.empty());
+	assert(!ranges.empty() && maxConnections > 0 && bufferSize > 0);
+
+	_first = ranges.front().first;
+	_buffer.resize(static_cast<size_t>(bufferSize));
+	_segments.resize(ranges.size());
+	_segmentsRemaining = _segments.size();
+	for (size_t i = 0; i < _segments.size(); ++i)
+	{
+		assert(ranges[i].first < ranges[i].second);
+		_segments[i].position = ranges[i].first;
+		_segments[i].end = ranges[i].second;
+	}
+
+	if (!ifRangeValidator.isEmpty())
+		request.setRawHeader("If-Range", ifRangeValidator);
+
+	_request = std::move(request);
+
+	const size_t connectionCount = std::min(_segments.size(), static_cast<size_t>(maxConnections));
+	while (_nextSegment < connectionCount)
+	{
+		if (!requestSegment(_nextSegment++))
+			return;
+	}
+}
+
+void CSegmentedDownload::abort()
+{
+	for (Segment& segment : _segments)
+	{
+		if (!segment.reply)
+			continue;
+
+		QNetworkReply* reply = std::exchange(segment.reply, nullptr);
+		disconnect(reply, nullptr, this, nullptr);
+		reply->abort();
+		reply->deleteLater();
+	}
+}
+
+qint64 CSegmentedDownload::contiguousEnd() const
+{
+	qint64 end = _first;
+	for (const Segment& segment : _segments)
+	{
+		end = segment.position;
+		if (segment.position != segment.end)
+			break;
+	}
+
+	return end;
+}
+
+qint64 CSegmentedDownload::contentRangeStart(const QNetworkReply& reply)
+{
+	if (reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 206)
+		return -1;
+
+	const QByteArray contentRange = reply.rawHeader("Content-Range");
+	const auto dash = contentRange.indexOf('-');
+	if (!contentRange.startsWith("bytes ") || dash < 0)
+		return -1;
+
+	bool ok = false;
+	const qint64 start = contentRange.mid(6, dash - 6).trimmed().toLongLong(&ok);
+	return ok ? start : -1;
+}
+
+bool CSegmentedDownload::requestSegment(size_t index)
+{
+	Segment& segment = _segments[index];
+	_request.setRawHeader("Range", "bytes=" + QByteArray::number(segment.position) + '-' + QByteArray::number(segment.end - 1));
+
+	segment.reply = _networkManager.get(_request);
+	if (!segment.reply)
+	{
+		fail("Network request rejected.");
+		return false;
+	}
+
+	segment.reply->setReadBufferSize(static_cast<qint64>(_buffer.size()));
+	connect(segment.reply, &QNetworkReply::readyRead, this, [this, index] { segmentDataReceived(_segments[index]); });
+	connect(segment.reply, &QNetworkReply::finished, this, [this, index] { segmentFinished(_segments[index]); });
+	return true;
+}
+
+void CSegmentedDownload::segmentDataReceived(Segment& segment)
+{
+	QNetworkReply* reply = segment.reply;
+	if (!segment.responseChecked)
+	{
+		segment.responseChecked = true;
+		// Anything but the exact range requested is useless, e. g. 200 with the whole file because the resource has changed in the meantime
+		if (contentRangeStart(*reply) != segment.position)
+		{
+			fail("The server did not send the requested part of the update.");
+			return;
+		}
+	}
+
+	for (qint64 bytesRead = 0; (bytesRead = reply->read(_buffer.data(), static_cast<qint64>(_buffer.size()))) > 0;)
+	{
+		const qint64 length = std::min(bytesRead, segment.end - segment.position);
+		if (!_fileWriter.write(segment.position, _buffer.data(), length))
+		{
+			fail("Failed to write the update to " + _fileWriter.fileName());
+			return;
+		}
+
+		segment.position += length;
+		_bytesReceived += length;
+	}
+
+	_progressHandler(_bytesReceived);
+}
+
+void CSegmentedDownload::segmentFinished(Segment& segment)
+{
+	QNetworkReply* reply = std::exchange(segment.reply, nullptr);
+	reply->deleteLater();
+
+	if (reply->error() != QNetworkReply::NoError)
+	{
+		fail(reply->errorString());
+		return;
+	}
+
+	if (segment.position != segment.end)
+	{
+		fail("The connection was closed before the whole update was received.");
+		return;
+	}
+
+	if (--_segmentsRemaining == 0)
+		_finishedHandler({});
+	else if (_nextSegment < _segments.size())
+		requestSegment(_nextSegment++);
+}
+
+void CSegmentedDownload::fail(const QString& errorMessage)
+{
+	abort();
+	_finishedHandler(errorMessage);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+class CDownloadFileWriter;
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// Downloads a byte range of a resource over several connections at once. The range is split into segments that are requested concurrently
+// (Range, plus If-Range so that all the segments are guaranteed to come from the same version of the resource), and every segment is
+// written at its own offset into the file through the writer, which must have been started for the full size of the file.
+// Can also download a list of separate ranges, a few at a time.
+class CSegmentedDownload final : public QObject
+{
+public:
+	using ProgressHandler = std::function<void (qint64 bytesReceived)>;
+	using FinishedHandler = std::function<void (const QString& errorMessage)>; // The message is empty on success
+
+	CSegmentedDownload(QNetworkAccessManager& networkManager, CDownloadFileWriter& fileWriter, ProgressHandler progressHandler, FinishedHandler finishedHandler);
+
+	// Downloads the bytes [first, end) of request.url() in up to segmentCount segments of at least minSegmentSize bytes each
+	void start(QNetworkRequest request, const QByteArray& ifRangeValidator, qint64 first, qint64 end, int segmentCount, qint64 minSegmentSize, qint64 bufferSize);
+	// Downloads the given [first, end) ranges, at most maxConnections of them at a time
+	void start(QNetworkRequest request, const QByteArray& ifRangeValidator, const std::vector<std::pair<qint64, qint64>>& ranges, int maxConnections, qint64 bufferSize);
+	void abort();
+
+	// The end of the part of the (single) range that has been received without gaps, i. e. where a single-connection download could resume
+	[[nodiscard]] qint64 contiguousEnd() const;
+
+	// The first byte of a 206 Partial Content reply (Content-Range: bytes <first>-<last>/<total>), -1 if it's not a valid range reply
+	[[nodiscard]] static qint64 contentRangeStart(const QNetworkReply& reply);
+
+private:
+	struct Segment {
+		qint64 position = 0; // Where the next received byte goes
+		qint64 end = 0;
+		QNetworkReply* reply = nullptr;
+		bool responseChecked = false;
+	};
+
+	bool requestSegment(size_t index);
+	void segmentDataReceived(Segment& segment);
+	void segmentFinished(Segment& segment);
+	void fail(const QString& errorMessage);
+
+private:
+	QNetworkAccessManager& _networkManager;
+	CDownloadFileWriter& _fileWriter;
+	const ProgressHandler _progressHandler;
+	const FinishedHandler _finishedHandler;
+
+	QNetworkRequest _request;
+	std::vector<Segment> _segments;
+	size_t _nextSegment = 0; // The first one that hasn't been requested yet
+	std::vector<char> _buffer;
+	qint64 _first = 0;
+	qint64 _bytesReceived = 0;
+	size_t _segmentsRemaining = 0;
+};
@@ -0,0 +1,111 @@
+#include "cversionkey.h"
+
+#include <algorithm>
+#include <limits>
+
+static uint64_t parseNumber(const QString& str, qsizetype& pos)
+{
+	uint64_t value = 0;
+	for (; pos < str.size() && str[pos].isDigit(); ++pos)
+	{
+		const uint64_t digit = static_cast<uint64_t>(str[pos].digitValue());
+		value = value <= (std::numeric_limits<uint64_t>::max() - digit) / 10 ? value * 10 + digit : std::numeric_limits<uint64_t>::max();
+	}
+
+	return value;
+}
+
+template <typename T>
+static constexpr int threeWayCompare(const T& l, const T& r)
+{
+	return l < r ? -1 : (r < l ? 1 : 0);
+}
+
+CVersionKey::CVersionKey(const QString& versionString)
+{
+	const qsizetype end = [&versionString] {
+		const auto buildMetadataStart = versionString.indexOf('+');
+		return buildMetadataStart >= 0 ? buildMetadataStart : versionString.size();
+	}();
+
+	qsizetype pos = 0;
+	while (pos < end && versionString[pos].isDigit())
+	{
+		_segments.push_back(parseNumber(versionString, pos));
+		if (pos + 1 < end && versionString[pos] == '.' && versionString[pos + 1].isDigit())
+			++pos;
+		else
+			break;
+	}
+
+	if (_segments.empty())
+		return;
+
+	// Whatever follows the numbers is the pre-release tag: "-beta.2", "rc1", "-alpha-3"
+	if (pos < end && (versionString[pos] == '-' || versionString[pos] == '.'))
+		++pos;
+
+	while (pos < end)
+	{
+		const QChar c = versionString[pos];
+		if (c == '.' || c == '-' || c == '_')
+		{
+			++pos;
+			continue;
+		}
+
+		PrereleaseIdentifier identifier;
+		if (c.isDigit())
+			identifier.number = parseNumber(versionString, pos);
+		else
+		{
+			const qsizetype start = pos;
+			while (pos < end && !versionString[pos].isDigit() && versionString[pos] != '.' && versionString[pos] != '-' && versionString[pos] != '_')
+				++pos;
+			identifier.text = versionString.mid(start, pos - start).toLower();
+		}
+
+		_prerelease.push_back(std::move(identifier));
+	}
+}
+
+bool CVersionKey::isValid() const
+{
+	return !_segments.empty();
+}
+
+int CVersionKey::compare(const CVersionKey& other) const
+{
+	const size_t segmentCount = std::max(_segments.size(), other._segments.size());
+	for (size_t i = 0; i < segmentCount; ++i)
+	{
+		const uint64_t l = i < _segments.size() ? _segments[i] : 0;
+		const uint64_t r = i < other._segments.size() ? other._segments[i] : 0;
+		if (l != r)
+			return l < r ? -1 : 1;
+	}
+
+	// A release is newer than any of its pre-releases
+	if (_prerelease.empty() || other._prerelease.empty())
+		return threeWayCompare(_prerelease.empty(), other._prerelease.empty());
+
+	const size_t identifierCount = std::min(_prerelease.size(), other._prerelease.size());
+	for (size_t i = 0; i < identifierCount; ++i)
+	{
+		if (const int result = _prerelease[i].compare(other._prerelease[i]); result != 0)
+			return result;
+	}
+
+	return threeWayCompare(_prerelease.size(), other._prerelease.size());
+}
+
+// Numeric identifiers have lower precedence than alphanumeric ones
+int CVersionKey::PrereleaseIdentifier::compare(const PrereleaseIdentifier& other) const
+{
+	if (text.isEmpty() != other.text.isEmpty())
+		return text.isEmpty() ? -1 : 1;
+	else if (text.isEmpty())
+		return threeWayCompare(number, other.number);
+	else
+		return threeWayCompare(text.compare(other.text), 0);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+#include <stdint.h>
+#include <vector>
+
+// A version string parsed once into a form that can be compared cheaply, e. g. "1.10.2-beta.3" or "2.0rc1".
+// Numeric segments are compared as integers, missing trailing segments count as 0 (1.2 == 1.2.0).
+// Pre-release identifiers follow the semver rules: 1.0.0-alpha < 1.0.0-alpha.1 < 1.0.0-beta < 1.0.0-rc.1 < 1.0.0.
+// Build metadata (after '+') is ignored.
+class CVersionKey
+{
+public:
+	explicit CVersionKey(const QString& versionString);
+
+	// A version string that doesn't start with a number (e. g. "nightly") can't be parsed
+	[[nodiscard]] bool isValid() const;
+
+	[[nodiscard]] int compare(const CVersionKey& other) const;
+	bool operator<(const CVersionKey& other) const { return compare(other) < 0; }
+
+private:
+	struct PrereleaseIdentifier {
+		QString text; // Empty for numeric identifiers
+		uint64_t number = 0;
+
+		[[nodiscard]] int compare(const PrereleaseIdentifier& other) const;
+	};
+
+	std::vector<uint64_t> _segments;
+	std::vector<PrereleaseIdentifier> _prerelease;
+};
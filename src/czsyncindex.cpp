@@ -0,0 +1,232 @@
+#include "czsyncindex.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCryptographicHash>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <string.h>
+#include <unordered_map>
+
+// The rolling checksum of zsync (rsync's, with 16-bit halves): a is the sum of the bytes, b the sum of the bytes weighted by their distance from the end
+struct RollingSum {
+	uint16_t a = 0;
+	uint16_t b = 0;
+
+	[[nodiscard]] uint32_t value() const { return static_cast<uint32_t>(a) << 16 | b; }
+};
+
+// The block at position, padded with zeroes past the end of the data like the last block of the file is when its checksums are computed
+static const uchar* paddedBlock(const uchar* data, qint64 size, qint64 position, qint64 blockSize, std::vector<uchar>& padded)
+{
+	if (position + blockSize <= size)
+		return data + position;
+
+	padded.assign(static_cast<size_t>(blockSize), 0);
+	if (position < size)
+		::memcpy(padded.data(), data + position, static_cast<size_t>(size - position));
+
+	return padded.data();
+}
+
+static RollingSum rollingSum(const uchar* block, qint64 blockSize)
+{
+	RollingSum sum;
+	for (qint64 i = 0; i < blockSize; ++i)
+	{
+		sum.a = static_cast<uint16_t>(sum.a + block[i]);
+		sum.b = static_cast<uint16_t>(sum.b + (blockSize - i) * block[i]);
+	}
+
+	return sum;
+}
+
+static QByteArray md4(const uchar* block, qint64 blockSize)
+{
+	QCryptographicHash hash(QCryptographicHash::Md4);
+	hash.addData(reinterpret_cast<const char*>(block), blockSize);
+	return hash.result();
+}
+
+bool CZsyncIndex::parse(const QByteArray& controlFile)
+{
+	*this = {};
+
+	const auto headerEnd = controlFile.indexOf("\n\n");
+	if (headerEnd < 0)
+		return false;
+
+	int rsumBytes = 0;
+	for (const QByteArray& line : controlFile.left(headerEnd).split('\n'))
+	{
+		const auto colon = line.indexOf(':');
+		if (colon < 0)
+			continue;
+
+		const QByteArray key = line.left(colon).trimmed(), value = line.mid(colon + 1).trimmed();
+		if (key == "Blocksize")
+			_blockSize = value.toLongLong();
+		else if (key == "Length")
+			_fileLength = value.toLongLong();
+		else if (key == "SHA-1")
+			_sha1 = value.toLower();
+		else if (key == "Hash-Lengths")
+		{
+			const auto lengths = value.split(',');
+			if (lengths.size() != 3)
+				return false;
+
+			_sequentialMatches = lengths[0].toInt();
+			rsumBytes = lengths[1].toInt();
+			_checksumBytes = lengths[2].toInt();
+		}
+		else if (key == "Z-Map2" || key == "Recompress")
+			return false; // The file is to be reassembled from a .gz, not supported
+	}
+
+	// The block size is a power of two, the rolling checksum relies on it
+	if (_blockSize < 16 || (_blockSize & (_blockSize - 1)) != 0 || _fileLength < 0 || _sha1.size() != 40
+		|| _sequentialMatches < 1 || _sequentialMatches > 2 || rsumBytes < 1 || rsumBytes > 4 || _checksumBytes < 3 || _checksumBytes > 16)
+	{
+		*this = {};
+		return false;
+	}
+
+	while ((qint64{1} << _blockShift) < _blockSize)
+		++_blockShift;
+
+	// Only the trailing bytes of the rsum are stored (b is the more useful half)
+	const uint32_t aMask = rsumBytes < 3 ? 0 : (rsumBytes == 3 ? 0xFF : 0xFFFF);
+	const uint32_t bMask = rsumBytes == 1 ? 0xFF : 0xFFFF;
+	_rsumMask = aMask << 16 | bMask;
+
+	const auto blockCount = static_cast<size_t>((_fileLength + _blockSize - 1) / _blockSize);
+	const auto blockDataSize = static_cast<size_t>(rsumBytes + _checksumBytes);
+	const char* blockData = controlFile.constData() + headerEnd + 2;
+	if (static_cast<size_t>(controlFile.size() - headerEnd - 2) < blockCount * blockDataSize)
+	{
+		*this = {};
+		return false;
+	}
+
+	_blocks.resize(blockCount);
+	for (Block& block : _blocks)
+	{
+		uchar rsum[4] = {};
+		::memcpy(rsum + 4 - rsumBytes, blockData, static_cast<size_t>(rsumBytes));
+		block.rsum = (static_cast<uint32_t>(rsum[0]) << 24 | static_cast<uint32_t>(rsum[1]) << 16 | static_cast<uint32_t>(rsum[2]) << 8 | rsum[3]) & _rsumMask;
+		::memcpy(block.checksum.data(), blockData + rsumBytes, static_cast<size_t>(_checksumBytes));
+		blockData += blockDataSize;
+	}
+
+	return true;
+}
+
+qint64 CZsyncIndex::fileLength() const
+{
+	return _fileLength;
+}
+
+qint64 CZsyncIndex::blockSize() const
+{
+	return _blockSize;
+}
+
+size_t CZsyncIndex::blockCount() const
+{
+	return _blocks.size();
+}
+
+const QByteArray& CZsyncIndex::sha1() const
+{
+	return _sha1;
+}
+
+std::vector<qint64> CZsyncIndex::findBlocks(const uchar* localData, qint64 localSize) const
+{
+	std::vector<qint64> offsets(_blocks.size(), -1);
+	if (_blocks.empty() || localSize < _blockSize)
+		return offsets;
+
+	// The blocks that haven't been found yet by rsum. A found block is removed, so that a run of identical blocks (e. g. zeroes)
+	// doesn't have to be checked again at every offset.
+	std::unordered_map<uint32_t, std::vector<uint32_t>> blocksByRsum;
+	blocksByRsum.reserve(_blocks.size());
+	for (size_t i = 0; i < _blocks.size(); ++i)
+		blocksByRsum[_blocks[i].rsum].push_back(static_cast<uint32_t>(i));
+
+	// Most of the offsets match no block at all, a bitmap of the rsum hashes rules them out without a hash table lookup
+	int filterBits = 10;
+	while (filterBits < 28 && (size_t{1} << filterBits) < _blocks.size() * 16)
+		++filterBits;
+
+	const auto filterIndex = [filterBits](uint32_t rsum) { return (rsum * 0x9E3779B1u) >> (32 - filterBits); };
+	std::vector<uint64_t> filter((size_t{1} << filterBits) / 64, 0);
+	for (const Block& block : _blocks)
+		filter[filterIndex(block.rsum) / 64] |= uint64_t{1} << (filterIndex(block.rsum) % 64);
+
+	RollingSum sum = rollingSum(localData, _blockSize);
+	for (qint64 position = 0; position + _blockSize <= localSize;)
+	{
+		const uint32_t rsum = sum.value() & _rsumMask;
+		bool matched = false;
+		if ((filter[filterIndex(rsum) / 64] >> (filterIndex(rsum) % 64)) & 1)
+		{
+			const auto candidates = blocksByRsum.find(rsum);
+			if (candidates != blocksByRsum.end() && !candidates->second.empty())
+			{
+				const QByteArray checksum = md4(localData + position, _blockSize);
+				auto& blockIndices = candidates->second;
+				for (size_t i = 0; i < blockIndices.size();)
+				{
+					const size_t blockIndex = blockIndices[i];
+					// With short checksums, the next block has to match as well
+					const bool isLastBlock = blockIndex + 1 == _blocks.size();
+					if (!checksumMatches(blockIndex, checksum) || (_sequentialMatches > 1 && !isLastBlock && !blockMatches(blockIndex + 1, localData, localSize, position + _blockSize)))
+					{
+						++i;
+						continue;
+					}
+
+					offsets[blockIndex] = position;
+					if (_sequentialMatches > 1 && !isLastBlock && offsets[blockIndex + 1] < 0)
+						offsets[blockIndex + 1] = position + _blockSize;
+
+					blockIndices[i] = blockIndices.back();
+					blockIndices.pop_back();
+					matched = true;
+				}
+			}
+		}
+
+		// Carry on after the matched block, like zsync does
+		if (matched && position + 2 * _blockSize <= localSize)
+		{
+			position += _blockSize;
+			sum = rollingSum(localData + position, _blockSize);
+			continue;
+		}
+
+		if (matched || position + _blockSize == localSize)
+			break;
+
+		const uchar outgoing = localData[position], incoming = localData[position + _blockSize];
+		sum.a = static_cast<uint16_t>(sum.a + incoming - outgoing);
+		sum.b = static_cast<uint16_t>(sum.b + sum.a - (static_cast<uint32_t>(outgoing) << _blockShift));
+		++position;
+	}
+
+	return offsets;
+}
+
+bool CZsyncIndex::checksumMatches(size_t blockIndex, const QByteArray& checksum) const
+{
+	return ::memcmp(_blocks[blockIndex].checksum.data(), checksum.constData(), static_cast<size_t>(_checksumBytes)) == 0;
+}
+
+bool CZsyncIndex::blockMatches(size_t blockIndex, const uchar* localData, qint64 localSize, qint64 position) const
+{
+	std::vector<uchar> padded;
+	const uchar* block = paddedBlock(localData, localSize, position, _blockSize, padded);
+	return (rollingSum(block, _blockSize).value() & _rsumMask) == _blocks[blockIndex].rsum && checksumMatches(blockIndex, md4(block, _blockSize));
+}
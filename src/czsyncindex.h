@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+RESTORE_COMPILER_WARNINGS
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// The block checksums of a file in the zsync format: the <file>.zsync control file that zsyncmake / appimagetool publish next to an AppImage.
+// Only the plain (not gzip-recompressed) form is supported. The header is text ("Key: value" lines up to an empty line), followed by
+// a rolling checksum and an MD4 prefix for every block of the file, truncated to the sizes given by Hash-Lengths.
+class CZsyncIndex
+{
+public:
+	bool parse(const QByteArray& controlFile);
+
+	[[nodiscard]] qint64 fileLength() const;
+	[[nodiscard]] qint64 blockSize() const;
+	[[nodiscard]] size_t blockCount() const;
+	// Hex, of the whole file
+	[[nodiscard]] const QByteArray& sha1() const;
+
+	// For every block of the file described by the index, its offset in localData, or -1 if it's not there.
+	// localData is scanned at every byte offset, so the blocks are found even if they have moved.
+	[[nodiscard]] std::vector<qint64> findBlocks(const uchar* localData, qint64 localSize) const;
+
+private:
+	struct Block {
+		uint32_t rsum = 0; // a << 16 | b, masked
+		std::array<uchar, 16> checksum{};
+	};
+
+	[[nodiscard]] bool checksumMatches(size_t blockIndex, const QByteArray& checksum) const;
+	[[nodiscard]] bool blockMatches(size_t blockIndex, const uchar* localData, qint64 localSize, qint64 position) const;
+
+private:
+	qint64 _fileLength = 0;
+	qint64 _blockSize = 0;
+	int _blockShift = 0;
+	int _sequentialMatches = 1; // How many consecutive blocks must match, to make up for the short checksums
+	int _checksumBytes = 16;
+	uint32_t _rsumMask = 0xFFFFFFFF;
+	QByteArray _sha1;
+	std::vector<Block> _blocks;
+};
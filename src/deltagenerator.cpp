@@ -0,0 +1,186 @@
+#include "deltagenerator.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCryptographicHash>
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include <unordered_map>
+
+static constexpr char deltaMagic[8] = {'G', 'H', 'R', 'D', 'I', 'F', 'F', '1'};
+// The shortest exact match that is looked for, and the step of the old file index
+static constexpr qint64 matchLength = 32;
+// A match is extended until its score (the agreeing bytes minus the disagreeing ones) has dropped this far below the best one
+static constexpr qint64 extensionCutoff = 64;
+// The records are compressed in blocks of this size, which the patcher decompresses one at a time
+static constexpr qint64 uncompressedBlockSize = 1024 * 1024;
+
+static constexpr uint64_t hashBase = 0x100000001B3;
+
+static void appendBigEndian(QByteArray& data, uint64_t value, size_t size)
+{
+	for (size_t i = size; i-- > 0;)
+		data.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+static uint64_t windowHash(const uchar* data)
+{
+	uint64_t hash = 0;
+	for (qint64 i = 0; i < matchLength; ++i)
+		hash = hash * hashBase + data[i];
+
+	return hash;
+}
+
+namespace {
+
+struct Match {
+	qint64 oldPosition = 0;
+	qint64 newPosition = 0;
+	qint64 length = 0;
+};
+
+// Turns the matches, in the order of the new file, into records: the diff of the previous match, the new data up to this one,
+// and the seek from the end of the previous match to the start of this one
+class RecordWriter
+{
+public:
+	RecordWriter(const uchar* oldData, const uchar* newData) : _oldData(oldData), _newData(newData) {}
+
+	void add(const Match& match)
+	{
+		const qint64 previousEnd = _previous.newPosition + _previous.length;
+		appendBigEndian(_records, static_cast<uint64_t>(_previous.length), 8);
+		appendBigEndian(_records, static_cast<uint64_t>(match.newPosition - previousEnd), 8);
+		appendBigEndian(_records, static_cast<uint64_t>(match.oldPosition - (_previous.oldPosition + _previous.length)), 8);
+
+		for (qint64 i = 0; i < _previous.length; ++i)
+			_records.append(static_cast<char>(_newData[_previous.newPosition + i] - _oldData[_previous.oldPosition + i]));
+		_records.append(reinterpret_cast<const char*>(_newData + previousEnd), match.newPosition - previousEnd);
+
+		_previous = match;
+	}
+
+	// The last record carries the rest of the new file
+	void finish(qint64 newSize)
+	{
+		add({ _previous.oldPosition + _previous.length, newSize, 0 });
+	}
+
+	// The records, in compressed blocks
+	[[nodiscard]] QByteArray blocks() const
+	{
+		QByteArray blocks;
+		for (qint64 offset = 0; offset < _records.size(); offset += uncompressedBlockSize)
+		{
+			const QByteArray block = qCompress(_records.mid(offset, uncompressedBlockSize), 9);
+			appendBigEndian(blocks, static_cast<uint64_t>(block.size()), 4);
+			blocks += block;
+		}
+
+		return blocks;
+	}
+
+private:
+	const uchar* const _oldData;
+	const uchar* const _newData;
+	Match _previous;
+	QByteArray _records;
+};
+
+} // namespace
+
+// How far the match starting at oldPosition / newPosition is worth extending: where agreeing bytes outnumber the disagreeing ones by the most
+static qint64 extendedLength(const uchar* oldData, qint64 oldSize, const uchar* newData, qint64 newSize, qint64 oldPosition, qint64 newPosition)
+{
+	qint64 score = 0, bestScore = 0, bestLength = 0;
+	for (qint64 i = 0; oldPosition + i < oldSize && newPosition + i < newSize && score > bestScore - extensionCutoff; ++i)
+	{
+		score += oldData[oldPosition + i] == newData[newPosition + i] ? 1 : -1;
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestLength = i + 1;
+		}
+	}
+
+	return bestLength;
+}
+
+QByteArray DeltaGenerator::generate(const QByteArray& oldData, const QByteArray& newData)
+{
+	const auto* oldBytes = reinterpret_cast<const uchar*>(oldData.constData());
+	const auto* newBytes = reinterpret_cast<const uchar*>(newData.constData());
+	const qint64 oldSize = oldData.size(), newSize = newData.size();
+
+	// Where every aligned window of the old file is, the first one for identical windows
+	std::unordered_map<uint64_t, qint64> oldWindows;
+	oldWindows.reserve(static_cast<size_t>(oldSize / matchLength));
+	for (qint64 position = 0; position + matchLength <= oldSize; position += matchLength)
+		oldWindows.emplace(windowHash(oldBytes + position), position);
+
+	// The hash of new[position, position + matchLength) is rolled along the new file
+	uint64_t highestPower = 1;
+	for (qint64 i = 1; i < matchLength; ++i)
+		highestPower *= hashBase;
+
+	RecordWriter writer(oldBytes, newBytes);
+	qint64 unmatchedStart = 0; // The end of the last match
+	uint64_t hash = newSize >= matchLength ? windowHash(newBytes) : 0;
+	for (qint64 position = 0; position + matchLength <= newSize;)
+	{
+		const auto window = oldWindows.find(hash);
+		if (window != oldWindows.end() && ::memcmp(oldBytes + window->second, newBytes + position, matchLength) == 0)
+		{
+			// Back over the unmatched data, then forward as far as it pays off
+			Match match{ window->second, position, 0 };
+			while (match.newPosition > unmatchedStart && match.oldPosition > 0 && oldBytes[match.oldPosition - 1] == newBytes[match.newPosition - 1])
+			{
+				--match.oldPosition;
+				--match.newPosition;
+			}
+
+			match.length = extendedLength(oldBytes, oldSize, newBytes, newSize, match.oldPosition, match.newPosition);
+			writer.add(match);
+
+			unmatchedStart = match.newPosition + match.length;
+			position = unmatchedStart;
+			if (position + matchLength <= newSize)
+				hash = windowHash(newBytes + position);
+
+			continue;
+		}
+
+		if (position + matchLength < newSize)
+			hash = (hash - newBytes[position] * highestPower) * hashBase + newBytes[position + matchLength];
+		++position;
+	}
+
+	writer.finish(newSize);
+
+	QByteArray delta(deltaMagic, sizeof(deltaMagic));
+	appendBigEndian(delta, static_cast<uint64_t>(oldSize), 8);
+	appendBigEndian(delta, static_cast<uint64_t>(newSize), 8);
+	delta += QCryptographicHash::hash(oldData, QCryptographicHash::Sha256);
+	delta += QCryptographicHash::hash(newData, QCryptographicHash::Sha256);
+	delta += writer.blocks();
+	return delta;
+}
+
+bool DeltaGenerator::generate(const QString& oldFilePath, const QString& newFilePath, const QString& deltaFilePath)
+{
+	QFile oldFile(oldFilePath), newFile(newFilePath), deltaFile(deltaFilePath);
+	if (!oldFile.open(QFile::ReadOnly) || !newFile.open(QFile::ReadOnly))
+		return false;
+
+	// The whole delta is in memory anyway, the files might as well be
+	const QByteArray oldData = oldFile.readAll(), newData = newFile.readAll();
+	if (oldData.size() != oldFile.size() || newData.size() != newFile.size())
+		return false;
+
+	const QByteArray delta = generate(oldData, newData);
+	return deltaFile.open(QFile::WriteOnly | QFile::Truncate) && deltaFile.write(delta) == delta.size();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QByteArray>
+#include <QString>
+RESTORE_COMPILER_WARNINGS
+
+// Makes the "GHRDIFF1" deltas that CDeltaPatcher applies (see cdeltapatcher.h for the format), to be published as
+// <update asset>.from-<previous version>.delta. Not needed by the updater itself, deltagen/ builds a command-line tool around it.
+// The matches are found bsdiff-style: exact runs of at least 32 bytes, located through a hash of the old file every 32 bytes and
+// extended as long as more bytes agree than not, so that a patched region costs the few bytes that differ, which compress to almost nothing.
+namespace DeltaGenerator {
+
+// The delta that turns oldData into newData
+[[nodiscard]] QByteArray generate(const QByteArray& oldData, const QByteArray& newData);
+// The same for files. Returns false if either file can't be read or the delta can't be written.
+bool generate(const QString& oldFilePath, const QString& newFilePath, const QString& deltaFilePath);
+
+} // namespace DeltaGenerator
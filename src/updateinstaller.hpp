@@ -1,9 +1,28 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+
 class QString;
 
 namespace UpdateInstaller {
 
-bool install(const QString& downloadedUpdateFilePath);
+// In this order. The stages that don't apply on the platform are skipped.
+enum class Stage {
+	Verify, // Hashing the downloaded file, if it couldn't be hashed while it was being downloaded (done by CAutoUpdaterGithub before install())
+	Mount,  // macOS: attaching the DMG
+	Copy,   // Putting the new version together next to the installed one
+	Swap    // Replacing the installed version
+};
+
+// percentage is -1 if the progress of the stage is not known
+using ProgressHandler = std::function<void (Stage stage, float percentage)>;
+
+// Linux / FreeBSD: the running AppImage is replaced with the downloaded one, and started again if relaunch is set (the application is expected to quit then).
+// Windows: the downloaded installer is launched. macOS: the application bundle is replaced with the one from the downloaded DMG.
+// Blocks until the installation is over, meant to be called on a worker thread (CAutoUpdaterGithub does that).
+// onProgress is called on the same thread, except for the Copy stage on macOS, where it's called by the copying threads (see CDirectoryCopier).
+// Setting cancelled stops the installation before the Swap stage, leaving the installed version as it was; install() returns false then.
+bool install(const QString& downloadedUpdateFilePath, bool relaunch = false, const ProgressHandler& onProgress = {}, const std::atomic<bool>* cancelled = nullptr);
 
 } // namespace UpdateInstaller
@@ -1,6 +0,0 @@
-#include "updateinstaller.hpp"
-
-bool UpdateInstaller::install(const QString& downloadedUpdateFilePath)
-{
-	return false;
-}
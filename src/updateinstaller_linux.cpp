@@ -1,6 +1,121 @@
 #include "updateinstaller.hpp"
+#include "cdirectorycopier.h"
 
-bool UpdateInstaller::install(const QString& downloadedUpdateFilePath)
+// Also used on FreeBSD
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define report_error(message) {qInfo() << message; return false;}
+
+// Puts the update next to the target, where it can be renamed over it: hard-linked if it's on the same file system, copied otherwise.
+// The downloaded file stays where it is until the swap, so that a cancelled or failed installation doesn't have to download it again.
+// The staged file gets the permissions (and the owner, if allowed) of the target and is flushed to disk.
+static bool stageUpdate(const QByteArray& updatePath, const QByteArray& stagingPath, const struct stat& targetStat)
+{
+	if (::link(updatePath.constData(), stagingPath.constData()) != 0)
+	{
+		// Another file system, or one without hard links
+		const int sourceFd = ::open(updatePath.constData(), O_RDONLY | O_CLOEXEC);
+		if (sourceFd < 0)
+			return false;
+
+		const int targetFd = ::open(stagingPath.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0700);
+		const bool copied = targetFd >= 0 && CDirectoryCopier::copyFileContents(sourceFd, targetFd);
+		::close(sourceFd);
+		if (targetFd >= 0)
+			::close(targetFd);
+
+		if (!copied)
+			return false;
+	}
+
+	const int fd = ::open(stagingPath.constData(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	(void)::fchown(fd, targetStat.st_uid, targetStat.st_gid); // Only possible as root, not an error otherwise
+	const bool synced = ::fchmod(fd, targetStat.st_mode & 07777) == 0 && ::fsync(fd) == 0;
+	::close(fd);
+	return synced;
+}
+
+bool UpdateInstaller::install(const QString& downloadedUpdateFilePath, bool relaunch, const ProgressHandler& onProgress, const std::atomic<bool>* cancelled)
 {
-	return false;
+	// The AppImage runtime sets $APPIMAGE to the image that is running, the executable itself is inside the mounted image
+	QString targetPath = qEnvironmentVariable("APPIMAGE");
+	if (targetPath.isEmpty() && QCoreApplication::applicationFilePath().endsWith(".AppImage"))
+		targetPath = QCoreApplication::applicationFilePath();
+	if (targetPath.isEmpty())
+		report_error("Cannot install update: the application is not running from an AppImage.");
+
+	// Replace the actual file, not a symlink to it
+	targetPath = QFileInfo(targetPath).canonicalFilePath();
+	const QByteArray target = QFile::encodeName(targetPath);
+	const QByteArray update = QFile::encodeName(downloadedUpdateFilePath);
+	const QByteArray staging = QFile::encodeName(QFileInfo(targetPath).absolutePath() + "/." + QFileInfo(targetPath).fileName() + ".update");
+	const QByteArray rollback = target + ".old";
+
+	struct stat targetStat;
+	if (targetPath.isEmpty() || ::stat(target.constData(), &targetStat) != 0)
+		report_error("Cannot install update: failed to access" << targetPath);
+
+	if (onProgress)
+		onProgress(Stage::Copy, -1.0f);
+
+	::unlink(staging.constData()); // Left over from an interrupted update
+	if (!stageUpdate(update, staging, targetStat))
+	{
+		const int error = errno;
+		::unlink(staging.constData());
+		report_error("Cannot install update: failed to write" << QFile::decodeName(staging) << '-' << ::strerror(error));
+	}
+
+	if (cancelled && *cancelled)
+	{
+		::unlink(staging.constData());
+		report_error("The installation has been cancelled.");
+	}
+
+	if (onProgress)
+		onProgress(Stage::Swap, -1.0f);
+
+	// The previous version is kept as a hard link, which takes no time or space and leaves no moment without the target in place
+	::unlink(rollback.constData());
+	if (::link(target.constData(), rollback.constData()) != 0)
+		qInfo() << "Failed to keep the previous version as" << QFile::decodeName(rollback) << '-' << ::strerror(errno);
+
+	// The swap itself: a single rename() is atomic, the target is always either the complete old or the complete new version.
+	// The running process is unaffected, it keeps using the old file.
+	if (::rename(staging.constData(), target.constData()) != 0)
+	{
+		const int error = errno;
+		::unlink(staging.constData());
+		report_error("Cannot install update: failed to replace" << targetPath << '-' << ::strerror(error));
+	}
+
+	// The staged copy is installed, the download is no longer needed
+	::unlink(update.constData());
+
+	// Make the rename durable
+	const int directoryFd = ::open(QFile::encodeName(QFileInfo(targetPath).absolutePath()).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (directoryFd >= 0)
+	{
+		(void)::fsync(directoryFd);
+		::close(directoryFd);
+	}
+
+	if (relaunch && !QProcess::startDetached(targetPath, QCoreApplication::arguments().mid(1)))
+		report_error("The update has been installed, but failed to start" << targetPath);
+
+	return true;
 }
@@ -1,15 +1,21 @@
 #include "updateinstaller.hpp"
+#include "cdirectorycopier.h"
 
 #include <QApplication>
 #include <QDebug>
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QProcess>
+#include <QScopeGuard>
 
-#include <cstdlib>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
 
 #define report_error(message) {qInfo() << message; return false;}
 
-bool UpdateInstaller::install(const QString& downloadedUpdateFilePath)
+bool UpdateInstaller::install(const QString& downloadedUpdateFilePath, bool /*relaunch*/, const ProgressHandler& onProgress, const std::atomic<bool>* cancelled)
 {
 	if (!downloadedUpdateFilePath.endsWith(".dmg", Qt::CaseInsensitive))
 		report_error("Cannot install update:" << downloadedUpdateFilePath << "is not a DMG.");
@@ -18,8 +24,16 @@ bool UpdateInstaller::install(const QString& downloadedUpdateFilePath)
 	if (applicationBinaryName.isEmpty())
 		report_error("Failed to determine the application binary name.");
 
+	// <bundle>.app/Contents/MacOS/<binary>
+	const QString installedBundlePath = QDir::cleanPath(QApplication::applicationDirPath() + "/../..");
+	if (!installedBundlePath.endsWith(".app", Qt::CaseInsensitive))
+		report_error("Cannot install update: the application is not running from a bundle.");
+
+	if (onProgress)
+		onProgress(Stage::Mount, -1.0f);
+
 	QProcess hdiutil;
-	hdiutil.start("hdiutil", {"attach", downloadedUpdateFilePath});
+	hdiutil.start("hdiutil", {"attach", "-nobrowse", "-noautoopen", downloadedUpdateFilePath});
 	if (!hdiutil.waitForFinished(60000))
 		report_error("hdiutil either didn't run or is taking too long.");
 
@@ -29,11 +43,59 @@ bool UpdateInstaller::install(const QString& downloadedUpdateFilePath)
 		report_error("hdiutil didn't succeed mounting the DMG" << downloadedUpdateFilePath);
 
 	const QString volumePath = output.mid(mountedVolumePathIndex, -1).trimmed();
+	const auto detach = qScopeGuard([&volumePath] {
+		QProcess::execute("hdiutil", {"detach", "-quiet", volumePath});
+	});
+
 	const QString bundlePath = volumePath + '/' + applicationBinaryName + ".app";
 	if (!QFileInfo::exists(bundlePath))
 		report_error("No bundle found at" << bundlePath);
 
-	std::system(("cp -R " + bundlePath + " " + QString(QApplication::applicationDirPath() + "/../../").replace(" ", "\\ ")).toUtf8().constData());
+	// The new bundle is put together next to the installed one, so that the two can be swapped in one step.
+	// The installed bundle is not touched until then, an interrupted update leaves it intact.
+	const QString stagingPath = QFileInfo(installedBundlePath).absolutePath() + "/." + QFileInfo(installedBundlePath).fileName() + ".update";
+	QDir(stagingPath).removeRecursively(); // Left over from an interrupted update
+
+	if (onProgress)
+		onProgress(Stage::Copy, 0.0f);
+
+	CDirectoryCopier copier;
+	copier.setCancellationFlag(cancelled);
+	if (onProgress)
+		copier.setProgressHandler([&onProgress](float percentage) { onProgress(Stage::Copy, percentage); });
+
+	if (!copier.copy(bundlePath, stagingPath))
+	{
+		QDir(stagingPath).removeRecursively();
+		report_error("Cannot install update:" << copier.errorString());
+	}
+
+	if (!QFileInfo(stagingPath + "/Contents/MacOS/" + applicationBinaryName).isExecutable())
+	{
+		QDir(stagingPath).removeRecursively();
+		report_error("Cannot install update: the bundle" << bundlePath << "has no executable" << applicationBinaryName);
+	}
+
+	if (cancelled && *cancelled)
+	{
+		QDir(stagingPath).removeRecursively();
+		report_error("The installation has been cancelled.");
+	}
+
+	if (onProgress)
+		onProgress(Stage::Swap, -1.0f);
+
+	// Atomic: the bundle is always either the complete old or the complete new version. The running process keeps using the old files.
+	if (::renamex_np(QFile::encodeName(stagingPath).constData(), QFile::encodeName(installedBundlePath).constData(), RENAME_SWAP) != 0)
+	{
+		const int error = errno;
+		QDir(stagingPath).removeRecursively();
+		report_error("Cannot install update: failed to replace" << installedBundlePath << '-' << ::strerror(error));
+	}
+
+	// The previous version is where the new one was staged
+	if (!QDir(stagingPath).removeRecursively())
+		qInfo() << "Failed to remove the previous version at" << stagingPath;
 
 	return true;
 }
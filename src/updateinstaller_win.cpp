@@ -2,7 +2,10 @@
 
 #include <QProcess>
 
-bool UpdateInstaller::install(const QString& downloadedUpdateFilePath)
+bool UpdateInstaller::install(const QString& downloadedUpdateFilePath, bool /*relaunch*/, const ProgressHandler& /*onProgress*/, const std::atomic<bool>* cancelled)
 {
+	if (cancelled && *cancelled)
+		return false;
+
 	return QProcess::startDetached('\"' + downloadedUpdateFilePath + '\"', {});
 }
@@ -38,9 +38,15 @@ CUpdaterDialog::~CUpdaterDialog()
 	delete ui;
 }
 
+void CUpdaterDialog::reject()
+{
+	_updater.cancelInstallation();
+	QDialog::reject();
+}
+
 void CUpdaterDialog::applyUpdate()
 {
-#ifdef _WIN32
+#if defined _WIN32 || defined __APPLE__ || defined __linux__ || defined __FreeBSD__
 	if (_latestUpdateUrl.endsWith(UPDATE_FILE_EXTENSION))
 	{
 		ui->progressBar->setMaximum(100);
@@ -93,7 +99,7 @@ void CUpdaterDialog::onUpdateAvailable(const CAutoUpdaterGithub::ChangeLog& chan
 		for (const auto& changelogItem : changelog)
 		{
 			html.append(
-				versionTitleHtml(changelogItem) % " (" % changelogItem.date % ")" % annotateEmptyDescription(changelogItem.versionChanges) % "<br>"
+				versionTitleHtml(changelogItem) % " (" % changelogItem.date % ")" % annotateEmptyDescription(changelogItem.versionChangesHtml()) % "<br>"
 			);
 		}
 
@@ -117,7 +123,52 @@ void CUpdaterDialog::onUpdateDownloadProgress(float percentageDownloaded)
 	ui->lblPercentage->setText(QString::number(percentageDownloaded, 'f', 2) + " %");
 }
 
+void CUpdaterDialog::onUpdateDownloadProgressDetails(const CAutoUpdaterGithub::DownloadProgress& progress)
+{
+	QString text = "Downloading the update";
+	if (progress.bytesTotal > 0)
+		text += ": " % locale().formattedDataSize(progress.bytesReceived) % " / " % locale().formattedDataSize(progress.bytesTotal);
+	if (progress.bytesPerSecond > 0.0)
+		text += ", " % locale().formattedDataSize(static_cast<qint64>(progress.bytesPerSecond)) % "/s";
+	if (progress.secondsRemaining >= 0)
+		text += ", " % QString::number(progress.secondsRemaining / 60) % ':' % QString::number(progress.secondsRemaining % 60).rightJustified(2, '0') % " left";
+
+	ui->lblOperationInProgress->setText(text);
+}
+
 void CUpdaterDialog::onUpdateDownloadFinished()
+{
+	ui->lblOperationInProgress->setText("Installing the update...");
+	ui->progressBar->setMaximum(0);
+	ui->lblPercentage->setVisible(false);
+}
+
+void CUpdaterDialog::onUpdateInstallationProgress(UpdateInstaller::Stage stage, float percentage)
+{
+	switch (stage)
+	{
+	case UpdateInstaller::Stage::Verify:
+		ui->lblOperationInProgress->setText("Verifying the update...");
+		break;
+	case UpdateInstaller::Stage::Mount:
+		ui->lblOperationInProgress->setText("Opening the disk image...");
+		break;
+	case UpdateInstaller::Stage::Copy:
+		ui->lblOperationInProgress->setText("Copying the new version...");
+		break;
+	case UpdateInstaller::Stage::Swap:
+		ui->lblOperationInProgress->setText("Replacing the installed version...");
+		break;
+	}
+
+	// A busy indicator if the progress is not known
+	ui->progressBar->setMaximum(percentage >= 0.0f ? 100 : 0);
+	ui->progressBar->setValue(percentage >= 0.0f ? (int)percentage : 0);
+	ui->lblPercentage->setVisible(percentage >= 0.0f);
+	ui->lblPercentage->setText(QString::number((int)percentage) + " %");
+}
+
+void CUpdaterDialog::onUpdateInstalled()
 {
 	accept();
 }
@@ -21,6 +21,9 @@ public:
 							bool silentCheck = false);
 	~CUpdaterDialog() override;
 
+	// Also cancels the installation of the update, if it's not too late
+	void reject() override;
+
 private:
 	void applyUpdate();
 
@@ -29,8 +32,11 @@ private:
 	void onUpdateAvailable(const CAutoUpdaterGithub::ChangeLog& changelog) override;
 	// percentageDownloaded >= 100.0f means the download has finished
 	void onUpdateDownloadProgress(float percentageDownloaded) override;
+	void onUpdateDownloadProgressDetails(const CAutoUpdaterGithub::DownloadProgress& progress) override;
 	void onUpdateDownloadFinished() override;
 	void onUpdateError(const QString& errorMessage) override;
+	void onUpdateInstallationProgress(UpdateInstaller::Stage stage, float percentage) override;
+	void onUpdateInstalled() override;
 
 private:
 	Ui::CUpdaterDialog *ui;
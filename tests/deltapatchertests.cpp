@@ -0,0 +1,165 @@
+#include "cdeltapatcher.h"
+#include "deltagenerator.hpp"
+#include "testing.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <random>
+
+static QByteArray randomBytes(qint64 size, std::mt19937::result_type seed)
+{
+	std::mt19937 random{ seed };
+	QByteArray data(size, '\0');
+	for (qint64 i = 0; i < size; ++i)
+		data[i] = static_cast<char>(random() & 0xFF);
+
+	return data;
+}
+
+static QByteArray sha256Hex(const QByteArray& data)
+{
+	return QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+}
+
+// The installed version the patches are applied to
+static QString oldFilePath()
+{
+	return QDir::tempPath() + '/' + QCoreApplication::applicationName() + "-delta-old.bin";
+}
+
+struct PatchResult {
+	bool fed = false; // Every feed() has succeeded
+	bool finished = false;
+	QByteArray output;
+	QByteArray newFileSha256;
+	QString errorString;
+};
+
+// Writes the old file, then feeds the delta to a patcher in chunks of chunkSize bytes
+static PatchResult applyDelta(const QByteArray& oldData, const QByteArray& delta, qint64 chunkSize, const QByteArray& oldFileSha256 = {})
+{
+	PatchResult result;
+	QFile oldFile(oldFilePath());
+	if (!oldFile.open(QFile::WriteOnly | QFile::Truncate) || oldFile.write(oldData) != oldData.size())
+		return result;
+	oldFile.close();
+
+	CDeltaPatcher patcher(oldFilePath(), oldFileSha256.isEmpty() ? sha256Hex(oldData) : oldFileSha256, [&result](const char* data, qint64 size) {
+		result.output.append(data, size);
+		return true;
+	});
+
+	result.fed = true;
+	for (qint64 offset = 0; offset < delta.size() && result.fed; offset += chunkSize)
+		result.fed = patcher.feed(delta.constData() + offset, std::min(chunkSize, delta.size() - offset));
+
+	result.finished = patcher.finished();
+	result.newFileSha256 = patcher.newFileSha256();
+	result.errorString = patcher.errorString();
+	QFile::remove(oldFilePath());
+	return result;
+}
+
+// The pairs of versions a delta is made for: scattered edits, an insertion, moved data, unrelated data, empty files,
+// and a file large enough for several compressed blocks. Every delta is fed in one piece and in chunks that split the headers.
+TEST(deltaRoundTrip)
+{
+	const QByteArray base = randomBytes(1024 * 1024, 1);
+
+	QByteArray edited = base;
+	for (qint64 i = 0; i < 50; ++i)
+		edited[(i * 20011) % edited.size()] = static_cast<char>(edited[(i * 20011) % edited.size()] ^ 0x5A);
+
+	const QByteArray large = randomBytes(3 * 1024 * 1024, 2);
+	QByteArray largeEdited = large;
+	largeEdited[123] = static_cast<char>(largeEdited[123] ^ 1);
+
+	const std::pair<QByteArray, QByteArray> versions[] = {
+		{ base, base },
+		{ base, edited },
+		{ base, base.left(300'000) + randomBytes(5000, 3) + base.mid(300'000) },
+		{ base, base.mid(100'000) + base.left(100'000) },
+		{ base, randomBytes(70'000, 4) },
+		{ QByteArray{}, base.left(1000) },
+		{ base.left(1000), QByteArray{} },
+		{ large, largeEdited }
+	};
+
+	for (const auto& [oldData, newData] : versions)
+	{
+		const QByteArray delta = DeltaGenerator::generate(oldData, newData);
+		for (const qint64 chunkSize : { delta.size(), qint64{4096}, qint64{7} })
+		{
+			const PatchResult result = applyDelta(oldData, delta, chunkSize);
+			CHECK(result.fed);
+			CHECK(result.finished);
+			CHECK(result.output == newData);
+			CHECK(result.newFileSha256 == sha256Hex(newData));
+		}
+	}
+
+	// Only what differs is in the delta
+	CHECK(DeltaGenerator::generate(base, edited).size() < 16 * 1024);
+}
+
+// Truncated, damaged in a compressed block, or not a delta at all
+TEST(deltaRejectsCorruptPatch)
+{
+	const QByteArray oldData = randomBytes(256 * 1024, 5);
+	QByteArray newData = oldData;
+	newData[1000] = static_cast<char>(newData[1000] ^ 0xFF);
+	const QByteArray delta = DeltaGenerator::generate(oldData, newData);
+
+	const PatchResult truncated = applyDelta(oldData, delta.left(delta.size() - 10), 4096);
+	CHECK(!truncated.finished);
+
+	// Past the header (8 + 2 * 8 + 2 * 32 bytes) and the length of the first block
+	QByteArray damaged = delta;
+	for (qint64 i = 100; i < damaged.size(); i += 3)
+		damaged[i] = static_cast<char>(damaged[i] ^ 0x55);
+	const PatchResult damagedResult = applyDelta(oldData, damaged, 4096);
+	CHECK(!damagedResult.fed && !damagedResult.finished);
+	CHECK(!damagedResult.errorString.isEmpty());
+
+	QByteArray notDelta = delta;
+	notDelta[0] = 'X';
+	const PatchResult notDeltaResult = applyDelta(oldData, notDelta, 4096);
+	CHECK(!notDeltaResult.fed && notDeltaResult.output.isEmpty());
+	CHECK(notDeltaResult.errorString == "Not a delta update.");
+}
+
+// A delta made from another version, or from the same size of file with other contents: nothing is output
+TEST(deltaRejectsWrongBase)
+{
+	const QByteArray oldData = randomBytes(256 * 1024, 6), otherData = randomBytes(256 * 1024, 7);
+	const QByteArray delta = DeltaGenerator::generate(oldData, oldData.left(200'000) + randomBytes(1000, 8));
+
+	const PatchResult otherBase = applyDelta(otherData, delta, 4096);
+	CHECK(!otherBase.fed && otherBase.output.isEmpty());
+	CHECK(otherBase.errorString == "The delta doesn't apply to the installed version.");
+
+	// The hash is the caller's: the right one for a file of another size
+	const PatchResult otherSize = applyDelta(oldData.left(1000), delta, 4096, sha256Hex(oldData));
+	CHECK(!otherSize.fed && otherSize.output.isEmpty());
+	CHECK(otherSize.errorString == "The delta doesn't apply to the installed version.");
+}
+
+// The patcher hands out the hash from the header, checking the output against it is up to the caller: a delta that carries
+// the wrong one still applies, and the mismatch shows
+TEST(deltaCarriesResultHash)
+{
+	const QByteArray oldData = randomBytes(64 * 1024, 9);
+	const QByteArray newData = oldData.left(32 * 1024) + randomBytes(100, 10);
+	QByteArray delta = DeltaGenerator::generate(oldData, newData);
+	delta[8 + 2 * 8 + 32] = static_cast<char>(delta[8 + 2 * 8 + 32] ^ 1); // The first byte of the new file's SHA-256
+
+	const PatchResult result = applyDelta(oldData, delta, 4096);
+	CHECK(result.finished && result.output == newData);
+	CHECK(result.newFileSha256 != sha256Hex(result.output));
+}
@@ -0,0 +1,253 @@
+#include "cdirectorycopier.h"
+#include "testing.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#include <string>
+#include <utility>
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string nativePath(const QString& path)
+{
+	return QFile::encodeName(path).toStdString();
+}
+
+static bool writeFile(const QString& path, qint64 size, mode_t mode)
+{
+	QFile file(path);
+	if (!file.open(QFile::WriteOnly))
+		return false;
+
+	QByteArray data(static_cast<qsizetype>(size), '\0');
+	for (qsizetype i = 0; i < data.size(); ++i)
+		data[i] = static_cast<char>((i * 7919 + size) & 0xFF);
+
+	return file.write(data) == size && file.flush() && ::chmod(nativePath(path).c_str(), mode) == 0;
+}
+
+// An app bundle, with everything the copier has to get right: nested and empty directories, empty files, a file larger than the copy buffer,
+// executables, read-only files and directories, relative, absolute and dangling symlinks, and enough small files to keep every thread busy
+static bool createTree(const QString& root)
+{
+	const QDir dir(root);
+	for (const char* path : { "Contents/MacOS", "Contents/Frameworks/Lib.framework/Versions/A", "Contents/Resources/empty", "Contents/ReadOnly" })
+	{
+		if (!dir.mkpath(path))
+			return false;
+	}
+
+	bool ok = writeFile(root + "/Contents/MacOS/App", 100'000, 0755)
+		&& writeFile(root + "/Contents/Frameworks/Lib.framework/Versions/A/Lib", 1024 * 1024 + 17, 0750) // The buffer is 256 KiB
+		&& writeFile(root + "/Contents/Info.plist", 0, 0644)
+		&& writeFile(root + "/Contents/Resources/read-only", 4096, 0444)
+		&& writeFile(root + "/Contents/ReadOnly/file", 10, 0600);
+
+	for (int i = 0; ok && i < 300; ++i)
+	{
+		const QString subdirectory = root + "/Contents/Resources/" + QString::number(i % 10);
+		ok = dir.mkpath(subdirectory) && writeFile(subdirectory + "/resource" + QString::number(i), i * 97, 0644);
+	}
+
+	const std::string nativeRoot = nativePath(root);
+	return ok
+		&& ::symlink("A", (nativeRoot + "/Contents/Frameworks/Lib.framework/Versions/Current").c_str()) == 0
+		&& ::symlink("Versions/Current/Lib", (nativeRoot + "/Contents/Frameworks/Lib.framework/Lib").c_str()) == 0
+		&& ::symlink("/tmp", (nativeRoot + "/Contents/Resources/absolute").c_str()) == 0
+		&& ::symlink("does/not/exist", (nativeRoot + "/Contents/Resources/dangling").c_str()) == 0
+		&& ::chmod((nativeRoot + "/Contents/ReadOnly").c_str(), 0555) == 0
+		&& ::chmod((nativeRoot + "/Contents/Resources/empty").c_str(), 0700) == 0;
+}
+
+static QByteArray fileContents(const std::string& path)
+{
+	QFile file(QFile::decodeName(path.c_str()));
+	return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray{};
+}
+
+static std::string linkTarget(const std::string& path)
+{
+	char target[4096];
+	const ssize_t length = ::readlink(path.c_str(), target, sizeof(target));
+	return length >= 0 ? std::string(target, static_cast<size_t>(length)) : std::string{};
+}
+
+// The same entries of the same types, modes, contents and link targets; counts the entries of the source
+static bool sameTree(const std::string& source, const std::string& target, int& entries)
+{
+	struct stat sourceStat, targetStat;
+	if (::lstat(source.c_str(), &sourceStat) != 0 || ::lstat(target.c_str(), &targetStat) != 0)
+	{
+		fprintf(stderr, "%s is missing from the copy\n", target.c_str());
+		return false;
+	}
+
+	++entries;
+	if ((sourceStat.st_mode & S_IFMT) != (targetStat.st_mode & S_IFMT))
+	{
+		fprintf(stderr, "%s is not of the type of %s\n", target.c_str(), source.c_str());
+		return false;
+	}
+
+	if (S_ISLNK(sourceStat.st_mode))
+		return linkTarget(source) == linkTarget(target) && !linkTarget(source).empty();
+
+	if ((sourceStat.st_mode & 07777) != (targetStat.st_mode & 07777))
+	{
+		fprintf(stderr, "%s has the permissions %o instead of %o\n", target.c_str(), targetStat.st_mode & 07777, sourceStat.st_mode & 07777);
+		return false;
+	}
+
+	if (S_ISREG(sourceStat.st_mode))
+		return sourceStat.st_size == targetStat.st_size && fileContents(source) == fileContents(target);
+
+	// Nothing in the copy that isn't in the source
+	int sourceEntries = 0, targetEntries = 0;
+	for (const auto& [path, count] : { std::pair{ &source, &sourceEntries }, std::pair{ &target, &targetEntries } })
+	{
+		DIR* directory = ::opendir(path->c_str());
+		if (!directory)
+			return false;
+
+		while (const dirent* entry = ::readdir(directory))
+			*count += ::strcmp(entry->d_name, ".") != 0 && ::strcmp(entry->d_name, "..") != 0;
+
+		::closedir(directory);
+	}
+
+	if (sourceEntries != targetEntries)
+		return false;
+
+	DIR* directory = ::opendir(source.c_str());
+	if (!directory)
+		return false;
+
+	bool same = true;
+	while (const dirent* entry = same ? ::readdir(directory) : nullptr)
+	{
+		if (::strcmp(entry->d_name, ".") != 0 && ::strcmp(entry->d_name, "..") != 0)
+			same = sameTree(source + '/' + entry->d_name, target + '/' + entry->d_name, entries);
+	}
+
+	::closedir(directory);
+	return same;
+}
+
+// So that QTemporaryDir can remove the trees
+static void makeWritable(const std::string& path)
+{
+	struct stat pathStat;
+	if (::lstat(path.c_str(), &pathStat) != 0 || !S_ISDIR(pathStat.st_mode))
+		return;
+
+	(void)::chmod(path.c_str(), 0700);
+	DIR* directory = ::opendir(path.c_str());
+	if (!directory)
+		return;
+
+	while (const dirent* entry = ::readdir(directory))
+	{
+		if (::strcmp(entry->d_name, ".") != 0 && ::strcmp(entry->d_name, "..") != 0)
+			makeWritable(path + '/' + entry->d_name);
+	}
+
+	::closedir(directory);
+}
+
+TEST(directoryCopierCopiesTree)
+{
+	QTemporaryDir temporaryDir;
+	CHECK(temporaryDir.isValid());
+	const QString source = temporaryDir.path() + "/App.app";
+	CHECK(createTree(source));
+
+	// One thread, and more threads than cores
+	for (const int threadCount : { 1, 8 })
+	{
+		const QString target = temporaryDir.path() + "/Copy" + QString::number(threadCount) + ".app";
+		CDirectoryCopier copier(threadCount);
+		std::atomic<int> lastPercentage{ 0 };
+		copier.setProgressHandler([&lastPercentage](float percentage) {
+			lastPercentage = std::max(lastPercentage.load(), static_cast<int>(percentage));
+		});
+
+		CHECK(copier.copy(source, target));
+		CHECK(copier.errorString().isEmpty());
+		CHECK(lastPercentage == 100);
+
+		int entries = 0;
+		CHECK(sameTree(nativePath(source), nativePath(target), entries));
+		CHECK(entries == 329); // 20 directories, 305 files and 4 symlinks
+		makeWritable(nativePath(target));
+	}
+
+	makeWritable(nativePath(source));
+}
+
+TEST(directoryCopierReportsErrors)
+{
+	QTemporaryDir temporaryDir;
+	CHECK(temporaryDir.isValid());
+	const QString source = temporaryDir.path() + "/App.app";
+	CHECK(createTree(source));
+
+	for (const int threadCount : { 1, 8 })
+	{
+		CDirectoryCopier copier(threadCount);
+
+		// No source, and a target that exists already
+		CHECK(!copier.copy(temporaryDir.path() + "/Missing.app", temporaryDir.path() + "/Copy.app"));
+		CHECK(copier.errorString().contains("Missing.app"));
+		CHECK(!copier.copy(source, source));
+		CHECK(!copier.errorString().isEmpty());
+
+		// Cancelled
+		const std::atomic<bool> cancelled{ true };
+		copier.setCancellationFlag(&cancelled);
+		const QString cancelledTarget = temporaryDir.path() + "/Cancelled" + QString::number(threadCount) + ".app";
+		CHECK(!copier.copy(source, cancelledTarget));
+		CHECK(!copier.errorString().isEmpty());
+		copier.setCancellationFlag(nullptr);
+		makeWritable(nativePath(cancelledTarget));
+	}
+
+	// Permissions don't stop root
+	if (::geteuid() == 0)
+	{
+		makeWritable(nativePath(source));
+		return;
+	}
+
+	// An unreadable file, and an unreadable directory
+	const std::string unreadableFile = nativePath(source) + "/Contents/MacOS/App", unreadableDirectory = nativePath(source) + "/Contents/Resources/5";
+	for (const std::string& unreadable : { unreadableFile, unreadableDirectory })
+	{
+		struct stat unreadableStat;
+		CHECK(::stat(unreadable.c_str(), &unreadableStat) == 0);
+		CHECK(::chmod(unreadable.c_str(), 0) == 0);
+
+		for (const int threadCount : { 1, 8 })
+		{
+			CDirectoryCopier copier(threadCount);
+			const QString target = temporaryDir.path() + "/Unreadable" + QString::number(threadCount) + ".app";
+			CHECK(!copier.copy(source, target));
+			CHECK(copier.errorString().contains(QFile::decodeName(unreadable.c_str())));
+			makeWritable(nativePath(target));
+			QDir(target).removeRecursively();
+		}
+
+		CHECK(::chmod(unreadable.c_str(), unreadableStat.st_mode & 07777) == 0);
+	}
+
+	makeWritable(nativePath(source));
+}
@@ -0,0 +1,925 @@
+#include "cautoupdatergithub.h"
+#include "cdownloadjournal.h"
+#include "cmockgithubserver.h"
+#include "deltagenerator.hpp"
+#include "releasefixtures.hpp"
+#include "testing.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <stdint.h>
+#include <stdio.h>
+#include <utility>
+#include <vector>
+
+static constexpr int downloadTimeoutMs = 30'000;
+
+static const QString assetName = "App-test" + QString(UPDATE_FILE_EXTENSION);
+
+// Where the updater puts the download
+static QString updateFilePath()
+{
+	return QDir::tempPath() + '/' + QCoreApplication::applicationName() + UPDATE_FILE_EXTENSION;
+}
+
+static void removeUpdateFile()
+{
+	QFile::remove(updateFilePath());
+	QFile::remove(updateFilePath() + ".journal");
+}
+
+static QByteArray randomData(qint64 size, std::mt19937::result_type seed)
+{
+	std::mt19937 random{ seed };
+	QByteArray data(size, '\0');
+	for (qint64 i = 0; i < size; ++i)
+		data[i] = static_cast<char>(random() & 0xFF);
+
+	return data;
+}
+
+static QByteArray sha256(const QByteArray& data)
+{
+	return QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+}
+
+static QByteArray updateFileSha256()
+{
+	QFile file(updateFilePath());
+	return file.open(QFile::ReadOnly) ? sha256(file.readAll()) : QByteArray{};
+}
+
+// Verification is required and nothing is published for the asset, so every attempt ends with an error: the download's own one, or,
+// once the file is complete, that it can't be verified. Nothing is ever installed, the file is left for the test to check.
+class DownloadAttempt final : public CAutoUpdaterGithub::UpdateStatusListener
+{
+public:
+	// The base file is the installed version for the delta and zsync updates, which are only tried for the releases from a check
+	explicit DownloadAttempt(CMockGithubServer& server, const QString& baseFilePath = {})
+	{
+		_updater.setUpdateStatusListener(this);
+		_updater.setApiBaseUrl(server.baseUrl());
+		_updater.setReleaseCacheFilePath({});
+		_updater.setDeltaUpdateBaseFile(baseFilePath);
+		_updater.setUpdateVerificationRequired(true);
+	}
+
+	// To set the download options before download()
+	CAutoUpdaterGithub& updater()
+	{
+		return _updater;
+	}
+
+	// Returns the number of updates found, -1 if the check has failed
+	int checkForUpdates()
+	{
+		_updatesFound = -1;
+		wait([this] { _updater.checkForUpdates(); });
+		return _updatesFound;
+	}
+
+	// Returns the error the attempt has ended with
+	QString download(const QString& url)
+	{
+		wait([this, &url] { _updater.downloadAndInstallUpdate(url); });
+		return _lastError;
+	}
+
+	void onUpdateAvailable(const CAutoUpdaterGithub::ChangeLog& changelog) override
+	{
+		_updatesFound = static_cast<int>(changelog.size());
+		_loop.quit();
+	}
+
+	void onUpdateDownloadProgress(float) override {}
+	void onUpdateDownloadFinished() override {}
+
+	void onUpdateError(const QString& errorMessage) override
+	{
+		_lastError = errorMessage;
+		_loop.quit();
+	}
+
+	void onUpdateInstallationProgress(UpdateInstaller::Stage stage, float) override
+	{
+		if (stage == UpdateInstaller::Stage::Verify)
+			_fileHashedAgain = true;
+	}
+
+	// Whether the complete file has been read again for the hash check, instead of having been hashed as it was written
+	[[nodiscard]] bool fileHashedAgain() const
+	{
+		return _fileHashedAgain;
+	}
+
+private:
+	void wait(const std::function<void ()>& start)
+	{
+		QTimer timeout;
+		timeout.setSingleShot(true);
+		QObject::connect(&timeout, &QTimer::timeout, &_loop, [this] { onUpdateError("Timed out"); });
+		timeout.start(downloadTimeoutMs);
+		start();
+		_loop.exec();
+	}
+
+private:
+	CAutoUpdaterGithub _updater{ ReleaseFixtures::repositoryName, QString::fromLatin1(ReleaseFixtures::oldestVersion) };
+	QEventLoop _loop;
+	QString _lastError;
+	int _updatesFound = -1;
+	bool _fileHashedAgain = false;
+};
+
+static bool downloadComplete(const QString& error)
+{
+	return error.startsWith("The update can't be verified");
+}
+
+// The digest of the asset, as GitHub publishes it
+static std::string sha256Digest(const QByteArray& data)
+{
+	return "sha256:" + sha256(data).toStdString();
+}
+
+#if defined __linux__ || defined __FreeBSD__
+// A download that passes the verification goes on to be installed, which can only be let happen where it's certain to fail:
+// on Linux / FreeBSD, outside of an AppImage. The tests that publish the right hash only run there.
+#define VERIFIED_DOWNLOAD_TESTS
+
+static bool outsideAppImage()
+{
+	qunsetenv("APPIMAGE");
+	return !QCoreApplication::applicationFilePath().endsWith(".AppImage");
+}
+
+// The download has been verified, and the installation has failed as it should
+static bool installationAttempted(const QString& error)
+{
+	return error == "Failed to install the downloaded update.";
+}
+#endif
+
+// Every asset download is cut off after a third of the asset: the rest of the file is requested from where the partial file ends,
+// conditionally on the ETag, and the result is the asset
+TEST(downloadResumesAfterConnectionDrop)
+{
+	const QByteArray asset = randomData(1024 * 1024, 12);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+	server.setConnectionDropAfter(asset.size() / 3);
+	removeUpdateFile();
+
+	QString error;
+	for (int attempt = 0; attempt < 10 && !downloadComplete(error); ++attempt)
+		error = DownloadAttempt(server).download(server.assetUrl(assetName));
+
+	CHECK(downloadComplete(error));
+	CHECK(updateFileSha256() == sha256(asset));
+	CHECK(!QFileInfo::exists(updateFilePath() + ".journal"));
+
+	const auto& log = server.requestLog();
+	CHECK(log.size() >= 3);
+	CHECK(!log.empty() && log.front().status == 200 && log.front().range.isEmpty());
+	qint64 previousEnd = 0; // The most the client can have received so far
+	for (size_t i = 1; i < log.size(); ++i)
+	{
+		const auto& request = log[i];
+		const qint64 start = request.range.startsWith("bytes=") ? request.range.mid(6, request.range.indexOf('-') - 6).toLongLong() : -1;
+		previousEnd += log[i - 1].bodyBytes;
+
+		CHECK(request.status == 206);
+		CHECK(request.range.endsWith("-"));
+		CHECK(start > 0 && start <= previousEnd);
+		CHECK(request.ifRange == server.assetEtag(assetName));
+		previousEnd = start;
+	}
+
+	removeUpdateFile();
+}
+
+#ifdef VERIFIED_DOWNLOAD_TESTS
+// The same with a published digest: before the rest of the file is requested, the partial file is hashed (on the worker), and the
+// hash carried on from there through the resumed parts matches without the complete file being read again
+TEST(downloadResumeCarriesHashOver)
+{
+	if (!CHECK(outsideAppImage()))
+		return;
+
+	const QByteArray asset = randomData(1024 * 1024, 13);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+	server.setReleasesJson(ReleaseFixtures::releaseJson("9.9.9", { { assetName.toStdString(), server.assetUrl(assetName).toStdString(), sha256Digest(asset) } }));
+	server.setConnectionDropAfter(asset.size() / 3);
+	removeUpdateFile();
+
+	QString error;
+	bool fileHashedAgain = false;
+	for (int attempt = 0; attempt < 10 && !installationAttempted(error); ++attempt)
+	{
+		DownloadAttempt downloadAttempt(server);
+		CHECK(downloadAttempt.checkForUpdates() == 1);
+		error = downloadAttempt.download(server.assetUrl(assetName));
+		fileHashedAgain = downloadAttempt.fileHashedAgain();
+	}
+
+	CHECK(installationAttempted(error));
+	CHECK(!fileHashedAgain);
+	CHECK(updateFileSha256() == sha256(asset));
+
+	int resumedRequests = 0;
+	for (const auto& request : server.requestLog())
+	{
+		if (request.path.endsWith(assetName) && request.status == 206)
+			++resumedRequests;
+	}
+	CHECK(resumedRequests >= 2);
+
+	removeUpdateFile();
+}
+#endif
+
+// Where the release publishes the SHA-256 of the update
+enum class HashSource { Digest, ChecksumFile, Sha256Sums };
+static constexpr HashSource hashSources[] { HashSource::Digest, HashSource::ChecksumFile, HashSource::Sha256Sums };
+
+// A release of the asset that publishes sha256Hex for it: as the asset digest, in a <asset>.sha256 file with only the digest in it,
+// or on its line of a SHA256SUMS file that lists other files as well
+static QByteArray releaseWithHash(CMockGithubServer& server, HashSource source, const QByteArray& sha256Hex)
+{
+	std::vector<ReleaseFixtures::Asset> assets{ { assetName.toStdString(), server.assetUrl(assetName).toStdString(), {} } };
+	switch (source)
+	{
+	case HashSource::Digest:
+		assets.front().digest = "sha256:" + sha256Hex.toStdString();
+		break;
+	case HashSource::ChecksumFile:
+		server.addAsset(assetName + ".sha256", sha256Hex + '\n');
+		assets.push_back({ (assetName + ".sha256").toStdString(), server.assetUrl(assetName + ".sha256").toStdString(), {} });
+		break;
+	case HashSource::Sha256Sums:
+		server.addAsset("SHA256SUMS", sha256("another file") + "  App-other.zip\n" + sha256Hex + " *" + assetName.toUtf8() + '\n');
+		assets.push_back({ "SHA256SUMS", server.assetUrl("SHA256SUMS").toStdString(), {} });
+		break;
+	}
+
+	return ReleaseFixtures::releaseJson("9.9.9", assets);
+}
+
+// The published SHA-256 is that of another file: whichever the source, the download is reported as corrupted and deleted, journal and all,
+// so that the next attempt doesn't resume from it. The check comes before the installation, so this runs everywhere.
+TEST(downloadWithWrongHashDeleted)
+{
+	const QByteArray asset = randomData(1024 * 1024, 41);
+	for (const auto source : hashSources)
+	{
+		CMockGithubServer server(ReleaseFixtures::repositoryName);
+		CHECK(server.start());
+		server.addAsset(assetName, asset);
+		server.setReleasesJson(releaseWithHash(server, source, sha256(randomData(1024 * 1024, 42))));
+		removeUpdateFile();
+
+		DownloadAttempt attempt(server);
+		CHECK(attempt.checkForUpdates() == 1);
+		CHECK(attempt.download(server.assetUrl(assetName)) == "The downloaded update is corrupted: its SHA-256 doesn't match the one published with the release.");
+		CHECK(!QFileInfo::exists(updateFilePath()));
+		CHECK(!QFileInfo::exists(updateFilePath() + ".journal"));
+	}
+
+	removeUpdateFile();
+}
+
+// Verification required and no SHA-256 published for the update, or a SHA256SUMS file that doesn't list it: the update is downloaded,
+// but not installed
+TEST(verificationRequiredRejectsUnhashedRelease)
+{
+	const QByteArray asset = randomData(1024 * 1024, 43);
+	for (const bool sha256SumsFile : { false, true })
+	{
+		CMockGithubServer server(ReleaseFixtures::repositoryName);
+		CHECK(server.start());
+		server.addAsset(assetName, asset);
+		std::vector<ReleaseFixtures::Asset> assets{ { assetName.toStdString(), server.assetUrl(assetName).toStdString(), {} } };
+		if (sha256SumsFile)
+		{
+			server.addAsset("SHA256SUMS", sha256(asset) + "  App-other.zip\n");
+			assets.push_back({ "SHA256SUMS", server.assetUrl("SHA256SUMS").toStdString(), {} });
+		}
+		server.setReleasesJson(ReleaseFixtures::releaseJson("9.9.9", assets));
+		removeUpdateFile();
+
+		DownloadAttempt attempt(server);
+		CHECK(attempt.checkForUpdates() == 1);
+		CHECK(attempt.download(server.assetUrl(assetName)) == "The update can't be verified: the release doesn't publish its SHA-256.");
+		CHECK(updateFileSha256() == sha256(asset));
+	}
+
+	removeUpdateFile();
+}
+
+#ifdef VERIFIED_DOWNLOAD_TESTS
+// The right SHA-256 from each of the sources lets the update through to the installation; the checksums files are only requested
+// once the download is complete
+TEST(downloadVerifiedFromEveryHashSource)
+{
+	if (!CHECK(outsideAppImage()))
+		return;
+
+	const QByteArray asset = randomData(1024 * 1024, 44);
+	for (const auto source : hashSources)
+	{
+		CMockGithubServer server(ReleaseFixtures::repositoryName);
+		CHECK(server.start());
+		server.addAsset(assetName, asset);
+		server.setReleasesJson(releaseWithHash(server, source, sha256(asset)));
+		removeUpdateFile();
+
+		DownloadAttempt attempt(server);
+		CHECK(attempt.checkForUpdates() == 1);
+		CHECK(installationAttempted(attempt.download(server.assetUrl(assetName))));
+
+		const auto& log = server.requestLog();
+		const bool checksumsRequested = !log.empty() && (log.back().path.endsWith(".sha256") || log.back().path.endsWith("SHA256SUMS"));
+		CHECK(checksumsRequested == (source != HashSource::Digest));
+	}
+
+	removeUpdateFile();
+}
+#endif
+
+// The asset is replaced after the drop: If-Range doesn't match any more, the server sends the new version in full with 200,
+// and the partial file of the old one is discarded
+TEST(downloadRestartsWhenAssetChanges)
+{
+	const QByteArray oldAsset = randomData(1024 * 1024, 34), newAsset = randomData(1024 * 1024 + 1000, 56);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, oldAsset);
+	server.setConnectionDropAfter(oldAsset.size() / 2);
+	removeUpdateFile();
+
+	const QString firstError = DownloadAttempt(server).download(server.assetUrl(assetName));
+	CHECK(!firstError.isEmpty() && !downloadComplete(firstError));
+	CHECK(QFileInfo::exists(updateFilePath() + ".journal"));
+
+	const QByteArray oldEtag = server.assetEtag(assetName);
+	server.addAsset(assetName, newAsset);
+	server.setConnectionDropAfter(0);
+	server.clearRequestLog();
+
+	CHECK(downloadComplete(DownloadAttempt(server).download(server.assetUrl(assetName))));
+	CHECK(updateFileSha256() == sha256(newAsset));
+
+	const auto& log = server.requestLog();
+	CHECK(log.size() == 1);
+	CHECK(!log.empty() && log.front().range.startsWith("bytes=") && log.front().ifRange == oldEtag);
+	CHECK(!log.empty() && log.front().status == 200);
+
+	removeUpdateFile();
+}
+
+// A server without range support ignores Range and sends the whole file with 200, which replaces the partial one
+TEST(downloadRestartsWithoutRangeSupport)
+{
+	const QByteArray asset = randomData(1024 * 1024, 78);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+	server.setConnectionDropAfter(asset.size() / 2);
+	removeUpdateFile();
+
+	CHECK(!downloadComplete(DownloadAttempt(server).download(server.assetUrl(assetName))));
+
+	server.setRangeSupport(false);
+	server.setConnectionDropAfter(0);
+	server.clearRequestLog();
+
+	CHECK(downloadComplete(DownloadAttempt(server).download(server.assetUrl(assetName))));
+	CHECK(updateFileSha256() == sha256(asset));
+	CHECK(QFileInfo(updateFilePath()).size() == asset.size());
+
+	const auto& log = server.requestLog();
+	CHECK(log.size() == 1);
+	CHECK(!log.empty() && log.front().range.startsWith("bytes=") && log.front().status == 200);
+
+	removeUpdateFile();
+}
+
+static constexpr CAutoUpdaterGithub::DownloadIoStrategy ioStrategies[] {
+	CAutoUpdaterGithub::DownloadIoStrategy::Append,
+	CAutoUpdaterGithub::DownloadIoStrategy::Preallocated,
+	CAutoUpdaterGithub::DownloadIoStrategy::MemoryMapped,
+};
+
+// One attempt with the given strategy and chunks much smaller than the asset; returns the error it has ended with
+static QString downloadWithIoStrategy(CMockGithubServer& server, CAutoUpdaterGithub::DownloadIoStrategy strategy)
+{
+	DownloadAttempt attempt(server);
+	attempt.updater().setDownloadIoStrategy(strategy);
+	attempt.updater().setDownloadBufferSize(64 * 1024);
+	return attempt.download(server.assetUrl(assetName));
+}
+
+// Every strategy writes the asset as it is, downloaded in one go and resumed after drops, and leaves no more than the asset in the file
+TEST(downloadWithEveryIoStrategy)
+{
+	const QByteArray asset = randomData(3 * 1024 * 1024 + 333, 21);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+
+	for (const auto strategy : ioStrategies)
+	{
+		for (const qint64 dropAfter : { qint64{ 0 }, static_cast<qint64>(asset.size() / 3) })
+		{
+			server.setConnectionDropAfter(dropAfter);
+			removeUpdateFile();
+
+			QString error;
+			for (int attempt = 0; attempt < 10 && !downloadComplete(error); ++attempt)
+			{
+				error = downloadWithIoStrategy(server, strategy);
+				// Whatever the strategy has reserved for the rest of the file, the partial file ends where the data does
+				CDownloadJournal journal;
+				if (!downloadComplete(error) && CHECK(journal.load(updateFilePath() + ".journal")))
+					CHECK(QFileInfo(updateFilePath()).size() == journal.bytesReceived);
+			}
+
+			CHECK(downloadComplete(error));
+			CHECK(updateFileSha256() == sha256(asset));
+			CHECK(QFileInfo(updateFilePath()).size() == asset.size());
+		}
+	}
+
+	removeUpdateFile();
+}
+
+// After a crash, a preallocated (or memory-mapped) partial file is as long as the whole asset, with garbage after the data that made it
+// to disk, and the journal, stored every few MB, is behind even that: the download resumes from the journal's count, not from the end
+// of the file, and everything after the count is overwritten
+TEST(downloadResumesFromJournalCount)
+{
+	const QByteArray asset = randomData(2 * 1024 * 1024, 22);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+
+	for (const auto strategy : ioStrategies)
+	{
+		server.setConnectionDropAfter(asset.size() / 2);
+		removeUpdateFile();
+		CHECK(!downloadComplete(downloadWithIoStrategy(server, strategy)));
+
+		CDownloadJournal journal;
+		CHECK(journal.load(updateFilePath() + ".journal"));
+		CHECK(journal.bytesReceived > 0 && QFileInfo(updateFilePath()).size() == journal.bytesReceived);
+
+		journal.bytesReceived /= 2;
+		CHECK(journal.store(updateFilePath() + ".journal"));
+		QFile file(updateFilePath());
+		const qint64 writtenSize = QFileInfo(updateFilePath()).size(), garbageSize = asset.size() - writtenSize;
+		CHECK(file.open(QFile::ReadWrite) && file.seek(writtenSize) && file.write(QByteArray(garbageSize, '\xFF')) == garbageSize);
+		file.close();
+		CHECK(QFileInfo(updateFilePath()).size() == asset.size());
+
+		server.setConnectionDropAfter(0);
+		server.clearRequestLog();
+		CHECK(downloadComplete(downloadWithIoStrategy(server, strategy)));
+		CHECK(updateFileSha256() == sha256(asset));
+
+		const auto& log = server.requestLog();
+		CHECK(log.size() == 1);
+		CHECK(!log.empty() && log.front().status == 206 && log.front().range == "bytes=" + QByteArray::number(journal.bytesReceived) + '-');
+	}
+
+	removeUpdateFile();
+}
+
+#ifdef VERIFIED_DOWNLOAD_TESTS
+// With a published digest, the updater's own check passes with every strategy, also for a download resumed after drops
+TEST(downloadWithEveryIoStrategyVerified)
+{
+	if (!CHECK(outsideAppImage()))
+		return;
+
+	const QByteArray asset = randomData(3 * 1024 * 1024 + 333, 23);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+	server.setReleasesJson(ReleaseFixtures::releaseJson("9.9.9", { { assetName.toStdString(), server.assetUrl(assetName).toStdString(), sha256Digest(asset) } }));
+
+	for (const auto strategy : ioStrategies)
+	{
+		for (const qint64 dropAfter : { qint64{ 0 }, static_cast<qint64>(asset.size() / 3) })
+		{
+			server.setConnectionDropAfter(dropAfter);
+			removeUpdateFile();
+
+			QString error;
+			for (int attempt = 0; attempt < 10 && !installationAttempted(error); ++attempt)
+			{
+				DownloadAttempt downloadAttempt(server);
+				downloadAttempt.updater().setDownloadIoStrategy(strategy);
+				downloadAttempt.updater().setDownloadBufferSize(64 * 1024);
+				CHECK(downloadAttempt.checkForUpdates() == 1);
+				error = downloadAttempt.download(server.assetUrl(assetName));
+			}
+
+			CHECK(installationAttempted(error));
+			CHECK(updateFileSha256() == sha256(asset));
+		}
+	}
+
+	removeUpdateFile();
+}
+#endif
+
+// The byte ranges [first, end) the asset was requested in since the log was cleared, in order of their start; the whole asset for a GET without Range
+static std::vector<std::pair<qint64, qint64>> requestedRanges(const CMockGithubServer& server, qint64 assetSize)
+{
+	std::vector<std::pair<qint64, qint64>> ranges;
+	for (const auto& request : server.requestLog())
+	{
+		if (request.method != "GET" || !request.path.endsWith(assetName))
+			continue;
+
+		const auto dash = request.range.indexOf('-');
+		if (!request.range.startsWith("bytes=") || dash < 0)
+			ranges.emplace_back(0, assetSize);
+		else
+			ranges.emplace_back(request.range.mid(6, dash - 6).toLongLong(), dash + 1 < request.range.size() ? request.range.mid(dash + 1).toLongLong() + 1 : assetSize);
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+	return ranges;
+}
+
+// The ranges don't overlap and leave no gaps between first and end
+static bool rangesCover(const std::vector<std::pair<qint64, qint64>>& ranges, qint64 first, qint64 end)
+{
+	qint64 position = first;
+	for (const auto& [rangeFirst, rangeEnd] : ranges)
+	{
+		if (rangeFirst != position || rangeEnd <= rangeFirst)
+		{
+			fprintf(stderr, "Range [%lld, %lld) requested, expected one from %lld\n", static_cast<long long>(rangeFirst), static_cast<long long>(rangeEnd), static_cast<long long>(position));
+			return false;
+		}
+
+		position = rangeEnd;
+	}
+
+	return position == end;
+}
+
+// The HEAD request for the size and the range support, then one bounded Range request per segment, all conditional on the ETag: the segments
+// split the asset between them with no overlaps or gaps, and the file they are written into is the asset
+TEST(segmentedDownloadRequestsDisjointRanges)
+{
+	// Not a multiple of the segment count, so the segments aren't all of the same size
+	const QByteArray asset = randomData(4 * 1024 * 1024 + 1001, 31);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+	removeUpdateFile();
+
+	DownloadAttempt attempt(server);
+	attempt.updater().setDownloadSegmentation(4, 1024 * 1024);
+	attempt.updater().setDownloadBufferSize(64 * 1024);
+	CHECK(downloadComplete(attempt.download(server.assetUrl(assetName))));
+	CHECK(updateFileSha256() == sha256(asset));
+	CHECK(QFileInfo(updateFilePath()).size() == asset.size());
+
+	const auto& log = server.requestLog();
+	CHECK(log.size() == 5);
+	CHECK(!log.empty() && log.front().method == "HEAD" && log.front().path.endsWith(assetName));
+	for (size_t i = 1; i < log.size(); ++i)
+	{
+		CHECK(log[i].method == "GET" && log[i].status == 206);
+		CHECK(log[i].ifRange == server.assetEtag(assetName));
+		CHECK(!log[i].range.endsWith("-")); // Bounded, each segment ends where the next one starts
+	}
+
+	CHECK(rangesCover(requestedRanges(server, asset.size()), 0, asset.size()));
+	removeUpdateFile();
+}
+
+// Every segment is cut off: the next attempt splits what's left after the gapless beginning of the file (the journal's count) into segments again,
+// or, once the rest is too short for that, downloads it over one connection; in the end, the file is the asset
+TEST(segmentedDownloadResumesAfterConnectionDrop)
+{
+	const QByteArray asset = randomData(4 * 1024 * 1024 + 1001, 32);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+	server.setConnectionDropAfter(512 * 1024);
+	removeUpdateFile();
+
+	QString error;
+	for (int attempt = 0; attempt < 30 && !downloadComplete(error); ++attempt)
+	{
+		CDownloadJournal journal;
+		const qint64 resumeFrom = journal.load(updateFilePath() + ".journal") ? journal.bytesReceived : 0;
+
+		server.clearRequestLog();
+		DownloadAttempt downloadAttempt(server);
+		downloadAttempt.updater().setDownloadSegmentation(4, 1024 * 1024);
+		downloadAttempt.updater().setDownloadBufferSize(64 * 1024);
+		error = downloadAttempt.download(server.assetUrl(assetName));
+
+		CHECK(rangesCover(requestedRanges(server, asset.size()), resumeFrom, asset.size()));
+	}
+
+	CHECK(downloadComplete(error));
+	CHECK(updateFileSha256() == sha256(asset));
+	CHECK(!QFileInfo::exists(updateFilePath() + ".journal"));
+
+	removeUpdateFile();
+}
+
+// The HEAD request shows no range support: the update is downloaded over a single connection, with no Range
+TEST(segmentedDownloadFallsBackWithoutRangeSupport)
+{
+	const QByteArray asset = randomData(4 * 1024 * 1024 + 1001, 33);
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.addAsset(assetName, asset);
+	server.setRangeSupport(false);
+	removeUpdateFile();
+
+	DownloadAttempt attempt(server);
+	attempt.updater().setDownloadSegmentation(4, 1024 * 1024);
+	CHECK(downloadComplete(attempt.download(server.assetUrl(assetName))));
+	CHECK(updateFileSha256() == sha256(asset));
+
+	const auto& log = server.requestLog();
+	CHECK(log.size() == 2);
+	CHECK(!log.empty() && log.front().method == "HEAD");
+	CHECK(log.size() == 2 && log.back().method == "GET" && log.back().range.isEmpty() && log.back().status == 200 && log.back().bodyBytes == asset.size());
+
+	removeUpdateFile();
+}
+
+// A <file>.zsync control file as zsyncmake writes it (without the gzip options), with full-length checksums
+static QByteArray zsyncControlFile(const QByteArray& data, const QString& fileName, qint64 blockSize)
+{
+	QByteArray controlFile = "zsync: 0.6.2\n"
+		"Filename: " + fileName.toUtf8() + "\n"
+		"Blocksize: " + QByteArray::number(blockSize) + "\n"
+		"Length: " + QByteArray::number(static_cast<qint64>(data.size())) + "\n"
+		"Hash-Lengths: 1,4,16\n"
+		"URL: " + fileName.toUtf8() + "\n"
+		"SHA-1: " + QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() + "\n\n";
+
+	for (qint64 offset = 0; offset < data.size(); offset += blockSize)
+	{
+		// The last block is padded with zeroes
+		QByteArray block = data.mid(offset, blockSize);
+		block.append(QByteArray(blockSize - block.size(), '\0'));
+
+		// The rolling checksum: a is the sum of the bytes, b the sum of the bytes weighted by their distance from the end, big-endian
+		uint16_t a = 0, b = 0;
+		for (qint64 i = 0; i < blockSize; ++i)
+		{
+			const auto byte = static_cast<uchar>(block[i]);
+			a = static_cast<uint16_t>(a + byte);
+			b = static_cast<uint16_t>(b + (blockSize - i) * byte);
+		}
+
+		const char rsum[4] = { static_cast<char>(a >> 8), static_cast<char>(a & 0xFF), static_cast<char>(b >> 8), static_cast<char>(b & 0xFF) };
+		controlFile.append(rsum, 4);
+		controlFile += QCryptographicHash::hash(block, QCryptographicHash::Md4);
+	}
+
+	return controlFile;
+}
+
+// The installed version, which the zsync update is assembled from
+static QString zsyncBaseFilePath()
+{
+	return QDir::tempPath() + '/' + QCoreApplication::applicationName() + "-base" + UPDATE_FILE_EXTENSION;
+}
+
+static bool writeFile(const QString& filePath, const QByteArray& data)
+{
+	QFile file(filePath);
+	return file.open(QFile::WriteOnly | QFile::Truncate) && file.write(data) == data.size();
+}
+
+// Serves the update and its .zsync index, published with a release the check finds. Returns the update.
+static QByteArray publishZsyncUpdate(CMockGithubServer& server, qint64 blockSize, const QByteArray& controlFileSha1 = {})
+{
+	const QByteArray asset = randomData(1024 * 1024, 90);
+	QByteArray controlFile = zsyncControlFile(asset, assetName, blockSize);
+	if (!controlFileSha1.isEmpty())
+		controlFile.replace(QCryptographicHash::hash(asset, QCryptographicHash::Sha1).toHex(), controlFileSha1);
+
+	server.addAsset(assetName, asset);
+	server.addAsset(assetName + ".zsync", controlFile);
+	server.setReleasesJson(ReleaseFixtures::releaseJson("9.9.9", {
+		{ assetName.toStdString(), server.assetUrl(assetName).toStdString(), {} },
+		{ (assetName + ".zsync").toStdString(), server.assetUrl(assetName + ".zsync").toStdString(), {} }
+	}));
+
+	return asset;
+}
+
+// The installed version differs from the update in three blocks far apart, and has some data inserted at the start, which moves
+// all the blocks: only the three are downloaded, one Range request each
+TEST(zsyncDownloadsOnlyChangedBlocks)
+{
+	static constexpr qint64 blockSize = 4096;
+
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	const QByteArray asset = publishZsyncUpdate(server, blockSize);
+
+	static constexpr qint64 changedBlocks[] = { 10, 100, 200 };
+	QByteArray base = asset;
+	for (const qint64 block : changedBlocks)
+		base[block * blockSize + 100] = static_cast<char>(~base[block * blockSize + 100]);
+	base.prepend(randomData(1000, 91));
+	CHECK(writeFile(zsyncBaseFilePath(), base));
+	removeUpdateFile();
+
+	DownloadAttempt attempt(server, zsyncBaseFilePath());
+	CHECK(attempt.checkForUpdates() == 1);
+	server.clearRequestLog();
+	CHECK(downloadComplete(attempt.download(server.assetUrl(assetName))));
+	CHECK(updateFileSha256() == sha256(asset));
+
+	// The index, the probe of the update, then the blocks
+	std::vector<QByteArray> ranges;
+	for (const auto& request : server.requestLog())
+	{
+		if (request.method == "GET" && request.path.endsWith(assetName))
+		{
+			CHECK(request.status == 206);
+			CHECK(request.ifRange == server.assetEtag(assetName));
+			ranges.push_back(request.range);
+		}
+	}
+
+	std::sort(ranges.begin(), ranges.end(), [](const QByteArray& l, const QByteArray& r) { return l.mid(6).toLongLong() < r.mid(6).toLongLong(); });
+	std::vector<QByteArray> expectedRanges;
+	for (const qint64 block : changedBlocks)
+		expectedRanges.push_back("bytes=" + QByteArray::number(block * blockSize) + '-' + QByteArray::number((block + 1) * blockSize - 1));
+	CHECK(ranges == expectedRanges);
+
+	QFile::remove(zsyncBaseFilePath());
+	removeUpdateFile();
+}
+
+// The assembled file doesn't match the SHA-1 in the index: the whole update is downloaded instead
+TEST(zsyncFallsBackToFullDownload)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	const QByteArray asset = publishZsyncUpdate(server, 4096, QByteArray(40, '0'));
+	CHECK(writeFile(zsyncBaseFilePath(), asset));
+	removeUpdateFile();
+
+	DownloadAttempt attempt(server, zsyncBaseFilePath());
+	CHECK(attempt.checkForUpdates() == 1);
+	server.clearRequestLog();
+	CHECK(downloadComplete(attempt.download(server.assetUrl(assetName))));
+	CHECK(updateFileSha256() == sha256(asset));
+
+	const auto& log = server.requestLog();
+	CHECK(!log.empty() && log.back().method == "GET" && log.back().path.endsWith(assetName) && log.back().range.isEmpty() && log.back().status == 200);
+
+	QFile::remove(zsyncBaseFilePath());
+	removeUpdateFile();
+}
+
+// The installed version, which the delta update is applied to
+static QString deltaBaseFilePath()
+{
+	return QDir::tempPath() + '/' + QCoreApplication::applicationName() + "-delta-base" + UPDATE_FILE_EXTENSION;
+}
+
+static QString deltaAssetName(const char* fromVersion)
+{
+	return assetName + ".from-" + fromVersion + ".delta";
+}
+
+// Serves the update and a delta to it from fromVersion, published with a release the check finds
+static void publishDeltaUpdate(CMockGithubServer& server, const QByteArray& asset, const QByteArray& delta, const char* fromVersion)
+{
+	server.addAsset(assetName, asset);
+	server.addAsset(deltaAssetName(fromVersion), delta);
+	server.setReleasesJson(ReleaseFixtures::releaseJson("9.9.9", {
+		{ assetName.toStdString(), server.assetUrl(assetName).toStdString(), {} },
+		{ deltaAssetName(fromVersion).toStdString(), server.assetUrl(deltaAssetName(fromVersion)).toStdString(), {} }
+	}));
+}
+
+// Checks for the update and downloads it with the installed version at deltaBaseFilePath(). Returns the paths requested for the download, in order.
+static std::vector<QString> downloadWithDelta(CMockGithubServer& server, const QByteArray& installedVersion, QString& error)
+{
+	if (!CHECK(writeFile(deltaBaseFilePath(), installedVersion)))
+		return {};
+	removeUpdateFile();
+
+	DownloadAttempt attempt(server, deltaBaseFilePath());
+	CHECK(attempt.checkForUpdates() == 1);
+	server.clearRequestLog();
+	error = attempt.download(server.assetUrl(assetName));
+	QFile::remove(deltaBaseFilePath());
+
+	std::vector<QString> paths;
+	for (const auto& request : server.requestLog())
+		paths.push_back(request.path);
+
+	return paths;
+}
+
+// There's no delta from the installed version, only from an older one: the full update is downloaded
+TEST(deltaFallsBackWithoutMatchingPatch)
+{
+	const QByteArray installed = randomData(512 * 1024, 100);
+	QByteArray asset = installed;
+	asset[1000] = static_cast<char>(~asset[1000]);
+
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	publishDeltaUpdate(server, asset, DeltaGenerator::generate(randomData(1000, 101), asset), "0.0.0");
+
+	QString error;
+	const std::vector<QString> paths = downloadWithDelta(server, installed, error);
+	CHECK(downloadComplete(error));
+	CHECK(updateFileSha256() == sha256(asset));
+	CHECK(paths == std::vector<QString>{ "/download/" + assetName });
+
+	removeUpdateFile();
+}
+
+// The delta is requested, and once it turns out not to apply, the full update: a damaged delta, one made from another version,
+// and one whose result doesn't match the hash it carries
+TEST(deltaFallsBackOnBadPatch)
+{
+	const QByteArray installed = randomData(512 * 1024, 102);
+	QByteArray asset = installed;
+	for (qint64 i = 0; i < 20; ++i)
+		asset[i * 20000] = static_cast<char>(~asset[i * 20000]);
+
+	const QByteArray validDelta = DeltaGenerator::generate(installed, asset);
+	QByteArray damagedDelta = validDelta, wrongResultHashDelta = validDelta;
+	for (qint64 i = 100; i < damagedDelta.size(); i += 3)
+		damagedDelta[i] = static_cast<char>(damagedDelta[i] ^ 0x55);
+	wrongResultHashDelta[8 + 2 * 8 + 32] = static_cast<char>(wrongResultHashDelta[8 + 2 * 8 + 32] ^ 1);
+
+	const QByteArray deltas[] = { damagedDelta, DeltaGenerator::generate(randomData(installed.size(), 103), asset), wrongResultHashDelta };
+	for (const QByteArray& delta : deltas)
+	{
+		CMockGithubServer server(ReleaseFixtures::repositoryName);
+		CHECK(server.start());
+		publishDeltaUpdate(server, asset, delta, ReleaseFixtures::oldestVersion);
+
+		QString error;
+		const std::vector<QString> paths = downloadWithDelta(server, installed, error);
+		CHECK(downloadComplete(error));
+		CHECK(updateFileSha256() == sha256(asset));
+		CHECK((paths == std::vector<QString>{ "/download/" + deltaAssetName(ReleaseFixtures::oldestVersion), "/download/" + assetName }));
+	}
+
+	removeUpdateFile();
+}
+
+#ifdef VERIFIED_DOWNLOAD_TESTS
+// Only the delta is downloaded, and the patched file is the update. The patch carries the hash of the update, so the updater goes on
+// to install it.
+TEST(deltaUpdateApplied)
+{
+	if (!CHECK(outsideAppImage()))
+		return;
+
+	const QByteArray installed = randomData(512 * 1024, 104);
+	const QByteArray asset = installed.left(200'000) + randomData(3000, 105) + installed.mid(200'000);
+
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	publishDeltaUpdate(server, asset, DeltaGenerator::generate(installed, asset), ReleaseFixtures::oldestVersion);
+
+	QString error;
+	const std::vector<QString> paths = downloadWithDelta(server, installed, error);
+	CHECK(installationAttempted(error));
+	CHECK(updateFileSha256() == sha256(asset));
+	CHECK(paths == std::vector<QString>{ "/download/" + deltaAssetName(ReleaseFixtures::oldestVersion) });
+
+	removeUpdateFile();
+}
+#endif
@@ -0,0 +1,258 @@
+#include "releasefixtures.hpp"
+#include "testing.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include "maddy/parser.h"
+RESTORE_COMPILER_WARNINGS
+
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// How the block parsers recognized their starting lines before the prefix checks replaced the regular expressions. The prefix checks
+// must agree with these on every line.
+namespace RegexBlockStarts {
+
+static bool checklist(const std::string& line)
+{
+	static const std::regex re(R"(^- \[[x| ]\] .*)");
+	return std::regex_match(line, re);
+}
+
+static bool codeBlock(const std::string& line)
+{
+	static const std::regex re("^(?:`){3}(.*)$");
+	return std::regex_match(line, re);
+}
+
+static bool headline(const std::string& line)
+{
+	static const std::regex re("^(?:#){1,6} (.*)");
+	return std::regex_match(line, re);
+}
+
+static bool horizontalLine(const std::string& line)
+{
+	static const std::regex re("^---$");
+	return std::regex_match(line, re);
+}
+
+static bool latexBlock(const std::string& line)
+{
+	static const std::regex re(R"(^(?:\$){2}(.*)$)");
+	return std::regex_match(line, re);
+}
+
+static bool orderedList(const std::string& line)
+{
+	static const std::regex re("^1\\. .*");
+	return std::regex_match(line, re);
+}
+
+static bool quote(const std::string& line)
+{
+	static const std::regex re(R"(^\>.*)");
+	return std::regex_match(line, re);
+}
+
+static bool unorderedList(const std::string& line)
+{
+	static const std::regex re("^[+*-] .*");
+	return std::regex_match(line, re);
+}
+
+} // namespace RegexBlockStarts
+
+enum class BlockType { None, CodeBlock, LatexBlock, Headline, HorizontalLine, Quote, Table, Checklist, OrderedList, UnorderedList, Html, Paragraph };
+
+// Parser::getBlockParserForLine() as it was with the regular expressions: the same order, the same configuration checks
+static BlockType regexSelection(const std::string& line, const maddy::ParserConfig* config)
+{
+	const auto enabled = [config](uint32_t type) { return !config || (config->enabledParsers & type) != 0; };
+	const auto enabledExplicitly = [config](uint32_t type) { return config && (config->enabledParsers & type) != 0; };
+
+	if (enabled(maddy::types::CODE_BLOCK_PARSER) && RegexBlockStarts::codeBlock(line))
+		return BlockType::CodeBlock;
+	if (enabledExplicitly(maddy::types::LATEX_BLOCK_PARSER) && RegexBlockStarts::latexBlock(line))
+		return BlockType::LatexBlock;
+	if (enabled(maddy::types::HEADLINE_PARSER) && RegexBlockStarts::headline(line))
+		return BlockType::Headline;
+	if (enabled(maddy::types::HORIZONTAL_LINE_PARSER) && RegexBlockStarts::horizontalLine(line))
+		return BlockType::HorizontalLine;
+	if (enabled(maddy::types::QUOTE_PARSER) && RegexBlockStarts::quote(line))
+		return BlockType::Quote;
+	if (enabled(maddy::types::TABLE_PARSER) && maddy::TableParser::IsStartingLine(line))
+		return BlockType::Table;
+	if (enabled(maddy::types::CHECKLIST_PARSER) && RegexBlockStarts::checklist(line))
+		return BlockType::Checklist;
+	if (enabled(maddy::types::ORDERED_LIST_PARSER) && RegexBlockStarts::orderedList(line))
+		return BlockType::OrderedList;
+	if (enabled(maddy::types::UNORDERED_LIST_PARSER) && RegexBlockStarts::unorderedList(line))
+		return BlockType::UnorderedList;
+	if (enabledExplicitly(maddy::types::HTML_PARSER) && maddy::HtmlParser::IsStartingLine(line))
+		return BlockType::Html;
+	if (maddy::ParagraphParser::IsStartingLine(line))
+		return BlockType::Paragraph;
+
+	return BlockType::None;
+}
+
+// The selection the parser makes now
+class SelectionProbe final : public maddy::Parser
+{
+public:
+	using maddy::Parser::Parser;
+
+	[[nodiscard]] BlockType selection(const std::string& line) const
+	{
+		const std::shared_ptr<maddy::BlockParser> parser = getBlockParserForLine(line);
+		const maddy::BlockParser* p = parser.get();
+		if (!p)
+			return BlockType::None;
+		if (dynamic_cast<const maddy::CodeBlockParser*>(p))
+			return BlockType::CodeBlock;
+		if (dynamic_cast<const maddy::LatexBlockParser*>(p))
+			return BlockType::LatexBlock;
+		if (dynamic_cast<const maddy::HeadlineParser*>(p))
+			return BlockType::Headline;
+		if (dynamic_cast<const maddy::HorizontalLineParser*>(p))
+			return BlockType::HorizontalLine;
+		if (dynamic_cast<const maddy::QuoteParser*>(p))
+			return BlockType::Quote;
+		if (dynamic_cast<const maddy::TableParser*>(p))
+			return BlockType::Table;
+		if (dynamic_cast<const maddy::ChecklistParser*>(p))
+			return BlockType::Checklist;
+		if (dynamic_cast<const maddy::OrderedListParser*>(p))
+			return BlockType::OrderedList;
+		if (dynamic_cast<const maddy::UnorderedListParser*>(p))
+			return BlockType::UnorderedList;
+		if (dynamic_cast<const maddy::HtmlParser*>(p))
+			return BlockType::Html;
+		if (dynamic_cast<const maddy::ParagraphParser*>(p))
+			return BlockType::Paragraph;
+
+		return BlockType::None;
+	}
+};
+
+// Every line of the release notes fixtures, the edge cases of each pattern, and random lines made of the characters that matter to them
+static std::vector<std::string> blockStartCorpus()
+{
+	std::vector<std::string> lines{
+		"", " ", "\r", "a",
+		"```", "```cpp", "```\r", "``", "`", " ```", "````",
+		"$$", "$$x", "$$\r", "$", " $$",
+		"# a", "#", "# ", "#a", "###### a", "####### a", "# a\r", " # a",
+		"---", "--- ", "----", "--", "---\r", " ---",
+		">", "> a", ">a", ">\r", " > a",
+		"|table>", "|table> ", "|table", "| a | b |",
+		"- [x] a", "- [ ] a", "- [|] a", "- [x]", "- [x] ", "- [X] a", "- [x] a\r", "- [y] a",
+		"1. a", "1.", "1. ", "1.a", "10. a", "2. a", "1. a\r",
+		"- a", "+ a", "* a", "-", "- ", "*", "-a", "- a\r", " - a",
+		"<div>", "<", "<!-- a -->",
+	};
+
+	const auto addLines = [&lines](const std::string& text) {
+		std::istringstream input{ text };
+		for (std::string line; std::getline(input, line);)
+			lines.push_back(line);
+	};
+
+	for (const std::string& note : ReleaseFixtures::markdownCorpus())
+		addLines(note);
+	addLines(ReleaseFixtures::nestedMarkdown(8));
+
+	static constexpr char alphabet[] = { '`', '$', '#', '-', '>', '|', '1', '.', '+', '*', '<', '[', ']', 'x', ' ', 'a', '\r', '\n', '\t' };
+	std::mt19937 random(20240101);
+	std::uniform_int_distribution<size_t> length(0, 10), character(0, std::size(alphabet) - 1);
+	for (int i = 0; i < 100'000; ++i)
+	{
+		std::string line(length(random), ' ');
+		for (char& c : line)
+			c = alphabet[character(random)];
+		lines.push_back(std::move(line));
+	}
+
+	return lines;
+}
+
+// The control characters escaped
+static std::string printable(const std::string& line)
+{
+	std::string result;
+	for (const char c : line)
+	{
+		if (c == '\r')
+			result += "\\r";
+		else if (c == '\n')
+			result += "\\n";
+		else if (c == '\t')
+			result += "\\t";
+		else
+			result += c;
+	}
+
+	return result;
+}
+
+static const std::vector<std::string>& corpus()
+{
+	static const std::vector<std::string> lines = blockStartCorpus();
+	return lines;
+}
+
+TEST(maddyBlockStartsMatchRegexes)
+{
+	int mismatches = 0;
+	for (const std::string& line : corpus())
+	{
+		const bool agree = maddy::ChecklistParser::IsStartingLine(line) == RegexBlockStarts::checklist(line)
+			&& maddy::CodeBlockParser::IsStartingLine(line) == RegexBlockStarts::codeBlock(line)
+			&& maddy::HeadlineParser::IsStartingLine(line) == RegexBlockStarts::headline(line)
+			&& maddy::HorizontalLineParser::IsStartingLine(line) == RegexBlockStarts::horizontalLine(line)
+			&& maddy::LatexBlockParser::IsStartingLine(line) == RegexBlockStarts::latexBlock(line)
+			&& maddy::OrderedListParser::IsStartingLine(line) == RegexBlockStarts::orderedList(line)
+			&& maddy::QuoteParser::IsStartingLine(line) == RegexBlockStarts::quote(line)
+			&& maddy::UnorderedListParser::IsStartingLine(line) == RegexBlockStarts::unorderedList(line);
+
+		// Only the first few, the rest would just repeat them
+		if (!agree && ++mismatches <= 10)
+			fprintf(stderr, "The block start checks disagree with the regular expressions on \"%s\"\n", printable(line).c_str());
+	}
+
+	CHECK(mismatches == 0);
+}
+
+TEST(maddyBlockParserSelectionMatchesRegexes)
+{
+	const auto config = [](uint32_t enabledParsers) {
+		auto parserConfig = std::make_shared<maddy::ParserConfig>();
+		parserConfig->enabledParsers = enabledParsers;
+		return parserConfig;
+	};
+
+	// No configuration, the default one, all the parsers, and all but a few
+	const std::vector<std::shared_ptr<maddy::ParserConfig>> configs{
+		nullptr,
+		config(maddy::types::DEFAULT),
+		config(maddy::types::ALL),
+		config(maddy::types::ALL & ~(maddy::types::HEADLINE_PARSER | maddy::types::QUOTE_PARSER | maddy::types::UNORDERED_LIST_PARSER)),
+	};
+
+	for (const auto& parserConfig : configs)
+	{
+		const SelectionProbe parser(parserConfig);
+		int mismatches = 0;
+		for (const std::string& line : corpus())
+		{
+			if (parser.selection(line) != regexSelection(line, parserConfig.get()) && ++mismatches <= 10)
+				fprintf(stderr, "A different block parser is picked for \"%s\"\n", printable(line).c_str());
+		}
+
+		CHECK(mismatches == 0);
+	}
+}
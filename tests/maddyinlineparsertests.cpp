@@ -0,0 +1,110 @@
+#include "releasefixtures.hpp"
+#include "testing.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include "maddy/parser.h"
+RESTORE_COMPILER_WARNINGS
+
+#include <random>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// maddy::InlineParser replaces the regex-based line parsers (ParserConfig::isRegexInlineParsingEnabled) and must produce the same HTML.
+// The inputs are short enough for std::regex to handle: the regex parsers backtrack and overflow the stack on long lines.
+
+// The inline constructs, whole and in pieces, and what they must not be confused with
+static std::vector<std::string> inlineCorpus()
+{
+	std::vector<std::string> documents{
+		"*a*", "**a**", "_a_", "__a__", "~~a~~", "`a`", "***a***", "___a___", "*a", "**a", "_a", "~~a", "`a", "a*", "a`", "* a *", "** a**",
+		"**a _b_ c**", "*a **b** c*", "_a **b** c_", "__a *b* c__", "~~a **b** c~~", "**a ~~b~~ c**", "*a `b` c*", "`a *b* c`", "**a `b`**",
+		"a ` b *c*", "*a* `b", "<code>*a*</code>", "*a* <code>", "*a* </code>", "`*a*`*b*`", "**a*b**", "*a**b*", "_a__b_", "__a_b__",
+		"[a](b)", "[a]( b )", "[a](b \"t\")", "[a](b  \"t\"  )", "[a](b \"t)", "[a](b\"t\")", "[a](b c)", "[a](b^c)", "[a]()", "[a](", "[a]",
+		"[a", "[]()", "[[a](b)", "[a]](b)", "[a](b))", "[a]((b)", "[a](http://example.com/(b))", "[a](http://example.com/b_(c))",
+		"[a (b)](c)", "[a](b) [c](d)", "[a](b)[c](d \"e\")", "[*a*](b)", "[a](*b*)", "[`a`](b)", "[a](b `c`)",
+		"![a](b)", "![a](b \"t\")", "![a](b)c)", "![a](b)]", "![a](b))", "![a](b](c)", "![a]", "![a](", "![](b)", "!![a](b)", "![a](b) ![c](d)",
+		"![[a](b)](c)", "[![a](b)](c)", "a\rb", "a\r\nb", "a\r", "\r", "*a\rb*", "`a\rb`", "a  ", "a\\*b\\*",
+	};
+
+	for (const std::string& note : ReleaseFixtures::markdownCorpus())
+		documents.push_back(note);
+
+	// Inline soup: the delimiters and the parts of links and images in random order, unterminated and nested any way, each in a paragraph
+	static constexpr const char* tokens[] = {
+		"*", "**", "_", "__", "~~", "~", "`", "``", "[", "]", "(", ")", "![", "](", "\"", "^", " ", "  ", "a", "bc", "<code>", "</code>", "\r",
+		"http://example.com/(x)", "\\",
+	};
+	std::mt19937 random(20261018);
+	std::uniform_int_distribution<size_t> length(1, 16), token(0, std::size(tokens) - 1);
+	for (int i = 0; i < 2'000; ++i)
+	{
+		std::string line = "a ";
+		for (size_t n = length(random); n > 0; --n)
+			line += tokens[token(random)];
+		documents.push_back(std::move(line));
+	}
+
+	return documents;
+}
+
+static std::string toHtml(const maddy::Parser& parser, const std::string& markdown)
+{
+	std::istringstream input{ markdown };
+	return parser.Parse(input);
+}
+
+// The control characters escaped
+static std::string printable(const std::string& text)
+{
+	std::string result;
+	for (const char c : text)
+	{
+		if (c == '\r')
+			result += "\\r";
+		else if (c == '\n')
+			result += "\\n";
+		else
+			result += c;
+	}
+
+	return result;
+}
+
+TEST(maddyInlineParserMatchesRegexParsers)
+{
+	const auto config = [](uint32_t enabledParsers, bool regexInlineParsing) {
+		auto parserConfig = std::make_shared<maddy::ParserConfig>();
+		parserConfig->enabledParsers = enabledParsers;
+		parserConfig->isRegexInlineParsingEnabled = regexInlineParsing;
+		return parserConfig;
+	};
+
+	// The default set of parsers, all of them, and all but a few of the inline ones, so that the rest run without them first
+	static constexpr uint32_t parserSets[] {
+		maddy::types::DEFAULT,
+		maddy::types::ALL,
+		maddy::types::ALL & ~(maddy::types::STRONG_PARSER | maddy::types::IMAGE_PARSER),
+		maddy::types::DEFAULT & ~(maddy::types::INLINE_CODE_PARSER | maddy::types::BREAKLINE_PARSER),
+	};
+
+	const std::vector<std::string> documents = inlineCorpus();
+	for (const uint32_t enabledParsers : parserSets)
+	{
+		const maddy::Parser linearParser(config(enabledParsers, false)), regexParser(config(enabledParsers, true));
+		int mismatches = 0;
+		for (const std::string& document : documents)
+		{
+			const std::string linearHtml = toHtml(linearParser, document), regexHtml = toHtml(regexParser, document);
+			// Only the first few, the rest would just repeat them
+			if (linearHtml != regexHtml && ++mismatches <= 10)
+			{
+				fprintf(stderr, "The inline parser and the regex parsers disagree on \"%s\":\n  \"%s\"\n  \"%s\"\n",
+					printable(document).c_str(), printable(linearHtml).c_str(), printable(regexHtml).c_str());
+			}
+		}
+
+		CHECK(mismatches == 0);
+	}
+}
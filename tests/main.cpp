@@ -0,0 +1,17 @@
+#include "testing.hpp"
+
+#include "../cpp-template-utils/compiler/compiler_warnings_control.h"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCoreApplication>
+RESTORE_COMPILER_WARNINGS
+
+// autoupdater-tests [name filter]
+int main(int argc, char* argv[])
+{
+	// The network tests need an event loop
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("autoupdater-tests");
+
+	return Testing::runTests(argc > 1 ? argv[1] : nullptr) == 0 ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include "cdownloadprogressthrottle.h"
+#include "testing.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Feeds the throttle like the network reply does and collects what would be passed on to the listener. The time only moves on when
+// the test says so, so that the results don't depend on how fast the machine is or on the scheduler.
+struct ThrottledListener {
+	CDownloadProgressThrottle throttle;
+	std::vector<CDownloadProgressThrottle::Progress> calls;
+	qint64 microseconds = 0;
+
+	ThrottledListener()
+	{
+		throttle.setClock([this] { return microseconds / 1000; });
+	}
+
+	ThrottledListener(const ThrottledListener&) = delete;
+	ThrottledListener& operator=(const ThrottledListener&) = delete;
+
+	void onProgress(qint64 bytesReceived, qint64 bytesTotal)
+	{
+		CDownloadProgressThrottle::Progress progress;
+		if (throttle.update(bytesReceived, bytesTotal, progress))
+			calls.push_back(progress);
+	}
+};
+
+// A fast link: 100,000 notifications with no time between them
+TEST(progressThrottleCoalescesBurst)
+{
+	static constexpr qint64 total = 100'000'000, step = 1'000;
+
+	ThrottledListener listener;
+	for (qint64 received = step; received <= total; received += step)
+		listener.onProgress(received, total);
+
+	// The first and the final updates only
+	CHECK(listener.calls.size() == 2);
+	CHECK(!listener.calls.empty() && listener.calls.front().bytesReceived == step);
+	CHECK(!listener.calls.empty() && listener.calls.back().bytesReceived == total);
+	CHECK(!listener.calls.empty() && listener.calls.back().percentage() == 100.0f);
+}
+
+// One notification of 1,000 bytes every 100 us for 300 ms: one update every 20 ms, at 10 MB/s
+TEST(progressThrottleLimitsRate)
+{
+	static constexpr qint64 duration = 300, interval = 20, step = 1000;
+
+	ThrottledListener listener;
+	listener.throttle.setMinimumInterval(interval);
+	listener.throttle.setMinimumDelta(0.0f);
+
+	const qint64 total = duration * 10 * step;
+	for (qint64 received = step; received < total; received += step, listener.microseconds += 100)
+		listener.onProgress(received, total);
+	listener.onProgress(total, total);
+
+	// At 0, 20, ... 280 ms, and the final one
+	CHECK(listener.calls.size() == duration / interval + 1);
+	CHECK(!listener.calls.empty() && listener.calls.back().percentage() == 100.0f);
+
+	for (size_t i = 1; i + 1 < listener.calls.size(); ++i)
+		CHECK(listener.calls[i].bytesReceived == listener.calls[i - 1].bytesReceived + interval * 10 * step);
+
+	// A steady rate is estimated as it is, and the time remaining from it (the final update comes early, after 19 ms)
+	for (size_t i = 1; i + 1 < listener.calls.size(); ++i)
+		CHECK(std::abs(listener.calls[i].bytesPerSecond - 10'000'000.0) < 1.0);
+
+	CHECK(listener.calls.size() < 2 || listener.calls[1].secondsRemaining == 1); // 2,799,000 bytes to go
+	CHECK(!listener.calls.empty() && listener.calls.back().secondsRemaining == 0);
+}
+
+// The final update passes even right after another one, and even if it's no further than the minimum delta
+TEST(progressThrottleDeliversFinalUpdate)
+{
+	ThrottledListener listener;
+	listener.throttle.setMinimumInterval(60 * 60 * 1000);
+	listener.throttle.setMinimumDelta(50.0f);
+
+	listener.onProgress(0, 1000);
+	listener.onProgress(999, 1000);
+	listener.onProgress(1000, 1000);
+	// Nothing new
+	listener.onProgress(1000, 1000);
+
+	CHECK(listener.calls.size() == 2);
+	CHECK(!listener.calls.empty() && listener.calls.back().percentage() == 100.0f);
+}
+
+// The minimum delta only applies if the total size is known
+TEST(progressThrottleUnknownTotal)
+{
+	ThrottledListener listener;
+	listener.throttle.setMinimumInterval(0);
+	listener.throttle.setMinimumDelta(50.0f);
+
+	for (qint64 received = 1; received <= 1000; ++received)
+		listener.onProgress(received, -1);
+
+	CHECK(listener.calls.size() == 1000);
+	CHECK(!listener.calls.empty() && listener.calls.front().percentage() == 0.0f);
+	CHECK(!listener.calls.empty() && listener.calls.back().secondsRemaining == -1);
+}
+
+// A download that starts over is reported at once
+TEST(progressThrottleRestart)
+{
+	ThrottledListener listener;
+	listener.throttle.setMinimumInterval(60 * 60 * 1000);
+
+	listener.onProgress(500, 1000);
+	listener.onProgress(100, 1000);
+	listener.onProgress(200, 1000);
+
+	CHECK(listener.calls.size() == 2);
+	CHECK(listener.calls.size() == 2 && listener.calls[1].bytesReceived == 100);
+
+	listener.throttle.reset();
+	listener.onProgress(300, 1000);
+	CHECK(listener.calls.size() == 3);
+}
@@ -0,0 +1,284 @@
+#include "creleasesstreamparser.h"
+#include "releasefixtures.hpp"
+#include "testing.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <optional>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using Release = CReleasesStreamParser::Release;
+
+// Escapes of every kind, surrogate pairs, nulls and values of the wrong type in the fields the parser extracts, and the same keys
+// in nested objects and arrays where they must be ignored
+static const QByteArray edgeCasesJson = R"([
+	{
+		"url": "https://api.github.com/repos/bench/app/releases/2",
+		"author": { "login": "someone", "name": "Not the release name", "tag_name": "not-the-tag", "assets": [{ "name": "not an asset" }] },
+		"tag_name": "v2.0.0",
+		"name": "Quotes \"and\" back\\slashes \/ and \b\f\n\r\t",
+		"draft": false, "prerelease": true,
+		"created_at": "2026-10-18T12:00:00Z",
+		"html_url": "https:\/\/github.com\/bench\/app\/releases\/tag\/v2.0.0",
+		"reactions": { "total_count": -1.5e+3, "values": [1, 2.25, 0, -0, 1E9, 0.5e-2, true, false, null, [], {}, [[{ "name": "deep" }]]] },
+		"assets": [
+			{
+				"name": "App.AppImage",
+				"uploader": { "name": "uploader", "browser_download_url": "https://example.com/wrong", "digest": "sha256:wrong" },
+				"labels": [["x"], { "name": "y" }],
+				"browser_download_url": "https://example.com/App.AppImage",
+				"digest": "sha256:0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",
+				"size": 123456
+			},
+			{ "name": "App.exe", "digest": null, "browser_download_url": "https://example.com/App.exe" },
+			{ "browser_download_url": "https://example.com/SHA256SUMS", "name": "SHA256SUMS" },
+			{ "name": "App.dmg", "digest": "", "browser_download_url": "https://example.com/App.dmg" },
+			[{ "name": "not an asset" }],
+			"not an asset either",
+			42
+		],
+		"body": "Caf\u00e9 \u20ac \ud83d\ude80 \uD83C\uDF89 \u0000 \u0022quoted\u0022 \u005c \u001f, tab:\tnewline:\n, \"\\\/\""
+	},
+	{ "tag_name": "v1.0.0", "draft": true, "prerelease": "true", "assets": [], "body": null, "name": 5, "created_at": { "nested": "object" } },
+	{ "tag_name": "v0.9.0", "assets": { "name": "not an array" }, "html_url": "" },
+	{}
+])";
+
+// Raw UTF-8, as GitHub sends most of the non-ASCII text
+static const QByteArray utf8Json = R"([{ "tag_name": "v0.1.0", "name": ")" "\xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x9A\x80 \xC3\xA9" R"(", "body": ")" "\xF0\x9F\x9A\x80\xC3\xA9" R"(" }])";
+
+static std::string stdString(const QJsonValue& value)
+{
+	return value.toString().toStdString();
+}
+
+// The same fields, read from a QJsonDocument
+static std::optional<std::vector<Release>> referenceReleases(const QByteArray& json)
+{
+	QJsonParseError error;
+	const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+	if (error.error != QJsonParseError::NoError || !document.isArray())
+		return std::nullopt;
+
+	std::vector<Release> releases;
+	for (const QJsonValue& value : document.array())
+	{
+		const QJsonObject object = value.toObject();
+		Release release;
+		release.tagName = stdString(object.value("tag_name"));
+		release.name = stdString(object.value("name"));
+		release.body = stdString(object.value("body"));
+		release.createdAt = stdString(object.value("created_at"));
+		release.htmlUrl = stdString(object.value("html_url"));
+		release.draft = object.value("draft").toBool();
+		release.prerelease = object.value("prerelease").toBool();
+		for (const QJsonValue& assetValue : object.value("assets").toArray())
+		{
+			if (!assetValue.isObject())
+				continue;
+
+			const QJsonObject asset = assetValue.toObject();
+			release.assets.push_back({ stdString(asset.value("name")), stdString(asset.value("browser_download_url")), stdString(asset.value("digest")) });
+		}
+
+		releases.push_back(std::move(release));
+	}
+
+	return releases;
+}
+
+// The releases, nothing unless the document has been parsed to the end without an error
+static std::optional<std::vector<Release>> parseInChunks(const QByteArray& json, size_t chunkSize)
+{
+	std::vector<Release> releases;
+	CReleasesStreamParser parser([&releases](Release&& release) {
+		releases.push_back(std::move(release));
+	});
+
+	const size_t size = static_cast<size_t>(json.size());
+	for (size_t offset = 0; offset < size; offset += chunkSize)
+	{
+		if (!parser.feed(json.constData() + offset, std::min(chunkSize, size - offset)))
+			return std::nullopt;
+	}
+
+	if (!parser.finished())
+		return std::nullopt;
+
+	return releases;
+}
+
+static bool sameAssets(const CReleasesStreamParser::Asset& l, const CReleasesStreamParser::Asset& r)
+{
+	return l.name == r.name && l.browserDownloadUrl == r.browserDownloadUrl && l.digest == r.digest;
+}
+
+static bool sameReleases(const std::optional<std::vector<Release>>& l, const std::optional<std::vector<Release>>& r)
+{
+	if (!l || !r)
+		return false;
+
+	return std::equal(l->begin(), l->end(), r->begin(), r->end(), [](const Release& a, const Release& b) {
+		return a.tagName == b.tagName && a.name == b.name && a.body == b.body && a.createdAt == b.createdAt && a.htmlUrl == b.htmlUrl
+			&& a.draft == b.draft && a.prerelease == b.prerelease && std::equal(a.assets.begin(), a.assets.end(), b.assets.begin(), b.assets.end(), sameAssets);
+	});
+}
+
+// Every chunk size from 1 byte to the whole document: the same releases as QJsonDocument finds
+static bool parsesLikeQJsonDocument(const QByteArray& json)
+{
+	const auto reference = referenceReleases(json);
+	if (!reference || reference->empty())
+		return false;
+
+	for (size_t chunkSize = 1; chunkSize <= static_cast<size_t>(json.size()); ++chunkSize)
+	{
+		if (!sameReleases(parseInChunks(json, chunkSize), reference))
+			return false;
+	}
+
+	return true;
+}
+
+TEST(releasesParserMatchesQJsonDocument)
+{
+	// The fixtures have the digests, a .zsync index and a SHA256SUMS file among the assets, and release notes with escapes
+	const QByteArray fixture = ReleaseFixtures::releasesJson(2);
+	CHECK(parsesLikeQJsonDocument(fixture));
+
+	const auto releases = parseInChunks(fixture, static_cast<size_t>(fixture.size()));
+	CHECK(releases && std::ranges::any_of(*releases, [](const Release& release) {
+		return std::ranges::any_of(release.assets, [](const auto& asset) { return asset.digest.starts_with("sha256:") && asset.digest.size() == 7 + 64; });
+	}));
+}
+
+TEST(releasesParserEdgeCases)
+{
+	CHECK(parsesLikeQJsonDocument(edgeCasesJson));
+	CHECK(parsesLikeQJsonDocument(utf8Json));
+
+	// Spelled out, in case QJsonDocument and the parser agree on something wrong
+	const auto releases = parseInChunks(edgeCasesJson, 1);
+	CHECK(releases && releases->size() == 4);
+	if (!releases || releases->size() != 4)
+		return;
+
+	const Release& release = releases->front();
+	CHECK(release.tagName == "v2.0.0");
+	CHECK(release.name == "Quotes \"and\" back\\slashes / and \b\f\n\r\t");
+	CHECK(release.htmlUrl == "https://github.com/bench/app/releases/tag/v2.0.0");
+	CHECK(!release.draft && release.prerelease);
+	CHECK(release.body == std::string("Caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x9A\x80 \xF0\x9F\x8E\x89 ") + '\0' + " \"quoted\" \\ \x1F, tab:\tnewline:\n, \"\\/\"");
+	CHECK(release.assets.size() == 4);
+	if (release.assets.size() == 4)
+	{
+		CHECK(release.assets[0].name == "App.AppImage");
+		CHECK(release.assets[0].browserDownloadUrl == "https://example.com/App.AppImage");
+		CHECK(release.assets[0].digest == "sha256:0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef");
+		CHECK(release.assets[1].name == "App.exe" && release.assets[1].digest.empty());
+		CHECK(release.assets[2].name == "SHA256SUMS" && release.assets[2].browserDownloadUrl == "https://example.com/SHA256SUMS");
+		CHECK(release.assets[3].browserDownloadUrl == "https://example.com/App.dmg");
+	}
+
+	CHECK((*releases)[1].draft && !(*releases)[1].prerelease && (*releases)[1].name.empty() && (*releases)[1].createdAt.empty());
+	CHECK((*releases)[2].assets.empty());
+}
+
+// Surrogates that aren't part of a pair become U+FFFD, each one, in any chunks
+TEST(releasesParserLoneSurrogates)
+{
+	static const std::pair<const char*, std::string> cases[] {
+		{ R"(\ud83d)", "\xEF\xBF\xBD" },
+		{ R"(\ude80)", "\xEF\xBF\xBD" },
+		{ R"(\ud83dx)", "\xEF\xBF\xBDx" },
+		{ R"(\ud83d\n)", "\xEF\xBF\xBD\n" },
+		{ R"(\ud83dA)", "\xEF\xBF\xBD" "A" },
+		{ R"(\ud83d)" "\xF0\x9F\x9A\x80", "\xEF\xBF\xBD\xF0\x9F\x9A\x80" },
+		{ R"(\ud83d\ud83d\ude80)", "\xEF\xBF\xBD\xF0\x9F\x9A\x80" },
+		{ R"(\ude80\ud83d)", "\xEF\xBF\xBD\xEF\xBF\xBD" },
+	};
+
+	for (const auto& [escaped, expected] : cases)
+	{
+		const QByteArray json = QByteArray(R"([{"body":")") + escaped + R"("}])";
+		for (size_t chunkSize = 1; chunkSize <= static_cast<size_t>(json.size()); ++chunkSize)
+		{
+			const auto releases = parseInChunks(json, chunkSize);
+			CHECK(releases && releases->size() == 1 && releases->front().body == expected);
+		}
+	}
+}
+
+// Any document cut short is not finished, whichever chunks it arrives in
+TEST(releasesParserTruncatedDocument)
+{
+	for (const QByteArray& json : { ReleaseFixtures::releasesJson(1), edgeCasesJson })
+	{
+		const auto documentEnd = json.lastIndexOf(']') + 1;
+		for (qsizetype length = 0; length < documentEnd; ++length)
+		{
+			CReleasesStreamParser parser([](Release&&) {});
+			(void)parser.feed(json.constData(), static_cast<size_t>(length));
+			CHECK(!parser.finished());
+			CHECK(!parseInChunks(json.left(length), 7));
+		}
+	}
+}
+
+// Malformed documents are errors, in any chunks: the parser stops, and the releases before the error (in most of these) are not a result
+TEST(releasesParserMalformedDocument)
+{
+	static const char* const documents[] {
+		R"({"message":"Not Found","documentation_url":"https://docs.github.com/rest"})",
+		R"("releases")",
+		R"(42)",
+		R"([{"tag_name":"v1"}]])",
+		R"([{"tag_name":"v1"}] [])",
+		R"([{"tag_name":"v1"}],)",
+		R"([{"tag_name":"v1"]])",
+		R"([{"tag_name":"v1"}})",
+		R"([{"tag_name" "v1"}])",
+		R"([{"tag_name":"v1",}])",
+		R"([{"tag_name":"v1"},])",
+		R"([{,"tag_name":"v1"}])",
+		R"([{"tag_name":}])",
+		R"([{tag_name:"v1"}])",
+		R"([{'tag_name':'v1'}])",
+		R"([{"tag_name":"v1"}{"tag_name":"v2"}])",
+		R"([{"draft":tru}])",
+		R"([{"draft":True}])",
+		R"([{"draft":nul}])",
+		R"([{"draft":truefalse}])",
+		R"([{"size":01}])",
+		R"([{"size":1.}])",
+		R"([{"size":.5}])",
+		R"([{"size":-}])",
+		R"([{"size":1e}])",
+		R"([{"size":1e+}])",
+		R"([{"size":1x}])",
+		R"([{"size":+1}])",
+		R"([{"size":0x10}])",
+		R"([{"body":"\x"}])",
+		R"([{"body":"\u12G4"}])",
+		R"([{"body":"\U1234"}])",
+		R"([{"body":"a)" "\n" R"(b"}])",
+		R"([{"body":"a)" "\t" R"(b"}])",
+	};
+
+	for (const char* document : documents)
+	{
+		const QByteArray json(document);
+		for (size_t chunkSize = 1; chunkSize <= static_cast<size_t>(json.size()); ++chunkSize)
+			CHECK(!parseInChunks(json, chunkSize));
+
+		CReleasesStreamParser parser([](Release&&) {});
+		CHECK(!parser.feed(document, strlen(document)) && parser.hasError());
+	}
+}
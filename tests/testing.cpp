@@ -0,0 +1,59 @@
+#include "testing.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+struct Test {
+	const char* name;
+	Testing::TestFunction function;
+};
+
+// Function-local, so that it's there for the registrations from every translation unit, whatever the order of their initialization
+static std::vector<Test>& tests()
+{
+	static std::vector<Test> registeredTests;
+	return registeredTests;
+}
+
+static int failedChecks = 0; // In the current test
+
+Testing::Registration::Registration(const char* name, TestFunction function)
+{
+	tests().push_back({ name, function });
+}
+
+bool Testing::check(bool condition, const char* expression, const char* file, int line)
+{
+	if (!condition)
+	{
+		++failedChecks;
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+	}
+
+	return condition;
+}
+
+int Testing::runTests(const char* filter)
+{
+	int failedTests = 0, testsRun = 0;
+	for (const Test& test : tests())
+	{
+		if (filter && *filter && !::strstr(test.name, filter))
+			continue;
+
+		failedChecks = 0;
+		test.function();
+		const bool passed = failedChecks == 0;
+
+		++testsRun;
+		if (!passed)
+			++failedTests;
+
+		printf("%s %s\n", passed ? "PASS" : "FAIL", test.name);
+		fflush(stdout);
+	}
+
+	printf("%d tests, %d failed\n", testsRun, failedTests);
+	return failedTests;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// A minimal test harness: the tests register themselves with TEST(), a failed CHECK() is reported with its location and the test goes on
+namespace Testing {
+
+using TestFunction = void (*)();
+
+struct Registration {
+	Registration(const char* name, TestFunction function);
+};
+
+bool check(bool condition, const char* expression, const char* file, int line);
+
+// Runs the tests whose name contains filter (all of them for an empty one), returns the number of failed ones
+[[nodiscard]] int runTests(const char* filter);
+
+} // namespace Testing
+
+#define TEST(name) \
+	static void name(); \
+	static const Testing::Registration name##Registration(#name, name); \
+	static void name()
+
+#define CHECK(condition) Testing::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,110 @@
+TARGET = autoupdater-tests
+TEMPLATE = app
+
+QT = core network
+# The macOS installer uses QApplication
+mac*:QT += widgets
+
+CONFIG += console strict_c++
+CONFIG -= app_bundle
+exists(../../global.pri){
+	include(../../global.pri)
+} else {
+	CONFIG += c++2b
+}
+
+mac* | linux* | freebsd{
+	CONFIG(release, debug|release):CONFIG *= Release optimize_full
+	CONFIG(debug, debug|release):CONFIG *= Debug
+}
+
+contains(QT_ARCH, x86_64) {
+	ARCHITECTURE = x64
+} else {
+	ARCHITECTURE = x86
+}
+
+Release:OUTPUT_DIR=release/$${ARCHITECTURE}
+Debug:OUTPUT_DIR=debug/$${ARCHITECTURE}
+
+DESTDIR     = ../bin/$${OUTPUT_DIR}
+OBJECTS_DIR = ../build/$${OUTPUT_DIR}/$${TARGET}
+MOC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+UI_DIR      = ../build/$${OUTPUT_DIR}/$${TARGET}
+RCC_DIR     = ../build/$${OUTPUT_DIR}/$${TARGET}
+
+DEFINES += QT_MESSAGELOGCONTEXT
+
+INCLUDEPATH += \
+	$${PWD}/../3rdparty \
+	$${PWD}/../src \
+	$${PWD}/../bench
+
+win*{
+	QMAKE_CXXFLAGS += /MP /Zi /wd4251
+	QMAKE_CXXFLAGS += /std:c++latest /permissive- /Zc:__cplusplus
+	QMAKE_CXXFLAGS_WARN_ON = /W4
+	DEFINES += WIN32_LEAN_AND_MEAN NOMINMAX
+}
+
+mac* | linux* | freebsd{
+	QMAKE_CXXFLAGS += -pedantic-errors
+	QMAKE_CXXFLAGS_WARN_ON = -Wall
+
+	Release:DEFINES += NDEBUG=1
+	Debug:DEFINES += _DEBUG
+}
+
+# The updater core is built in, without the UI, like in the benchmark
+HEADERS += \
+	../src/cautoupdatergithub.h \
+	../src/cdeltapatcher.h \
+	../src/cdownloadfilewriter.h \
+	../src/cdownloadjournal.h \
+	../src/cdownloadprogressthrottle.h \
+	../src/creleasecache.h \
+	../src/creleasesstreamparser.h \
+	../src/csegmenteddownload.h \
+	../src/czsyncindex.h \
+	../src/cversionkey.h \
+	../src/deltagenerator.hpp \
+	../src/updateinstaller.hpp \
+	../bench/cmockgithubserver.h \
+	../bench/releasefixtures.hpp \
+	testing.hpp
+
+SOURCES += \
+	../src/cautoupdatergithub.cpp \
+	../src/cdeltapatcher.cpp \
+	../src/cdownloadfilewriter.cpp \
+	../src/cdownloadjournal.cpp \
+	../src/cdownloadprogressthrottle.cpp \
+	../src/creleasecache.cpp \
+	../src/creleasesstreamparser.cpp \
+	../src/csegmenteddownload.cpp \
+	../src/czsyncindex.cpp \
+	../src/cversionkey.cpp \
+	../src/deltagenerator.cpp \
+	../bench/cmockgithubserver.cpp \
+	../bench/releasefixtures.cpp \
+	deltapatchertests.cpp \
+	downloadtests.cpp \
+	main.cpp \
+	maddyblockparsertests.cpp \
+	maddyinlineparsertests.cpp \
+	progressthrottletests.cpp \
+	releasesstreamparsertests.cpp \
+	testing.cpp \
+	updatechecktests.cpp \
+	versionkeytests.cpp
+
+win*:SOURCES += ../src/updateinstaller_win.cpp
+mac*:SOURCES += ../src/updateinstaller_mac.cpp
+linux* | freebsd:SOURCES += ../src/updateinstaller_linux.cpp
+
+unix {
+	HEADERS += ../src/cdirectorycopier.h
+	SOURCES += \
+		../src/cdirectorycopier.cpp \
+		directorycopiertests.cpp
+}
@@ -0,0 +1,339 @@
+#include "cautoupdatergithub.h"
+#include "cmockgithubserver.h"
+#include "releasefixtures.hpp"
+#include "testing.hpp"
+
+DISABLE_COMPILER_WARNINGS
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QTimer>
+RESTORE_COMPILER_WARNINGS
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+static constexpr int checkTimeoutMs = 30'000;
+
+static QString releaseCacheFilePath()
+{
+	return QDir::tempPath() + '/' + QCoreApplication::applicationName() + "-releases.cache";
+}
+
+// One update check against the server, configured through updater() before run()
+class UpdateCheck final : public CAutoUpdaterGithub::UpdateStatusListener
+{
+public:
+	UpdateCheck(CMockGithubServer& server, const char* currentVersion, const QString& cacheFilePath = {},
+				const std::function<bool (const QString&, const QString&)>& versionComparatorLessThan = {}) :
+		_updater(ReleaseFixtures::repositoryName, QString::fromLatin1(currentVersion), versionComparatorLessThan)
+	{
+		_updater.setUpdateStatusListener(this);
+		_updater.setApiBaseUrl(server.baseUrl());
+		_updater.setReleaseCacheFilePath(cacheFilePath);
+	}
+
+	CAutoUpdaterGithub& updater()
+	{
+		return _updater;
+	}
+
+	// The newer releases, nothing if the check has failed
+	std::optional<CAutoUpdaterGithub::ChangeLog> run()
+	{
+		QTimer timeout;
+		timeout.setSingleShot(true);
+		QObject::connect(&timeout, &QTimer::timeout, &_loop, [this] { onUpdateError("Timed out"); });
+		timeout.start(checkTimeoutMs);
+		_updater.checkForUpdates();
+		_loop.exec();
+		return std::exchange(_changelog, std::nullopt);
+	}
+
+	void onUpdateAvailable(const CAutoUpdaterGithub::ChangeLog& changelog) override
+	{
+		_changelog = changelog;
+		_loop.quit();
+	}
+
+	void onUpdateDownloadProgress(float) override {}
+	void onUpdateDownloadFinished() override {}
+
+	void onUpdateError(const QString&) override
+	{
+		_changelog.reset();
+		_loop.quit();
+	}
+
+private:
+	CAutoUpdaterGithub _updater;
+	QEventLoop _loop;
+	std::optional<CAutoUpdaterGithub::ChangeLog> _changelog;
+};
+
+static std::optional<CAutoUpdaterGithub::ChangeLog> checkForUpdates(CMockGithubServer& server, const char* currentVersion, const QString& cacheFilePath = {}, int orderedFeedStopThreshold = 0)
+{
+	UpdateCheck check(server, currentVersion, cacheFilePath);
+	check.updater().setOrderedFeedStopThreshold(orderedFeedStopThreshold);
+	return check.run();
+}
+
+// Everything the updater takes from the releases list
+static bool sameReleases(const std::optional<CAutoUpdaterGithub::ChangeLog>& l, const std::optional<CAutoUpdaterGithub::ChangeLog>& r)
+{
+	if (!l || !r || l->size() != r->size())
+		return false;
+
+	for (size_t i = 0; i < l->size(); ++i)
+	{
+		const auto& a = (*l)[i];
+		const auto& b = (*r)[i];
+		if (a.versionString != b.versionString || a.versionChanges != b.versionChanges || a.date != b.date || a.versionUpdateUrl != b.versionUpdateUrl
+			|| a.isPrerelease != b.isPrerelease || a.releaseTitle != b.releaseTitle || a.updateSha256 != b.updateSha256
+			|| a.updateChecksumsUrl != b.updateChecksumsUrl || a.deltaUpdateUrls != b.deltaUpdateUrls || a.zsyncUrl != b.zsyncUrl)
+			return false;
+	}
+
+	return true;
+}
+
+// The status of the only request since the log was last cleared, 0 if there were more or none
+static int onlyRequestStatus(CMockGithubServer& server)
+{
+	const auto& log = server.requestLog();
+	const int status = log.size() == 1 ? log.front().status : 0;
+	server.clearRequestLog();
+	return status;
+}
+
+// The second check is answered with 304 and gets the same changelog from the cache, and so does a check with another current version
+TEST(releaseCacheAnswersNotModified)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.setReleasesJson(ReleaseFixtures::releasesJson(30));
+	QFile::remove(releaseCacheFilePath());
+
+	const auto fresh = checkForUpdates(server, ReleaseFixtures::oldestVersion, releaseCacheFilePath());
+	CHECK(fresh && fresh->size() == 29);
+	CHECK(onlyRequestStatus(server) == 200);
+
+	const auto cached = checkForUpdates(server, ReleaseFixtures::oldestVersion, releaseCacheFilePath());
+	CHECK(onlyRequestStatus(server) == 304);
+	CHECK(sameReleases(cached, fresh));
+
+	// The cache holds the whole list, the releases newer than another version are all in it
+	const auto cachedForNewerVersion = checkForUpdates(server, "0.1.5", releaseCacheFilePath());
+	CHECK(onlyRequestStatus(server) == 304);
+	CHECK(cachedForNewerVersion && cachedForNewerVersion->size() == 15);
+	CHECK(sameReleases(cachedForNewerVersion, checkForUpdates(server, "0.1.5")));
+
+	QFile::remove(releaseCacheFilePath());
+}
+
+// The ordered feed mode stops the check early: the cached list is only reused by a check that would stop in the same place.
+// With an older current version, the releases it misses would be missing from the changelog.
+TEST(truncatedReleaseCacheNotReusedForOtherVersion)
+{
+	static constexpr int stopThreshold = 3;
+
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.setReleasesJson(ReleaseFixtures::releasesJson(30));
+	QFile::remove(releaseCacheFilePath());
+
+	const auto fresh = checkForUpdates(server, "0.2.0", releaseCacheFilePath(), stopThreshold);
+	CHECK(fresh && fresh->size() == 10);
+	CHECK(onlyRequestStatus(server) == 200);
+
+	const auto cached = checkForUpdates(server, "0.2.0", releaseCacheFilePath(), stopThreshold);
+	CHECK(onlyRequestStatus(server) == 304);
+	CHECK(sameReleases(cached, fresh));
+
+	const auto olderVersion = checkForUpdates(server, "0.1.0", releaseCacheFilePath(), stopThreshold);
+	CHECK(onlyRequestStatus(server) == 200);
+	CHECK(olderVersion && olderVersion->size() == 20);
+	CHECK(sameReleases(olderVersion, checkForUpdates(server, "0.1.0")));
+
+	// The full list is cached regardless of the version
+	server.clearRequestLog();
+	CHECK(checkForUpdates(server, "0.1.0", releaseCacheFilePath()));
+	CHECK(onlyRequestStatus(server) == 200);
+	CHECK(sameReleases(checkForUpdates(server, "0.2.0", releaseCacheFilePath(), stopThreshold), fresh));
+	CHECK(onlyRequestStatus(server) == 304);
+
+	QFile::remove(releaseCacheFilePath());
+}
+
+// A releases list that is cut short or malformed fails the check, the releases parsed before the end or the error are not a changelog
+TEST(malformedReleasesListIsAnError)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+
+	const QByteArray json = ReleaseFixtures::releasesJson(10);
+	const auto secondRelease = json.indexOf(R"(,{"url")");
+	CHECK(secondRelease > 0);
+
+	for (const QByteArray& body : { json.left(json.size() - 1), json.left(secondRelease + 1), json.left(json.size() / 2), json + ']', json + ",{}]",
+			json.left(secondRelease) + "}" + json.mid(secondRelease), json.left(secondRelease) + ",," + json.mid(secondRelease + 1), QByteArray{} })
+	{
+		server.setReleasesJson(body);
+		CHECK(!checkForUpdates(server, ReleaseFixtures::oldestVersion));
+	}
+
+	server.setReleasesJson(json);
+	CHECK(checkForUpdates(server, ReleaseFixtures::oldestVersion));
+}
+
+static std::optional<CAutoUpdaterGithub::ChangeLog> checkForUpdatesInPages(CMockGithubServer& server, const char* currentVersion, int releasesPerPage)
+{
+	UpdateCheck check(server, currentVersion);
+	check.updater().setReleasesPageSize(releasesPerPage);
+	return check.run();
+}
+
+// The queries of the requests since the log was last cleared
+static std::vector<QString> requestedQueries(CMockGithubServer& server)
+{
+	std::vector<QString> queries;
+	for (const auto& request : server.requestLog())
+		queries.push_back(request.query);
+
+	server.clearRequestLog();
+	return queries;
+}
+
+// 30 releases in pages of 10, with the Link headers to follow. The newest release is the current version: the first page has older
+// releases on it already, nothing else is requested.
+TEST(paginationUpToDateRequestsOnePage)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.setReleasesJson(ReleaseFixtures::releasesJson(30));
+
+	const auto changelog = checkForUpdatesInPages(server, ReleaseFixtures::newestVersion(30).c_str(), 10);
+	CHECK(changelog && changelog->empty());
+	CHECK(requestedQueries(server) == std::vector<QString>{ "per_page=10" });
+}
+
+// The oldest release is the current version: every page is followed, and the changelog is the whole list, newest first
+TEST(paginationFarBehindFollowsEveryPage)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.setReleasesJson(ReleaseFixtures::releasesJson(30));
+
+	const auto changelog = checkForUpdatesInPages(server, ReleaseFixtures::oldestVersion, 10);
+	CHECK((requestedQueries(server) == std::vector<QString>{ "per_page=10", "per_page=10&page=2", "per_page=10&page=3" }));
+	CHECK(changelog && changelog->size() == 29);
+	CHECK(sameReleases(changelog, checkForUpdates(server, ReleaseFixtures::oldestVersion)));
+	CHECK(changelog && std::is_sorted(changelog->begin(), changelog->end(), [](const auto& l, const auto& r) {
+		return CVersionKey(r.versionString) < CVersionKey(l.versionString);
+	}));
+}
+
+// The current version is in the middle of the second page: the check stops after that page, the third one is not requested
+TEST(paginationStopsAfterPageWithOlderRelease)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.setReleasesJson(ReleaseFixtures::releasesJson(30));
+
+	const auto changelog = checkForUpdatesInPages(server, "0.1.5", 10);
+	CHECK((requestedQueries(server) == std::vector<QString>{ "per_page=10", "per_page=10&page=2" }));
+	CHECK(changelog && changelog->size() == 15);
+	CHECK(sameReleases(changelog, checkForUpdates(server, "0.1.5")));
+}
+
+// A releases list with a release of every version, in this order, tagged v<version>
+static QByteArray releasesJson(const std::vector<std::string>& versions)
+{
+	QByteArray json = "[";
+	for (const auto& version : versions)
+	{
+		if (json.size() > 1)
+			json += ',';
+
+		const QByteArray release = ReleaseFixtures::releaseJson(version, {});
+		json += release.mid(1, release.size() - 2); // Without the array brackets
+	}
+
+	return json + ']';
+}
+
+static std::vector<QString> versionStrings(const std::optional<CAutoUpdaterGithub::ChangeLog>& changelog)
+{
+	std::vector<QString> versions;
+	if (changelog)
+	{
+		for (const auto& entry : *changelog)
+			versions.push_back(entry.versionString);
+	}
+
+	return versions;
+}
+
+// The v prefix is removed from the tags, the versions are compared as numbers and pre-releases are older than the release
+TEST(newerReleasesSelectedByVersionKey)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+
+	server.setReleasesJson(releasesJson({ "0.1.10", "0.1.9", "0.1.2" }));
+	CHECK((versionStrings(checkForUpdates(server, "0.1.9")) == std::vector<QString>{ "0.1.10" }));
+	CHECK((versionStrings(checkForUpdates(server, "0.1.2")) == std::vector<QString>{ "0.1.10", "0.1.9" }));
+
+	server.setReleasesJson(releasesJson({ "1.0.0", "1.0.0-rc.2", "1.0.0-rc.1", "1.0.0-beta", "0.9.0" }));
+	CHECK((versionStrings(checkForUpdates(server, "1.0.0-rc.1")) == std::vector<QString>{ "1.0.0", "1.0.0-rc.2" }));
+	CHECK(versionStrings(checkForUpdates(server, "1.0.0+build.7")).empty());
+	CHECK(versionStrings(checkForUpdates(server, "1.0.0")).empty());
+
+	// The cached list, with the keys built from it again, gives the same answer
+	QFile::remove(releaseCacheFilePath());
+	CHECK(checkForUpdates(server, "0.9.0", releaseCacheFilePath()));
+	server.clearRequestLog();
+	CHECK((versionStrings(checkForUpdates(server, "1.0.0-rc.1", releaseCacheFilePath())) == std::vector<QString>{ "1.0.0", "1.0.0-rc.2" }));
+	CHECK(onlyRequestStatus(server) == 304);
+	QFile::remove(releaseCacheFilePath());
+}
+
+// Version strings that CVersionKey can't parse are compared with natural sorting: nightly-10 is newer than nightly-9
+TEST(unparsableVersionsFallBackToNaturalSorting)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.setReleasesJson(releasesJson({ "nightly-10", "nightly-9", "nightly-2" }));
+
+	CHECK((versionStrings(checkForUpdates(server, "nightly-9")) == std::vector<QString>{ "nightly-10" }));
+	CHECK((versionStrings(checkForUpdates(server, "nightly-2")) == std::vector<QString>{ "nightly-10", "nightly-9" }));
+}
+
+// A custom comparator replaces CVersionKey entirely, and gets the current version and the release's version without the v prefix
+TEST(customVersionComparatorUsed)
+{
+	CMockGithubServer server(ReleaseFixtures::repositoryName);
+	CHECK(server.start());
+	server.setReleasesJson(releasesJson({ "0.3.0", "0.2.0", "0.1.0" }));
+
+	// Backwards: the older releases are the "newer" ones
+	std::atomic<int> calls{ 0 };
+	std::atomic<bool> unexpectedArguments{ false };
+	UpdateCheck check(server, "0.2.0", {}, [&](const QString& l, const QString& r) {
+		++calls;
+		if (l != "0.2.0" || r.startsWith('v'))
+			unexpectedArguments = true;
+
+		return CVersionKey(r) < CVersionKey(l);
+	});
+
+	CHECK((versionStrings(check.run()) == std::vector<QString>{ "0.1.0" }));
+	CHECK(calls > 0);
+	CHECK(!unexpectedArguments);
+}
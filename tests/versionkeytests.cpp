@@ -0,0 +1,93 @@
+#include "cversionkey.h"
+#include "testing.hpp"
+
+#include <vector>
+
+struct VersionPair {
+	const char* lower;
+	const char* higher;
+};
+
+// Both ways round, through compare() and operator<
+static bool ordered(const VersionPair& pair)
+{
+	const CVersionKey lower(QString::fromLatin1(pair.lower)), higher(QString::fromLatin1(pair.higher));
+	return lower.isValid() && higher.isValid() && lower < higher && !(higher < lower) && lower.compare(higher) < 0 && higher.compare(lower) > 0;
+}
+
+static bool equivalent(const VersionPair& pair)
+{
+	const CVersionKey l(QString::fromLatin1(pair.lower)), r(QString::fromLatin1(pair.higher));
+	return l.isValid() && r.isValid() && l.compare(r) == 0 && r.compare(l) == 0 && !(l < r) && !(r < l);
+}
+
+// The segments are numbers, not strings: 1.10 is newer than 1.9
+TEST(versionKeyNumericSegments)
+{
+	static const std::vector<VersionPair> pairs {
+		{ "1.9", "1.10" },
+		{ "1.9.9", "1.10.0" },
+		{ "0.9", "10.0" },
+		{ "2.0.9", "2.0.10" },
+		{ "1.2.3", "1.2.3.1" },
+		{ "1.2", "1.2.1" },
+		{ "99999999999999999999", "99999999999999999999.1" }, // Too large for 64 bits, saturates
+	};
+
+	for (const auto& pair : pairs)
+		CHECK(ordered(pair));
+
+	// Missing trailing segments count as 0
+	CHECK(equivalent({ "1.2", "1.2.0" }));
+	CHECK(equivalent({ "1", "1.0.0.0" }));
+	CHECK(equivalent({ "01.002", "1.2" }));
+}
+
+// A release is newer than any of its pre-releases, and the pre-releases are ordered by the semver rules
+TEST(versionKeyPrereleases)
+{
+	static const std::vector<VersionPair> pairs {
+		{ "1.0.0-rc.1", "1.0.0" },
+		{ "1.0.0-alpha", "1.0.0-alpha.1" },
+		{ "1.0.0-alpha.1", "1.0.0-alpha.beta" },
+		{ "1.0.0-alpha.beta", "1.0.0-beta" },
+		{ "1.0.0-beta", "1.0.0-beta.2" },
+		{ "1.0.0-beta.2", "1.0.0-beta.11" },
+		{ "1.0.0-beta.11", "1.0.0-rc.1" },
+		{ "1.0.0-RC.1", "1.0.0-rc.2" },
+		{ "0.9.9", "1.0.0-alpha" },
+		{ "1.0.0", "1.0.1-alpha" },
+		// The forms projects tag their pre-releases with besides semver's
+		{ "2.0rc1", "2.0rc2" },
+		{ "2.0rc2", "2.0" },
+		{ "2.0-beta-3", "2.0-beta-4" },
+		{ "2.0beta", "2.0rc" },
+	};
+
+	for (const auto& pair : pairs)
+		CHECK(ordered(pair));
+
+	CHECK(equivalent({ "1.0.0-rc.1", "1.0.0-RC.1" }));
+	CHECK(equivalent({ "1.0.0-rc.1", "1.0.0rc1" }));
+}
+
+// Build metadata doesn't take part in the comparison
+TEST(versionKeyBuildMetadataIgnored)
+{
+	CHECK(equivalent({ "1.0.0+build.5", "1.0.0" }));
+	CHECK(equivalent({ "1.0.0+20261018", "1.0.0+20250101" }));
+	CHECK(equivalent({ "1.0.0-rc.1+exp.sha.5114f85", "1.0.0-rc.1" }));
+	CHECK(ordered({ "1.0.0-rc.1+build.9", "1.0.0+build.1" }));
+	CHECK(ordered({ "1.0.0+build.9", "1.0.1+build.1" }));
+}
+
+// A version string that doesn't start with a number can't be parsed: the updater falls back to natural sorting or to its comparator.
+// The v prefix of the tags is removed before the versions get here.
+TEST(versionKeyInvalid)
+{
+	for (const char* version : { "", "nightly", "nightly-20261018", "v1.2.3", ".v1.2.3", "-1.0", "+1.0" })
+		CHECK(!CVersionKey(QString::fromLatin1(version)).isValid());
+
+	for (const char* version : { "0", "1.2.3", "1.2.3-rc.1", "2.0rc1", "1.0.0+build" })
+		CHECK(CVersionKey(QString::fromLatin1(version)).isValid());
+}